@@ -21,12 +21,13 @@
 #include "LoudnessFrameProcessor.h"
 #include <libaudcore/plugin.h>
 
+/*
+ * Runs the detection over the audio in the buffer it arrives in; nothing is
+ * copied apart from the frames that pass through the look-ahead delay line.
+ */
 class FrameBasedEffectPlugin : public EffectPlugin
 {
-    Index<audio_sample> frame_in;
-    Index<audio_sample> frame_out;
-    Index<audio_sample> output;
-    int current_channels = 0, current_rate = 0, channel_last_read = 0;
+    int current_channels = 0, current_rate = 0;
     LoudnessFrameProcessor detection;
 
 public:
@@ -43,22 +44,14 @@ public:
         return true;
     }
 
-    void cleanup() final
-    {
-        output.clear();
-        frame_in.clear();
-        frame_out.clear();
-    }
+    void cleanup() final {}
 
     void start(int & channels, int & rate) final
     {
         current_channels = channels;
         current_rate = rate;
-        channel_last_read = 0;
 
         detection.start(channels, rate);
-        frame_in.resize(current_channels);
-        frame_out.resize(current_channels);
 
         flush(false);
     }
@@ -67,29 +60,12 @@ public:
     {
         detection.update_config();
 
-        int output_samples = 0;
-        output.resize(0);
-
-        // It is assumed data always contains a multiple of channels, but we
-        // don't care.
-        for (const audio_sample sample : data)
-        {
-            frame_in[channel_last_read++] = sample;
-            if (channel_last_read == current_channels)
-            {
-                // Processing happens per frame. Because of read-ahead there is
-                // not always output available yet.
-                if (detection.process_has_output(frame_in, frame_out))
-                {
-                    output.move_from(frame_out, 0, output_samples,
-                                     current_channels, true, false);
-                    output_samples += current_channels;
-                }
-                channel_last_read = 0;
-            }
-        }
+        // Audio always comes in whole frames.
+        const int frames = data.len() / current_channels;
+        const int output_frames = detection.process(data.begin(), frames);
+        data.resize(output_frames * current_channels);
 
-        return output;
+        return data;
     }
 
     bool flush(bool force) final
@@ -22,8 +22,8 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
-#include <libaudcore/ringbuf.h>
 #include <libaudcore/audio.h>
+#include <libaudcore/index.h>
 
 /**
  * Tools to detect perceived loudness.
@@ -58,7 +58,12 @@ struct Loudness
             1, static_cast<int>(roundf(seconds * static_cast<float>(rate))));
     }
 
-    static Metrics get_metrics(const int step, const int of, const int rate)
+    /**
+     * Returns the window for a step, where the prediction is the look-ahead
+     * in seconds, at most max_prediction.
+     */
+    static Metrics get_metrics(const int step, const int of, const int rate,
+                               const float prediction = max_prediction)
     {
         static constexpr float peak_perception_ratio =
             perception_fast_seconds / perception_center_seconds;
@@ -70,8 +75,8 @@ struct Loudness
         const float seconds =
             perception_center_seconds * powf(peak_perception_ratio, log_ratio);
 
-        const float latency =
-            std::min(seconds * window_percentage, max_prediction);
+        const float latency = std::min(seconds * window_percentage,
+                                       std::min(prediction, max_prediction));
 
         return {get_samples(seconds, rate), get_samples(latency, rate),
                 get_weight(seconds)};
@@ -81,63 +86,59 @@ struct Loudness
 class PerceptiveRMS
 {
     static constexpr int STEPS = 24;
+    static constexpr int WINDOWS = STEPS + 1;
     static constexpr float INPUT_SCALE = 4e9f;
     static constexpr float OUTPUT_SCALE = 1.0f / INPUT_SCALE;
 
-    class WindowedRMS
-    {
-        uint64_t window_sum_ = 0;
-        int window_size_ = 0;
-        int latency_minus_one = 0;
-        float scale_ = 0.0;
-        float output_ = 0.0;
-
-    public:
-
-        audio_sample add_and_take_and_get(uint64_t add, uint64_t take)
-        {
-            window_sum_ += add;
-            window_sum_ -= take;
-            const auto sum = static_cast<audio_sample>(window_sum_);
-            output_ = scale_ * sum;
-            return output_;
-        }
+    /*
+     * The running sums of all windows are kept as structure-of-arrays, so
+     * that updating them for a new sample is a loop the compiler can
+     * vectorize. Each window adds the new sample and takes out the one that
+     * came in delays_ samples ago. The history is stored twice in a row, so
+     * that any sample up to latency_ ago is a plain indexed load.
+     */
+    uint64_t window_sums_[WINDOWS] = {};
+    int delays_[WINDOWS] = {};
+    float scales_[WINDOWS] = {};
+    Index<uint64_t> history_;
+    int history_size_ = 0;
+    int history_pos_ = 0;
 
-        void configure(const Loudness::Metrics & metrics)
-        {
-            window_size_ = metrics.window_samples;
-            latency_minus_one = std::max(0, metrics.latency_samples - 1);
-            scale_ = metrics.weight * metrics.weight /
-                     static_cast<float>(window_size_);
-            window_sum_ = 0;
-            output_ = 0;
-        }
-
-        [[nodiscard]] int delayed_sample_index() const
-        {
-            return latency_minus_one;
-        }
-    };
-
-    RingBuf<uint64_t> buffer_;
-    WindowedRMS rms_[STEPS + 1];
     int sample_rate_ = 0;
+    float prediction_ = 0;
     int latency_ = 0;
     FastAttackSmoothRelease smooth_release_;
     const float peak_weight_ = Loudness::get_weight(0.0);
 
     void init_detection()
     {
-        const auto max_metrics = Loudness::get_metrics(0, STEPS, sample_rate_);
+        const auto max_metrics =
+            Loudness::get_metrics(0, STEPS, sample_rate_, prediction_);
         latency_ = max_metrics.latency_samples;
         smooth_release_.set_samples(max_metrics.window_samples,
                                     max_metrics.window_samples);
 
         for (int step = 0; step <= STEPS; step++)
         {
-            rms_[step].configure(
-                Loudness::get_metrics(step, STEPS, sample_rate_));
+            const auto metrics =
+                Loudness::get_metrics(step, STEPS, sample_rate_, prediction_);
+            window_sums_[step] = 0;
+            delays_[step] = std::max(0, metrics.latency_samples - 1);
+            scales_[step] = metrics.weight * metrics.weight /
+                            static_cast<float>(metrics.window_samples);
+        }
+        /*
+         * The widest window takes out the sample that leaves the look-ahead.
+         */
+        delays_[0] = latency_;
+
+        history_size_ = latency_ + 1;
+        history_.resize(2 * history_size_);
+        for (uint64_t & value : history_)
+        {
+            value = 0;
         }
+        history_pos_ = 0;
     }
 
     [[nodiscard]] uint64_t static squared_value_to_internal_value(
@@ -148,17 +149,16 @@ class PerceptiveRMS
     }
 
 public:
-    void set_rate_and_value(int sample_rate, audio_sample squared_initial_value)
+    void set_rate_and_value(int sample_rate, float prediction,
+                            audio_sample squared_initial_value)
     {
-        if (sample_rate_ == sample_rate)
+        if (sample_rate_ == sample_rate && prediction_ == prediction)
         {
             return;
         }
         sample_rate_ = sample_rate;
+        prediction_ = prediction;
         init_detection();
-        buffer_.discard();
-        buffer_.alloc(latency_);
-        buffer_.fill_with(0);
 
         for (int i = 0; i <= latency_; i++)
         {
@@ -172,20 +172,32 @@ public:
     {
         const uint64_t internal_value =
             squared_value_to_internal_value(squared_input);
-        const uint64_t oldest = buffer_.pop();
-        buffer_.push(internal_value);
 
-        audio_sample max = rms_[0].add_and_take_and_get(internal_value, oldest);
-        max = std::max(max, static_cast<audio_sample>(internal_value) * peak_weight_);
+        if (++history_pos_ == history_size_)
+        {
+            history_pos_ = 0;
+        }
+        history_[history_pos_] = internal_value;
+        history_[history_pos_ + history_size_] = internal_value;
+
+        /* recent[-n] is the sample of n calls ago */
+        const uint64_t * recent =
+            history_.begin() + history_pos_ + history_size_;
+
+        for (int step = 0; step < WINDOWS; step++)
+        {
+            window_sums_[step] += internal_value;
+            window_sums_[step] -= recent[-delays_[step]];
+        }
+
+        audio_sample max =
+            static_cast<audio_sample>(internal_value) * peak_weight_;
 
-        for (int step = 1; step <= STEPS; step++)
+        for (int step = 0; step < WINDOWS; step++)
         {
-            WindowedRMS & rms = rms_[step];
-            const auto delayed_input =
-                buffer_.nth_from_last(rms.delayed_sample_index());
-            const auto step_value =
-                rms.add_and_take_and_get(internal_value, delayed_input);
-            max = std::max(max, step_value);
+            const audio_sample value =
+                scales_[step] * static_cast<audio_sample>(window_sums_[step]);
+            max = std::max(max, value);
         }
         max *= OUTPUT_SCALE;
         return smooth_release_.get_envelope(max);
@@ -18,6 +18,7 @@
  * implied. In no event shall the authors be liable for any damages arising from
  * the use of this software.
  */
+#include "../loudness-common/loudness.h"
 #include "Integrator.h"
 #include "Loudness.h"
 #include "basic_config.h"
@@ -42,9 +43,24 @@ class LoudnessFrameProcessor
     float target_level = 0.1;
     float maximum_amplification = 1;
     float perception_slow_balance = 0.3;
+    float look_ahead = Loudness::max_prediction;
     audio_sample minimum_detection = 1e-6;
-    RingBuf<audio_sample> read_ahead_buffer;
+    /*
+     * The look-ahead delay line. Each incoming frame is swapped with the one
+     * that came in latency() frames ago, so the audio is delayed in place.
+     */
+    Index<audio_sample> delay_line;
+    int delay_position = 0;
+    /*
+     * Optionally, detection looks at the signal through the K-weighting
+     * filter of ITU-R BS.1770, the one used for EBU R128 and ReplayGain 2.0,
+     * which weighs bass down and presence up roughly as the ear does.
+     */
+    bool k_weighting = false;
+    KFilter k_filter;
+    Index<audio_sample> k_frame;
     int channels_ = 0;
+    int rate_ = 0;
     int processed_frames = 0;
 
     static float get_clamped_value(const char * variable, const double minimum,
@@ -63,6 +79,44 @@ class LoudnessFrameProcessor
         return powf(10.0f, 0.05f * decibels);
     }
 
+    void start_look_ahead()
+    {
+        perceivedLoudness.set_rate_and_value(rate_, look_ahead, target_level);
+        delay_line.resize(channels_ * latency());
+        flush();
+    }
+
+    audio_sample get_gain(const audio_sample * frame)
+    {
+        if (k_weighting)
+        {
+            k_filter.process(frame, k_frame.begin(), 1);
+            frame = k_frame.begin();
+        }
+
+        audio_sample square_sum = 0.0;
+        audio_sample square_max = 0.0;
+        for (int channel = 0; channel < channels_; channel++)
+        {
+            const audio_sample square = frame[channel] * frame[channel];
+            square_max = std::max(square_max, square);
+            square_sum += square;
+        }
+        square_sum /= static_cast<audio_sample>(channels_);
+        square_sum += square_max;
+        const audio_sample perceived = FAST_VU_FUDGE_FACTOR *
+                                perceivedLoudness.get_mean_squared(square_sum);
+        const double weighted =
+            std::max(long_integration.integrate(square_sum), perceived);
+
+        const double rms = sqrt(weighted);
+
+        return target_level /
+               std::max(minimum_detection,
+                        static_cast<audio_sample>(
+                            release_integration.get_envelope(rms)));
+    }
+
 public:
     [[nodiscard]] int latency() const { return perceivedLoudness.latency(); }
 
@@ -82,9 +136,9 @@ public:
 
     void start(const int channels, int rate)
     {
-        update_config();
         channels_ = channels;
-        processed_frames = 0;
+        rate_ = rate;
+        update_config();
         release_integration.set_seconds_for_rate(SHORT_INTEGRATION, rate, 0);
         long_integration.set_seconds_for_rate(LONG_INTEGRATION / 2.0, rate,
                                               slow_weight);
@@ -96,13 +150,9 @@ public:
          * for the effective time the signal climbs back up after a peak, we
          * must therefore half the integration time.
          */
-        perceivedLoudness.set_rate_and_value(rate, target_level);
-        const int alloc_size = channels_ * latency();
-
-        if (read_ahead_buffer.size() < alloc_size)
-        {
-            read_ahead_buffer.alloc(alloc_size);
-        }
+        k_filter.setup(channels, rate);
+        k_frame.resize(channels);
+        start_look_ahead();
     }
 
     void update_config()
@@ -120,64 +170,80 @@ public:
         slow_weight = 2.0f * perception_slow_balance * SLOW_VU_FUDGE_FACTOR;
         slow_weight *= slow_weight;
         long_integration.set_scale(slow_weight);
-    }
-
-    bool process_has_output(const Index<audio_sample> & frame_in,
-                            Index<audio_sample> & frame_out)
-    {
-        bool has_output_data = processed_frames >= latency();
-        if (has_output_data)
-        {
-            read_ahead_buffer.move_out(frame_out.begin(), channels_);
-        }
-        else
+        k_weighting = aud_get_bool(CONFIG_SECTION_BACKGROUND_MUSIC,
+                                   CONF_K_WEIGHTING_VARIABLE);
+
+        const float new_look_ahead =
+            get_clamped_value(CONF_LOOK_AHEAD_VARIABLE, CONF_LOOK_AHEAD_MIN,
+                              CONF_LOOK_AHEAD_MAX) /
+            1000.0f;
+        if (new_look_ahead != look_ahead)
         {
-            processed_frames++;
+            look_ahead = new_look_ahead;
+            /*
+             * A new look-ahead needs a new delay line; the little audio still
+             * in the old one is dropped.
+             */
+            if (rate_)
+            {
+                start_look_ahead();
+            }
         }
-        read_ahead_buffer.copy_in(frame_in.begin(), channels_);
+    }
 
-        /*
-         * Following calculations need to happen to anticipate the (future)
-         * output.
-         */
+    /**
+     * Processes frames in place. Output lags input by latency() frames, so
+     * right after a start or flush, less comes out than goes in.
+     * @return the number of frames of output at the start of data
+     */
+    int process(audio_sample * data, const int frames)
+    {
+        const int delay = latency();
+        int output_frames = 0;
 
-        audio_sample square_sum = 0.0;
-        audio_sample square_max = 0.0;
-        for (const audio_sample sample : frame_in)
+        for (int frame = 0; frame < frames; frame++)
         {
-            const audio_sample square = sample * sample;
-            square_max = std::max(square_max, square);
-            square_sum += square;
-        }
-        square_sum /= static_cast<audio_sample>(channels_);
-        square_sum += square_max;
-        const audio_sample perceived = FAST_VU_FUDGE_FACTOR *
-                                perceivedLoudness.get_mean_squared(square_sum);
-        const double weighted =
-            std::max(long_integration.integrate(square_sum), perceived);
+            audio_sample * input = data + frame * channels_;
+            audio_sample * delayed =
+                delay_line.begin() + delay_position * channels_;
 
-        const double rms = sqrt(weighted);
+            /*
+             * The gain is calculated from the newest frame, to anticipate the
+             * (future) output, and applied to the delayed one.
+             */
+            const audio_sample gain = get_gain(input);
 
-        const audio_sample gain =
-            target_level /
-            std::max(minimum_detection,
-                     static_cast<audio_sample>(release_integration.get_envelope(rms)));
+            if (processed_frames < delay)
+            {
+                std::copy(input, input + channels_, delayed);
+                processed_frames++;
+            }
+            else
+            {
+                audio_sample * output = data + output_frames * channels_;
+                for (int channel = 0; channel < channels_; channel++)
+                {
+                    const audio_sample sample = delayed[channel];
+                    delayed[channel] = input[channel];
+                    output[channel] = sample * gain;
+                }
+                output_frames++;
+            }
 
-        if (has_output_data)
-        {
-            for (audio_sample & sample : frame_out)
+            if (++delay_position == delay)
             {
-                sample *= gain;
+                delay_position = 0;
             }
         }
 
-        return has_output_data;
+        return output_frames;
     }
 
     void flush()
     {
         processed_frames = 0;
-        read_ahead_buffer.discard();
+        delay_position = 0;
+        k_filter.reset();
     }
 };
 
@@ -36,6 +36,13 @@ static constexpr const PreferencesWidget background_music_widgets[] = {
         N_("Slow detection weight:"),
         WidgetFloat(CONFIG_SECTION_BACKGROUND_MUSIC, CONF_SLOW_WEIGHT_VARIABLE),
         {CONF_SLOW_WEIGHT_MIN, CONF_SLOW_WEIGHT_MAX, 0.1}),
+    WidgetSpin(N_("Look-ahead:"),
+               WidgetFloat(CONFIG_SECTION_BACKGROUND_MUSIC,
+                           CONF_LOOK_AHEAD_VARIABLE),
+               {CONF_LOOK_AHEAD_MIN, CONF_LOOK_AHEAD_MAX, 1.0, N_("ms")}),
+    WidgetCheck(N_("K-weighted detection (ITU-R BS.1770)"),
+                WidgetBool(CONFIG_SECTION_BACKGROUND_MUSIC,
+                           CONF_K_WEIGHTING_VARIABLE)),
     WidgetLabel(N_("<b>Hint</b>")),
     WidgetLabel(
         N_("Slow detection weight is the relative weight\n"
@@ -43,7 +50,9 @@ static constexpr const PreferencesWidget background_music_widgets[] = {
            "to the actual, faster loudness detection.\n"
            "A value of zero gives a more radio-like sound\n"
            "where soft passages get \"pulled up\" more quickly,\n"
-           "a value of two makes the sound feel less compressed."))};
+           "a value of two makes the sound feel less compressed.\n"
+           "A shorter look-ahead lowers the delay, but lets\n"
+           "sudden peaks through a little more."))};
 
 static constexpr const PluginPreferences background_music_preferences = {
     {background_music_widgets}};
@@ -38,6 +38,14 @@ static constexpr const char * CONF_SLOW_WEIGHT_DEFAULT_STRING = "0.5";
 static constexpr double CONF_SLOW_WEIGHT_MIN = 0.0;
 static constexpr double CONF_SLOW_WEIGHT_MAX = 2.0;
 
+static constexpr const char * CONF_LOOK_AHEAD_VARIABLE = "look_ahead";
+static constexpr const char * CONF_LOOK_AHEAD_DEFAULT_STRING = "30";
+static constexpr double CONF_LOOK_AHEAD_MIN = 1.0;
+static constexpr double CONF_LOOK_AHEAD_MAX = 30.0;
+
+static constexpr const char * CONF_K_WEIGHTING_VARIABLE = "k_weighting";
+static constexpr const char * CONF_K_WEIGHTING_DEFAULT_STRING = "FALSE";
+
 static constexpr const char * const background_music_defaults[] = {
     CONF_TARGET_LEVEL_VARIABLE, CONF_TARGET_LEVEL_DEFAULT_STRING,
     //
@@ -45,6 +53,10 @@ static constexpr const char * const background_music_defaults[] = {
     //
     CONF_SLOW_WEIGHT_VARIABLE, CONF_SLOW_WEIGHT_DEFAULT_STRING,
     //
+    CONF_LOOK_AHEAD_VARIABLE, CONF_LOOK_AHEAD_DEFAULT_STRING,
+    //
+    CONF_K_WEIGHTING_VARIABLE, CONF_K_WEIGHTING_DEFAULT_STRING,
+    //
     nullptr};
 
 #endif // AUDACIOUS_PLUGINS_BGM_BASIC_CONFIG_H
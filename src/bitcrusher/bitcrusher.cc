@@ -17,30 +17,63 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <cmath>
-
 #include <libaudcore/i18n.h>
 #include <libaudcore/runtime.h>
 #include <libaudcore/plugin.h>
 #include <libaudcore/preferences.h>
 
+#include "../effect-common/bitcrush.h"
+#include "../effect-common/params.h"
+#include "../effect-common/smoothing.h"
+
+/* The SIMD kernel only handles 32-bit floats. */
+#ifndef DEF_AUDIO_FLOAT64
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define CRUSH_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CRUSH_NEON
+#endif
+#endif
+
+#define SMOOTH_TIME 0.05f /* seconds */
+#define CHUNK 256         /* frames */
+
 static const char * const bitcrusher_defaults[] = {
  "depth", "32",
  "downsample", "1.0",
  nullptr};
 
+static void settings_changed ()
+{
+    effect_settings_changed ("bitcrusher");
+}
+
 static const PreferencesWidget bitcrusher_widgets[] = {
     WidgetLabel (N_("<b>Bitcrusher</b>")),
     WidgetSpin (N_("Bit Depth:"),
-        WidgetFloat ("bitcrusher", "depth"),
+        WidgetFloat ("bitcrusher", "depth", settings_changed),
         {2, 32, 0.1}),
     WidgetSpin (N_("Downsample ratio:"),
-        WidgetFloat ("bitcrusher", "downsample"),
+        WidgetFloat ("bitcrusher", "downsample", settings_changed),
         {0.02, 1.0, 0.02}),
 };
 
 static const PluginPreferences bitcrusher_prefs = {{bitcrusher_widgets}};
 
+struct BitcrusherParams {
+    float depth, downsample;
+};
+
+static void read_params (BitcrusherParams & params)
+{
+    params.depth = aud_get_double ("bitcrusher", "depth");
+    params.downsample = aud_get_double ("bitcrusher", "downsample");
+}
+
+static EffectParams<BitcrusherParams> bitcrusher_params (read_params);
+
 class Bitcrusher : public EffectPlugin
 {
 public:
@@ -63,7 +96,11 @@ public:
 private:
     float m_accumulator = 0.0;
     int m_channels = 0;
-    Index<audio_sample> m_hold;
+    Index<audio_sample> m_hold; /* the frame held, one sample per channel */
+
+    LinearSmoother m_depth, m_downsample;
+    CrushFactors m_factors {}; /* for the set depth */
+    float m_factors_depth = 0;
 };
 
 EXPORT Bitcrusher aud_plugin_instance;
@@ -72,15 +109,64 @@ bool
 Bitcrusher::init ()
 {
     aud_config_set_defaults ("bitcrusher", bitcrusher_defaults);
+    bitcrusher_params.update ();
+    bitcrusher_params.watch ("bitcrusher");
     return true;
 }
 
 void
 Bitcrusher::cleanup ()
 {
+    bitcrusher_params.unwatch ("bitcrusher");
     m_hold.clear ();
 }
 
+/* crush_sample() over a block of samples, with the factors fixed */
+static void crush_block (audio_sample * data, int samples, CrushFactors factors)
+{
+    int i = 0;
+
+#if defined(CRUSH_SSE2)
+    const __m128 mul = _mm_set1_ps (factors.mul), inv = _mm_set1_ps (factors.inv);
+    const __m128 half = _mm_set1_ps (0.5f), one = _mm_set1_ps (1.0f);
+    const __m128 whole = _mm_set1_ps (8388608.0f), minus_whole = _mm_set1_ps (-8388608.0f);
+    const __m128 sign = _mm_set1_ps (-0.0f);
+
+    for (; i + 4 <= samples; i += 4)
+    {
+        __m128 steps = _mm_mul_ps (_mm_loadu_ps (data + i), mul);
+        __m128 t = _mm_add_ps (steps, half);
+        __m128 clamped = _mm_min_ps (_mm_max_ps (t, minus_whole), whole);
+        __m128 n = _mm_cvtepi32_ps (_mm_cvttps_epi32 (clamped));
+
+        n = _mm_sub_ps (n, _mm_and_ps (_mm_cmpgt_ps (n, t), one));
+
+        __m128 small = _mm_cmplt_ps (_mm_andnot_ps (sign, steps), whole);
+        __m128 out = _mm_or_ps (_mm_and_ps (small, n), _mm_andnot_ps (small, steps));
+
+        _mm_storeu_ps (data + i, _mm_mul_ps (out, inv));
+    }
+#elif defined(CRUSH_NEON)
+    const float32x4_t whole = vdupq_n_f32 (8388608.0f), minus_whole = vdupq_n_f32 (-8388608.0f);
+
+    for (; i + 4 <= samples; i += 4)
+    {
+        float32x4_t steps = vmulq_n_f32 (vld1q_f32 (data + i), factors.mul);
+        float32x4_t t = vaddq_f32 (steps, vdupq_n_f32 (0.5f));
+        float32x4_t clamped = vminq_f32 (vmaxq_f32 (t, minus_whole), whole);
+        float32x4_t n = vcvtq_f32_s32 (vcvtq_s32_f32 (clamped));
+
+        n = vsubq_f32 (n, vbslq_f32 (vcgtq_f32 (n, t), vdupq_n_f32 (1.0f), vdupq_n_f32 (0.0f)));
+
+        uint32x4_t small = vcltq_f32 (vabsq_f32 (steps), whole);
+        vst1q_f32 (data + i, vmulq_n_f32 (vbslq_f32 (small, n, steps), factors.inv));
+    }
+#endif
+
+    for (; i < samples; i ++)
+        data[i] = crush_sample (data[i], factors);
+}
+
 void
 Bitcrusher::start (int & channels, int & rate)
 {
@@ -89,36 +175,93 @@ Bitcrusher::start (int & channels, int & rate)
 
     m_hold.resize (m_channels);
     m_hold.erase (0, m_channels);
+
+    const BitcrusherParams & params = bitcrusher_params.get ();
+
+    m_depth.setup (SMOOTH_TIME, rate);
+    m_depth.reset (params.depth);
+    m_downsample.setup (SMOOTH_TIME, rate);
+    m_downsample.reset (params.downsample);
 }
 
 Index<audio_sample> &
 Bitcrusher::process (Index<audio_sample> & data)
 {
-    float downsample_ratio = aud_get_double ("bitcrusher", "downsample");
-    float bit_depth = aud_get_double ("bitcrusher", "depth");
+    const BitcrusherParams & params = bitcrusher_params.get ();
+
+    m_depth.set_target (params.depth);
+    m_downsample.set_target (params.downsample);
 
-    float scale = pow (2., bit_depth) / 2.;
-    float gain = (33. - bit_depth) / 8.;
+    if (params.depth != m_factors_depth)
+    {
+        m_factors = crush_factors (params.depth);
+        m_factors_depth = params.depth;
+    }
 
     audio_sample * f = data.begin ();
-    const audio_sample * end = data.end ();
+    int frames = data.len () / m_channels;
+    float depth[CHUNK], downsample_ratio[CHUNK];
+    int taken[CHUNK];
 
-    while (f < end)
+    while (frames)
     {
-        m_accumulator += downsample_ratio;
+        int chunk = aud::min (frames, CHUNK);
+        int samples = chunk * m_channels;
+        bool gliding = ! m_depth.settled ();
 
-        for (int channel = 0; channel < m_channels; channel ++)
+        m_depth.fill (depth, chunk);
+        m_downsample.fill (downsample_ratio, chunk);
+
+        /* the frames that take a new sample */
+        int count = 0;
+
+        for (int i = 0; i < chunk; i ++)
         {
-            audio_sample current = * f;
+            m_accumulator += downsample_ratio[i];
 
-            if (m_accumulator >= 1.0)
-                m_hold [channel] = floor ((current * gain) * scale + 0.5) / scale / gain;
+            bool take = (m_accumulator >= 1.0f);
+            m_accumulator -= take ? 1.0f : 0.0f;
 
-            * f ++ = m_hold [channel];
+            taken[count] = i;
+            count += take;
         }
 
-        if (m_accumulator >= 1.0)
-            m_accumulator -= 1.0;
+        if (count == chunk && ! gliding)
+            crush_block (f, samples, m_factors);
+        else
+        {
+            /* crush the frames taken and hold each one up to the next */
+            const audio_sample * hold = m_hold.begin ();
+            int from = 0;
+
+            for (int t = 0; t <= count; t ++)
+            {
+                int until = (t < count) ? taken[t] : chunk;
+
+                for (int i = from; i < until; i ++)
+                {
+                    audio_sample * frame = f + i * m_channels;
+                    for (int channel = 0; channel < m_channels; channel ++)
+                        frame[channel] = hold[channel];
+                }
+
+                if (t < count)
+                {
+                    audio_sample * frame = f + until * m_channels;
+                    crush_block (frame, m_channels, gliding ?
+                     crush_factors (depth[until]) : m_factors);
+
+                    hold = frame;
+                    from = until + 1;
+                }
+            }
+        }
+
+        for (int channel = 0; channel < m_channels; channel ++)
+            m_hold[channel] = f[samples - m_channels + channel];
+
+        f += samples;
+        frames -= chunk;
     }
 
     return data;
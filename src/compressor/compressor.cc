@@ -28,6 +28,11 @@
 #include <libaudcore/ringbuf.h>
 #include <libaudcore/runtime.h>
 
+#include "../effect-common/params.h"
+
+#include "crossover.h"
+#include "limiter.h"
+
 /* Response time adjustments.  Maybe this should be adjustable? */
 #define CHUNK_TIME 0.2f /* seconds */
 #define CHUNKS 5
@@ -42,17 +47,56 @@
 static const char * const compressor_defaults[] = {
     "center", "0.5",
     "range", "0.5",
+    "limiter", "FALSE",
+    "lookahead", "5",
+    "bands", "1",
+    "crossover1", "150",
+    "crossover2", "600",
+    "crossover3", "2500",
+    "crossover4", "8000",
      nullptr
 };
 
+static void settings_changed ()
+{
+    effect_settings_changed ("compressor");
+}
+
 static const PreferencesWidget compressor_widgets[] = {
     WidgetLabel (N_("<b>Compression</b>")),
     WidgetSpin (N_("Center volume:"),
-        WidgetFloat ("compressor", "center"),
+        WidgetFloat ("compressor", "center", settings_changed),
         {0.1, 1, 0.1}),
     WidgetSpin (N_("Dynamic range:"),
-        WidgetFloat ("compressor", "range"),
-        {0.0, 3.0, 0.1})
+        WidgetFloat ("compressor", "range", settings_changed),
+        {0.0, 3.0, 0.1}),
+    WidgetLabel (N_("<b>Frequency Bands</b>")),
+    WidgetSpin (N_("Bands:"),
+        WidgetInt ("compressor", "bands"),
+        {1, MAX_BANDS, 1}),
+    WidgetSpin (N_("Crossover 1:"),
+        WidgetFloat ("compressor", "crossover1"),
+        {20, 20000, 10, N_("Hz")},
+        WIDGET_CHILD),
+    WidgetSpin (N_("Crossover 2:"),
+        WidgetFloat ("compressor", "crossover2"),
+        {20, 20000, 10, N_("Hz")},
+        WIDGET_CHILD),
+    WidgetSpin (N_("Crossover 3:"),
+        WidgetFloat ("compressor", "crossover3"),
+        {20, 20000, 10, N_("Hz")},
+        WIDGET_CHILD),
+    WidgetSpin (N_("Crossover 4:"),
+        WidgetFloat ("compressor", "crossover4"),
+        {20, 20000, 10, N_("Hz")},
+        WIDGET_CHILD),
+    WidgetLabel (N_("<b>Latency</b>")),
+    WidgetCheck (N_("Low latency (look-ahead limiter)"),
+        WidgetBool ("compressor", "limiter")),
+    WidgetSpin (N_("Look-ahead:"),
+        WidgetFloat ("compressor", "lookahead"),
+        {1, 10, 0.5, N_("ms")},
+        WIDGET_CHILD)
 };
 
 static const PluginPreferences compressor_prefs = {{compressor_widgets}};
@@ -90,12 +134,41 @@ EXPORT Compressor aud_plugin_instance;
  * read a multiple of the chunk size or (b) empty the buffer completely.  Writes
  * to the buffer need not be aligned to the chunk size. */
 
-static RingBuf<audio_sample> buffer, peaks;
+/* Each frequency band is compressed on its own, with its own peak history.  The
+ * buffers of all bands are always filled and emptied together.  With a single
+ * band, the input is used as is and no filtering is done. */
+struct Band {
+    RingBuf<audio_sample> buffer, peaks;
+    audio_sample current_peak;
+};
+
+static Band bands[MAX_BANDS];
+static int n_bands;
+static Crossover crossover;
+static Index<audio_sample> band_data[MAX_BANDS];
+
 static Index<audio_sample> output;
 static int chunk_size;
-static audio_sample current_peak;
 static int current_channels, current_rate;
 
+/* The look-ahead mode is chosen when playback starts. */
+static bool use_limiter;
+static Limiter limiter;
+
+/* The compression curve can be changed during playback; the band and look-ahead
+ * settings take effect at the next song. */
+struct CompressorParams {
+    float center, range;
+};
+
+static void read_params (CompressorParams & params)
+{
+    params.center = aud_get_double ("compressor", "center");
+    params.range = aud_get_double ("compressor", "range");
+}
+
+static EffectParams<CompressorParams> compressor_params (read_params);
+
 /* I used to find the maximum sample and take that as the peak, but that doesn't
  * work well on badly clipped tracks.  Now, I use the highly sophisticated
  * method of averaging the absolute value of the samples and multiplying by 6, a
@@ -119,8 +192,9 @@ static audio_sample calc_peak (audio_sample * data, int length)
 
 static void do_ramp (audio_sample * data, int length, audio_sample peak_a, audio_sample peak_b)
 {
-    audio_sample center = aud_get_double ("compressor", "center");
-    audio_sample range = aud_get_double ("compressor", "range");
+    const CompressorParams & params = compressor_params.get ();
+    audio_sample center = params.center;
+    audio_sample range = params.range;
     audio_sample a = pow (peak_a / center, range - 1);
     audio_sample b = pow (peak_b / center, range - 1);
 
@@ -131,17 +205,82 @@ static void do_ramp (audio_sample * data, int length, audio_sample peak_a, audio
     }
 }
 
+static void mix (audio_sample * data, const audio_sample * add, int length)
+{
+    for (int i = 0; i < length; i ++)
+        data[i] += add[i];
+}
+
+/* Returns a pointer to the input of each band.  For a single band, that is the
+ * unfiltered data itself. */
+static void split_bands (Index<audio_sample> & data, audio_sample * * in)
+{
+    if (n_bands == 1)
+    {
+        in[0] = data.begin ();
+        return;
+    }
+
+    for (int b = 0; b < n_bands; b ++)
+    {
+        band_data[b].resize (data.len ());
+        in[b] = band_data[b].begin ();
+    }
+
+    crossover.split (data.begin (), data.len (), in);
+}
+
+/* Compresses the first chunk in the buffer of a band. */
+static void compress_chunk (Band & band)
+{
+    RingBuf<audio_sample> & buffer = band.buffer;
+    RingBuf<audio_sample> & peaks = band.peaks;
+    audio_sample & current_peak = band.current_peak;
+
+    while (peaks.len () < CHUNKS)
+        peaks.push (calc_peak (& buffer[chunk_size * peaks.len ()], chunk_size));
+
+    if (current_peak == 0.0)
+    {
+        for (int i = 0; i < CHUNKS; i ++)
+            current_peak = aud::max (current_peak, peaks[i]);
+    }
+
+#ifdef DEF_AUDIO_FLOAT64
+    audio_sample new_peak = aud::max (peaks[0], current_peak * (1.0 - DECAY));
+#else
+    audio_sample new_peak = aud::max (peaks[0], current_peak * (1.0f - DECAY));
+#endif
+    for (int count = 1; count < CHUNKS; count ++)
+        new_peak = aud::max (new_peak, current_peak + (peaks[count] - current_peak) / count);
+
+    do_ramp (& buffer[0], chunk_size, current_peak, new_peak);
+
+    current_peak = new_peak;
+    peaks.pop ();
+}
+
 bool Compressor::init ()
 {
     aud_config_set_defaults ("compressor", compressor_defaults);
+    compressor_params.update ();
+    compressor_params.watch ("compressor");
     return true;
 }
 
 void Compressor::cleanup ()
 {
-    buffer.destroy ();
-    peaks.destroy ();
+    compressor_params.unwatch ("compressor");
+
+    for (int b = 0; b < MAX_BANDS; b ++)
+    {
+        bands[b].buffer.destroy ();
+        bands[b].peaks.destroy ();
+        band_data[b].clear ();
+    }
+
     output.clear ();
+    limiter.clear ();
 }
 
 void Compressor::start (int & channels, int & rate)
@@ -149,56 +288,104 @@ void Compressor::start (int & channels, int & rate)
     current_channels = channels;
     current_rate = rate;
 
+    use_limiter = aud_get_bool ("compressor", "limiter");
+
+    if (use_limiter)
+    {
+        for (int b = 0; b < MAX_BANDS; b ++)
+        {
+            bands[b].buffer.destroy ();
+            bands[b].peaks.destroy ();
+        }
+
+        limiter.start (channels, rate, aud_get_double ("compressor", "lookahead"));
+        return;
+    }
+
+    limiter.clear ();
+
+    n_bands = aud::clamp (aud_get_int ("compressor", "bands"), 1, MAX_BANDS);
+
+    static const char * const crossover_names[MAX_BANDS - 1] =
+     {"crossover1", "crossover2", "crossover3", "crossover4"};
+
+    float freqs[MAX_BANDS - 1];
+    for (int i = 0; i < n_bands - 1; i ++)
+    {
+        freqs[i] = aud_get_double ("compressor", crossover_names[i]);
+        if (i > 0)
+            freqs[i] = aud::max (freqs[i], freqs[i - 1]);
+    }
+
+    crossover.setup (channels, rate, n_bands, freqs);
+
     chunk_size = channels * (int) (rate * CHUNK_TIME);
 
-    buffer.alloc (chunk_size * CHUNKS);
-    peaks.alloc (CHUNKS);
+    for (int b = 0; b < MAX_BANDS; b ++)
+    {
+        if (b < n_bands)
+        {
+            bands[b].buffer.alloc (chunk_size * CHUNKS);
+            bands[b].peaks.alloc (CHUNKS);
+        }
+        else
+        {
+            bands[b].buffer.destroy ();
+            bands[b].peaks.destroy ();
+            band_data[b].clear ();
+        }
+    }
 
     flush (true);
 }
 
+static void limiter_update ()
+{
+    const CompressorParams & params = compressor_params.get ();
+    limiter.set_params (params.center, params.range);
+}
+
 Index<audio_sample> & Compressor::process (Index<audio_sample> & data)
 {
     output.resize (0);
 
+    if (use_limiter)
+    {
+        limiter_update ();
+        limiter.process (data.begin (), data.len () / current_channels, output);
+        return output;
+    }
+
+    audio_sample * in[MAX_BANDS];
+    split_bands (data, in);
+
     int offset = 0;
     int remain = data.len ();
 
     while (1)
     {
-        int writable = aud::min (remain, buffer.space ());
+        int writable = aud::min (remain, bands[0].buffer.space ());
 
-        buffer.copy_in (& data[offset], writable);
+        for (int b = 0; b < n_bands; b ++)
+            bands[b].buffer.copy_in (in[b] + offset, writable);
 
         offset += writable;
         remain -= writable;
 
-        if (buffer.space ())
+        if (bands[0].buffer.space ())
             break;
 
-        while (peaks.len () < CHUNKS)
-            peaks.push (calc_peak (& buffer[chunk_size * peaks.len ()], chunk_size));
+        for (int b = 0; b < n_bands; b ++)
+            compress_chunk (bands[b]);
+
+        int start = output.len ();
+        bands[0].buffer.move_out (output, -1, chunk_size);
 
-        if (current_peak == 0.0)
+        for (int b = 1; b < n_bands; b ++)
         {
-            for (int i = 0; i < CHUNKS; i ++)
-                current_peak = aud::max (current_peak, peaks[i]);
+            mix (& output[start], & bands[b].buffer[0], chunk_size);
+            bands[b].buffer.discard (chunk_size);
         }
-
-#ifdef DEF_AUDIO_FLOAT64
-        audio_sample new_peak = aud::max (peaks[0], current_peak * (1.0 - DECAY));
-#else
-        audio_sample new_peak = aud::max (peaks[0], current_peak * (1.0f - DECAY));
-#endif
-        for (int count = 1; count < CHUNKS; count ++)
-            new_peak = aud::max (new_peak, current_peak + (peaks[count] - current_peak) / count);
-
-        do_ramp (& buffer[0], chunk_size, current_peak, new_peak);
-
-        buffer.move_out (output, -1, chunk_size);
-
-        current_peak = new_peak;
-        peaks.pop ();
     }
 
     return output;
@@ -206,10 +393,20 @@ Index<audio_sample> & Compressor::process (Index<audio_sample> & data)
 
 bool Compressor::flush (bool force)
 {
-    buffer.discard ();
-    peaks.discard ();
+    if (use_limiter)
+    {
+        limiter.flush ();
+        return true;
+    }
+
+    for (int b = 0; b < n_bands; b ++)
+    {
+        bands[b].buffer.discard ();
+        bands[b].peaks.discard ();
+        bands[b].current_peak = 0.0;
+    }
 
-    current_peak = 0.0;
+    crossover.reset ();
     return true;
 }
 
@@ -217,27 +414,52 @@ Index<audio_sample> & Compressor::finish (Index<audio_sample> & data, bool end_o
 {
     output.resize (0);
 
-    peaks.discard ();
+    if (use_limiter)
+    {
+        limiter_update ();
+        limiter.process (data.begin (), data.len () / current_channels, output);
+        limiter.drain (output);
+        return output;
+    }
+
+    audio_sample * in[MAX_BANDS];
+    split_bands (data, in);
+
+    output.insert (-1, bands[0].buffer.len () + data.len ());
 
-    while (buffer.len ())
+    for (int b = 0; b < n_bands; b ++)
     {
-        int writable = buffer.linear ();
+        RingBuf<audio_sample> & buffer = bands[b].buffer;
+        audio_sample current_peak = bands[b].current_peak;
+        audio_sample * out = output.begin ();
 
-        if (current_peak != 0.0)
-            do_ramp (& buffer[0], writable, current_peak, current_peak);
+        bands[b].peaks.discard ();
 
-        buffer.move_out (output, -1, writable);
-    }
+        while (buffer.len ())
+        {
+            int writable = buffer.linear ();
 
-    if (current_peak != 0.0)
-        do_ramp (data.begin (), data.len (), current_peak, current_peak);
+            if (current_peak != 0.0)
+                do_ramp (& buffer[0], writable, current_peak, current_peak);
 
-    output.insert (data.begin (), -1, data.len ());
+            mix (out, & buffer[0], writable);
+            buffer.discard (writable);
+            out += writable;
+        }
+
+        if (current_peak != 0.0)
+            do_ramp (in[b], data.len (), current_peak, current_peak);
+
+        mix (out, in[b], data.len ());
+    }
 
     return output;
 }
 
 int Compressor::adjust_delay (int delay)
 {
-    return delay + aud::rescale<int64_t> (buffer.len () / current_channels, current_rate, 1000);
+    if (use_limiter)
+        return delay + aud::rescale<int64_t> (limiter.latency (), current_rate, 1000);
+
+    return delay + aud::rescale<int64_t> (bands[0].buffer.len () / current_channels, current_rate, 1000);
 }
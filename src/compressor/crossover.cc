@@ -0,0 +1,128 @@
+/*
+ * Dynamic Range Compression Plugin for Audacious
+ * Copyright 2010-2014 John Lindgren
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "crossover.h"
+
+/* Transposed direct form II biquad over interleaved audio.  The inner loop runs
+ * across channels with no dependency between iterations, so it maps onto SIMD
+ * lanes; the channel count is a compile-time constant for the common cases so
+ * that the compiler can keep the state in registers. */
+template<int N>
+static void biquad_run (const float * k, float * state, const audio_sample * in,
+ audio_sample * out, int frames, int channels)
+{
+    if (N)
+        channels = N;
+
+    float * s1 = state;
+    float * s2 = state + channels;
+    const float b0 = k[0], b1 = k[1], b2 = k[2], a1 = k[3], a2 = k[4];
+
+    for (int f = 0; f < frames; f ++)
+    {
+        for (int c = 0; c < channels; c ++)
+        {
+            float x = in[c];
+            float y = b0 * x + s1[c];
+            s1[c] = b1 * x - a1 * y + s2[c];
+            s2[c] = b2 * x - a2 * y;
+            out[c] = y;
+        }
+
+        in += channels;
+        out += channels;
+    }
+}
+
+static void biquad (const float * k, float * state, const audio_sample * in,
+ audio_sample * out, int frames, int channels)
+{
+    switch (channels)
+    {
+    case 1:
+        biquad_run<1> (k, state, in, out, frames, channels);
+        break;
+    case 2:
+        biquad_run<2> (k, state, in, out, frames, channels);
+        break;
+    case 6:
+        biquad_run<6> (k, state, in, out, frames, channels);
+        break;
+    case 8:
+        biquad_run<8> (k, state, in, out, frames, channels);
+        break;
+    default:
+        biquad_run<0> (k, state, in, out, frames, channels);
+        break;
+    }
+}
+
+void Crossover::setup (int channels, int rate, int bands, const float * freqs)
+{
+    m_channels = channels;
+    m_bands = aud::clamp (bands, 1, MAX_BANDS);
+
+    for (int i = 0; i < m_bands - 1; i ++)
+    {
+        /* Butterworth low-pass (Q = 1/sqrt(2)); two in series make an LR4 */
+        float freq = aud::clamp (freqs[i], 10.0f, rate * 0.45f);
+        double w0 = 2 * M_PI * freq / rate;
+        double alpha = sin (w0) / (2 * M_SQRT1_2);
+        double cosw = cos (w0);
+        double a0 = 1 + alpha;
+
+        m_coefs[i].b0 = (1 - cosw) / 2 / a0;
+        m_coefs[i].b1 = (1 - cosw) / a0;
+        m_coefs[i].b2 = (1 - cosw) / 2 / a0;
+        m_coefs[i].a1 = -2 * cosw / a0;
+        m_coefs[i].a2 = (1 - alpha) / a0;
+    }
+
+    m_state.resize ((MAX_BANDS - 1) * 2 * 2 * channels);
+    reset ();
+}
+
+void Crossover::reset ()
+{
+    m_state.erase (0, -1);
+}
+
+void Crossover::split (const audio_sample * in, int samples, audio_sample * const * out)
+{
+    int frames = samples / m_channels;
+    audio_sample * rest = out[m_bands - 1];
+
+    memcpy (rest, in, sizeof (audio_sample) * samples);
+
+    for (int i = 0; i < m_bands - 1; i ++)
+    {
+        const float * k = & m_coefs[i].b0;
+        float * state = & m_state[i * 4 * m_channels];
+        audio_sample * band = out[i];
+
+        biquad (k, state, rest, band, frames, m_channels);
+        biquad (k, state + 2 * m_channels, band, band, frames, m_channels);
+
+        for (int s = 0; s < samples; s ++)
+            rest[s] -= band[s];
+    }
+}
@@ -0,0 +1,54 @@
+/*
+ * Dynamic Range Compression Plugin for Audacious
+ * Copyright 2010-2014 John Lindgren
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef COMPRESSOR_CROSSOVER_H
+#define COMPRESSOR_CROSSOVER_H
+
+#include <libaudcore/index.h>
+#include <libaudcore/plugin.h>
+
+#define MAX_BANDS 5
+
+/* Splits interleaved audio into frequency bands.  Each split takes a 4th-order
+ * Linkwitz-Riley low-pass of what is left over from the splits below it; the
+ * band above is the remainder.  The bands therefore always add up to the input
+ * (to within rounding), whatever the crossover frequencies. */
+class Crossover
+{
+public:
+    /* <freqs> holds bands - 1 frequencies, in ascending order */
+    void setup (int channels, int rate, int bands, const float * freqs);
+    void reset ();
+
+    /* Writes <samples> samples of each band to out[0 ... bands - 1]. */
+    void split (const audio_sample * in, int samples, audio_sample * const * out);
+
+private:
+    struct Coefs {
+        float b0, b1, b2, a1, a2;
+    };
+
+    int m_channels = 0, m_bands = 1;
+    Coefs m_coefs[MAX_BANDS - 1];
+
+    /* two sections, two state variables each, per split and channel */
+    Index<float> m_state;
+};
+
+#endif
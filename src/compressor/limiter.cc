@@ -0,0 +1,319 @@
+/*
+ * Dynamic Range Compression Plugin for Audacious
+ * Copyright 2010-2014 John Lindgren
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <math.h>
+
+#include "limiter.h"
+
+/* The SIMD kernel only handles 32-bit floats. */
+#ifndef DEF_AUDIO_FLOAT64
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define LIMITER_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LIMITER_NEON
+#endif
+#endif
+
+#define RELEASE_TIME 0.2f /* seconds */
+#define MIN_PEAK 0.01f
+
+void SlidingMax::alloc (int window)
+{
+    m_window = window;
+    m_size = window + 1;
+    m_values.resize (m_size);
+    m_times.resize (m_size);
+    reset ();
+}
+
+void SlidingMax::reset ()
+{
+    m_head = m_count = m_time = 0;
+}
+
+/* Adds a value and returns the maximum of the last <window> values.  Each
+ * value is pushed and popped at most once, so this is O(1) amortized. */
+float SlidingMax::push (float value)
+{
+    /* drop values from the back that can never be the maximum again */
+    while (m_count && m_values[(m_head + m_count - 1) % m_size] <= value)
+        m_count --;
+
+    int back = (m_head + m_count) % m_size;
+    m_values[back] = value;
+    m_times[back] = m_time;
+    m_count ++;
+
+    /* drop values from the front that have left the window */
+    while (m_time - m_times[m_head] >= m_window)
+    {
+        m_head = (m_head + 1) % m_size;
+        m_count --;
+    }
+
+    m_time ++;
+    return m_values[m_head];
+}
+
+void Limiter::start (int channels, int rate, float lookahead_ms)
+{
+    m_channels = channels;
+    m_rate = rate;
+    m_window = aud::max (1, (int) (rate * lookahead_ms / 1000));
+    m_latency = TP_DELAY + m_window - 1;
+    m_release = 1 - expf (-1 / (RELEASE_TIME * rate));
+
+    for (int p = 0; p < TP_PHASES; p ++)
+    {
+        float sum = 0;
+
+        for (int j = 0; j < TP_TAPS; j ++)
+        {
+            /* distance from the interpolated point, in frames */
+            float d = j - (TP_DELAY - 1) - (float) p / TP_PHASES;
+            float x = (float) M_PI * d;
+            float sinc = (d == 0) ? 1 : sinf (x) / x;
+            float u = x / (TP_DELAY + 0.5f);
+            float window = 0.42f + 0.5f * cosf (u) + 0.08f * cosf (2 * u);
+
+            m_filter[p][j] = sinc * window;
+            sum += m_filter[p][j];
+        }
+
+        for (int j = 0; j < TP_TAPS; j ++)
+            m_filter[p][j] /= sum;
+    }
+
+    m_history.resize ((TP_TAPS - 1) * channels);
+    m_planar.resize (TP_TAPS - 1 + TP_CHUNK);
+    m_peaks.alloc (m_window);
+    m_box.resize (m_window);
+
+    if (m_delay.size () < (m_latency + 1) * channels)
+        m_delay.alloc ((m_latency + 1) * channels);
+
+    flush ();
+}
+
+void Limiter::set_params (float center, float range)
+{
+    if (center != m_center || range != m_range)
+    {
+        m_center = center;
+        m_range = range;
+        m_last_peak = -1;
+    }
+}
+
+void Limiter::flush ()
+{
+    m_history.erase (0, -1);
+
+    m_peaks.reset ();
+    m_last_peak = -1;
+    m_envelope = 1;
+
+    for (float & g : m_box)
+        g = 1;
+
+    m_box_pos = 0;
+    m_box_sum = m_window;
+
+    m_delay.discard ();
+}
+
+void Limiter::clear ()
+{
+    m_history.clear ();
+    m_planar.clear ();
+    m_box.clear ();
+    m_gains.clear ();
+    m_silence.clear ();
+    m_delay.destroy ();
+}
+
+/* peaks = max (peaks, |interpolated|) for one phase of the filter; four
+ * frames are filtered side by side, with the taps summed in the same order
+ * as in the scalar loop, so the result does not depend on the path taken */
+static void phase_peaks (const float * in, const float * taps, float * peaks, int frames)
+{
+    int f = 0;
+
+#if defined(LIMITER_SSE2)
+    const __m128 sign = _mm_set1_ps (-0.0f);
+
+    for (; f + 4 <= frames; f += 4)
+    {
+        __m128 sum = _mm_setzero_ps ();
+        for (int j = 0; j < TP_TAPS; j ++)
+            sum = _mm_add_ps (sum, _mm_mul_ps (_mm_loadu_ps (in + f + j), _mm_set1_ps (taps[j])));
+
+        __m128 peak = _mm_andnot_ps (sign, sum);
+        _mm_storeu_ps (peaks + f, _mm_max_ps (_mm_loadu_ps (peaks + f), peak));
+    }
+#elif defined(LIMITER_NEON)
+    for (; f + 4 <= frames; f += 4)
+    {
+        float32x4_t sum = vdupq_n_f32 (0);
+        for (int j = 0; j < TP_TAPS; j ++)
+            sum = vaddq_f32 (sum, vmulq_n_f32 (vld1q_f32 (in + f + j), taps[j]));
+
+        vst1q_f32 (peaks + f, vmaxq_f32 (vld1q_f32 (peaks + f), vabsq_f32 (sum)));
+    }
+#endif
+
+    for (; f < frames; f ++)
+    {
+        float sum = 0;
+        for (int j = 0; j < TP_TAPS; j ++)
+            sum += in[f + j] * taps[j];
+
+        peaks[f] = aud::max (peaks[f], fabsf (sum));
+    }
+}
+
+/* Writes to <peaks> the largest absolute value, over all channels, of the
+ * sample TP_DELAY frames back and of the points interpolated between it and
+ * the next one, for up to TP_CHUNK frames.  Each channel is filtered over the
+ * whole chunk at once, rather than frame by frame, so that the filter can
+ * work on several frames in parallel. */
+void Limiter::true_peaks (const audio_sample * data, int frames, float * peaks)
+{
+    const int keep = TP_TAPS - 1;
+    float * in = m_planar.begin ();
+
+    for (int f = 0; f < frames; f ++)
+        peaks[f] = 0;
+
+    for (int c = 0; c < m_channels; c ++)
+    {
+        float * hist = & m_history[c * keep];
+
+        for (int i = 0; i < keep; i ++)
+            in[i] = hist[i];
+        for (int f = 0; f < frames; f ++)
+            in[keep + f] = data[f * m_channels + c];
+
+        for (int f = 0; f < frames; f ++)
+            peaks[f] = aud::max (peaks[f], fabsf (in[f + TP_DELAY - 1]));
+
+        for (int p = 1; p < TP_PHASES; p ++)
+            phase_peaks (in, m_filter[p], peaks, frames);
+
+        for (int i = 0; i < keep; i ++)
+            hist[i] = in[frames + i];
+    }
+}
+
+float Limiter::gain_for_peak (float peak)
+{
+    if (peak != m_last_peak)
+    {
+        float p = aud::max (peak, MIN_PEAK);
+
+        m_last_peak = peak;
+        m_last_gain = aud::min (powf (p / m_center, m_range - 1), 1 / p);
+    }
+
+    return m_last_gain;
+}
+
+void Limiter::compute_gains (const audio_sample * data, int frames)
+{
+    if (m_gains.len () < frames)
+        m_gains.resize (frames);
+
+    float * gains = m_gains.begin ();
+
+    /* the true peaks go into <gains> first */
+    for (int done = 0; done < frames; done += TP_CHUNK)
+        true_peaks (data + done * m_channels, aud::min (frames - done, TP_CHUNK), gains + done);
+
+    /* the window maximum and the envelope depend on the frame before, so this
+     * part stays serial; it is cheap next to the filter */
+    for (int f = 0; f < frames; f ++)
+    {
+        float target = gain_for_peak (m_peaks.push (gains[f]));
+
+        /* instant attack (the look-ahead gives us time), exponential release */
+        if (target < m_envelope)
+            m_envelope = target;
+        else
+            m_envelope += (target - m_envelope) * m_release;
+
+        /* the moving average turns the attack into a smooth ramp that reaches
+         * its target exactly when the peak reaches the output */
+        m_box_sum += m_envelope - m_box[m_box_pos];
+        m_box[m_box_pos] = m_envelope;
+        m_box_pos = (m_box_pos + 1 == m_window) ? 0 : m_box_pos + 1;
+
+        gains[f] = m_box_sum / m_window;
+    }
+}
+
+void Limiter::process (const audio_sample * data, int frames, Index<audio_sample> & out)
+{
+    int held = m_delay.len () / m_channels;
+
+    compute_gains (data, frames);
+
+    int samples = frames * m_channels;
+    if (m_delay.space () < samples)
+        m_delay.alloc (m_delay.len () + samples);
+
+    m_delay.copy_in (data, samples);
+
+    /* frames leaving the delay line were received <latency> frames before the
+     * frames whose gains were just computed */
+    int ready = held + frames - m_latency;
+    if (ready <= 0)
+        return;
+
+    int offset = out.len ();
+    m_delay.move_out (out, -1, ready * m_channels);
+
+    audio_sample * o = & out[offset];
+    const float * gains = & m_gains[m_latency - held];
+
+    for (int f = 0; f < ready; f ++)
+    {
+        for (int c = 0; c < m_channels; c ++)
+            o[c] *= gains[f];
+
+        o += m_channels;
+    }
+}
+
+void Limiter::drain (Index<audio_sample> & out)
+{
+    int held = m_delay.len () / m_channels;
+    if (! held)
+        return;
+
+    /* run silence through so that the held audio still sees the peaks that
+     * come after it (there are none) */
+    int frames = m_latency;
+    if (m_silence.len () < frames * m_channels)
+        m_silence.resize (frames * m_channels);
+
+    process (m_silence.begin (), frames, out);
+    m_delay.discard ();
+}
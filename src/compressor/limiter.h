@@ -0,0 +1,104 @@
+/*
+ * Dynamic Range Compression Plugin for Audacious
+ * Copyright 2010-2014 John Lindgren
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef COMPRESSOR_LIMITER_H
+#define COMPRESSOR_LIMITER_H
+
+#include <libaudcore/index.h>
+#include <libaudcore/plugin.h>
+#include <libaudcore/ringbuf.h>
+
+/* Oversampled (true-peak) detector: 4x interpolation with 12 taps per phase,
+ * as suggested by ITU-R BS.1770. */
+#define TP_PHASES 4
+#define TP_TAPS 12
+#define TP_DELAY (TP_TAPS / 2) /* frames */
+#define TP_CHUNK 256 /* frames */
+
+/* Sliding-window maximum, using a monotonic deque. */
+class SlidingMax
+{
+public:
+    void alloc (int window);
+    void reset ();
+    float push (float value);
+
+private:
+    Index<float> m_values;
+    Index<int> m_times;
+    int m_window = 0, m_size = 0;
+    int m_head = 0, m_count = 0, m_time = 0;
+};
+
+/* Low-latency alternative to the chunk-based compressor.  The gain is derived
+ * from the same curve, but the peak level is the true peak over a short
+ * look-ahead window, so that the gain has already come down by the time a peak
+ * reaches the output.  The gain is additionally limited so that no true peak
+ * exceeds full scale. */
+class Limiter
+{
+public:
+    void start (int channels, int rate, float lookahead_ms);
+    void set_params (float center, float range);
+
+    /* Appends the processed audio to <out>.  Output lags input by latency ()
+     * frames. */
+    void process (const audio_sample * data, int frames, Index<audio_sample> & out);
+
+    /* Pushes the audio still held in the look-ahead buffer to <out>. */
+    void drain (Index<audio_sample> & out);
+
+    void flush ();
+    void clear ();
+
+    int latency () const
+        { return m_delay.len () / m_channels; }
+
+private:
+    float gain_for_peak (float peak);
+    void true_peaks (const audio_sample * data, int frames, float * peaks);
+    void compute_gains (const audio_sample * data, int frames);
+
+    int m_channels = 1, m_rate = 0;
+    int m_window = 0, m_latency = 0;
+    float m_center = 0.5f, m_range = 0.5f;
+    float m_release = 0;
+
+    /* interpolation filter; the input is filtered a chunk at a time, one
+     * channel after another, with the last TP_TAPS - 1 samples of each
+     * channel kept in front of the chunk */
+    float m_filter[TP_PHASES][TP_TAPS];
+    Index<float> m_history; /* [channel][TP_TAPS - 1] */
+    Index<float> m_planar;  /* [TP_TAPS - 1 + TP_CHUNK] */
+
+    SlidingMax m_peaks;
+    float m_last_peak = -1, m_last_gain = 1;
+    float m_envelope = 1;
+
+    /* moving average over the look-ahead window */
+    Index<float> m_box;
+    int m_box_pos = 0;
+    double m_box_sum = 0;
+
+    Index<float> m_gains;
+    Index<audio_sample> m_silence;
+    RingBuf<audio_sample> m_delay;
+};
+
+#endif
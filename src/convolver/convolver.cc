@@ -0,0 +1,402 @@
+/*
+ * Convolution Plugin for Audacious
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <atomic>
+#include <pthread.h>
+#include <stdint.h>
+
+#include <sndfile.h>
+
+#include <libaudcore/audstrings.h>
+#include <libaudcore/i18n.h>
+#include <libaudcore/plugin.h>
+#include <libaudcore/preferences.h>
+#include <libaudcore/runtime.h>
+#include <libaudcore/threads.h>
+#include <libaudcore/vfs.h>
+
+#include "../effect-common/params.h"
+#include "../sndfile-common/vfs-io.h"
+
+#include "partition.h"
+
+#define MAX_IR_TIME 10 /* seconds */
+
+static void ir_changed ();
+static void levels_changed ();
+
+static const char * const convolver_defaults[] = {
+    "file", "",
+    "block", "1024",
+    "wet", "100",
+    "dry", "0",
+    nullptr
+};
+
+static const PreferencesWidget convolver_widgets[] = {
+    WidgetLabel (N_("<b>Impulse Response</b>")),
+    WidgetFileEntry (N_("File:"),
+        WidgetString ("convolver", "file", ir_changed),
+        {FileSelectMode::File}),
+    WidgetSpin (N_("Wet level:"),
+        WidgetInt ("convolver", "wet", levels_changed),
+        {0, 200, 1, "%"}),
+    WidgetSpin (N_("Dry level:"),
+        WidgetInt ("convolver", "dry", levels_changed),
+        {0, 200, 1, "%"}),
+    WidgetLabel (N_("<b>Latency</b>")),
+    WidgetSpin (N_("Partition size:"),
+        WidgetInt ("convolver", "block"),
+        {64, 8192, 64, N_("samples")}),
+    WidgetLabel (N_("Takes effect at the next song."))
+};
+
+static const PluginPreferences convolver_prefs = {{convolver_widgets}};
+
+static const char convolver_about[] =
+ N_("Convolution Plugin for Audacious\n\n"
+    "Applies a measured impulse response (WAV, FLAC, or any other format "
+    "supported by libsndfile), for reverb or room correction.");
+
+class ConvolverPlugin : public EffectPlugin
+{
+public:
+    static constexpr PluginInfo info = {
+        N_("Convolver"),
+        PACKAGE,
+        convolver_about,
+        & convolver_prefs
+    };
+
+    constexpr ConvolverPlugin () : EffectPlugin (info, 0, true) {}
+
+    bool init ();
+    void cleanup ();
+
+    void start (int & channels, int & rate);
+    Index<audio_sample> & process (Index<audio_sample> & data);
+    bool flush (bool force);
+    Index<audio_sample> & finish (Index<audio_sample> & data, bool end_of_playlist);
+    int adjust_delay (int delay);
+};
+
+EXPORT ConvolverPlugin aud_plugin_instance;
+
+static Convolver convolver;
+static Index<audio_sample> output;
+static int current_channels, current_rate;
+
+struct Levels {
+    float wet, dry;
+};
+
+static void read_levels (Levels & levels)
+{
+    levels.wet = aud_get_int ("convolver", "wet") / 100.0f;
+    levels.dry = aud_get_int ("convolver", "dry") / 100.0f;
+}
+
+static EffectParams<Levels> levels_params (read_levels);
+
+static void levels_changed ()
+{
+    effect_settings_changed ("convolver");
+}
+
+/* The impulse response is loaded and transformed by a separate thread, since
+ * reading and decoding a long file can take much longer than one buffer of
+ * audio.  Requests are picked up by the thread under the mutex; finished
+ * kernels are passed back to the audio thread through an atomic pointer. */
+
+static pthread_t loader_thread;
+static aud::mutex mutex;
+static aud::condvar cond;
+static bool loader_quit, load_requested;
+static String request_uri;
+static int request_rate, request_block;
+
+static std::atomic<Kernel *> loaded_kernel;
+
+static bool read_ir (const char * uri, Index<float> & samples, int & channels, int & rate)
+{
+    VFSFile file (uri, "r");
+    if (! file)
+    {
+        AUDERR ("Cannot open %s: %s.\n", uri, file.error ());
+        return false;
+    }
+
+    SF_INFO info {}; // must be zeroed before sf_open()
+    SNDFILE * sndfile = sf_open_virtual (& vfs_sndfile_io, SFM_READ, & info, & file);
+    if (! sndfile)
+    {
+        AUDERR ("Cannot read impulse response %s: %s.\n", uri, sf_strerror (nullptr));
+        return false;
+    }
+
+    channels = info.channels;
+    rate = info.samplerate;
+
+    sf_count_t frames = aud::min (info.frames, (sf_count_t) MAX_IR_TIME * rate);
+
+    samples.resize (frames * channels);
+    frames = sf_readf_float (sndfile, samples.begin (), frames);
+    samples.remove (frames * channels, -1);
+
+    sf_close (sndfile);
+    return frames > 0;
+}
+
+/* Impulse responses are normally recorded at the playback rate; if not, linear
+ * interpolation is good enough for a reverb tail. */
+static void resample_ir (Index<float> & samples, int channels, int from, int to)
+{
+    int frames = samples.len () / channels;
+    int new_frames = aud::rescale<int64_t> (frames, from, to);
+
+    Index<float> resampled;
+    resampled.resize (new_frames * channels);
+
+    double ratio = (double) from / to;
+    float scale = (float) to / from; /* keep the energy the same */
+
+    for (int f = 0; f < new_frames; f ++)
+    {
+        double pos = f * ratio;
+        int i = (int) pos;
+        float t = pos - i;
+        int j = aud::min (i + 1, frames - 1);
+
+        for (int c = 0; c < channels; c ++)
+        {
+            float a = samples[i * channels + c];
+            float b = samples[j * channels + c];
+            resampled[f * channels + c] = (a + (b - a) * t) * scale;
+        }
+    }
+
+    samples = std::move (resampled);
+}
+
+static Kernel * load_kernel (const char * uri, int rate, int block)
+{
+    Kernel * kernel = new Kernel;
+    kernel->uri = String (uri);
+    kernel->rate = rate;
+    kernel->block = block;
+
+    Index<float> samples;
+    int ir_channels, ir_rate;
+
+    /* an empty kernel tells the audio thread to stop convolving */
+    if (! uri[0] || ! read_ir (uri, samples, ir_channels, ir_rate))
+        return kernel;
+
+    if (ir_rate != rate)
+        resample_ir (samples, ir_channels, ir_rate, rate);
+
+    if (! kernel->build (samples.begin (), samples.len () / ir_channels, ir_channels, block))
+        kernel->parts = 0;
+
+    return kernel;
+}
+
+static void * loader (void *)
+{
+    auto mh = mutex.take ();
+
+    while (! loader_quit)
+    {
+        if (! load_requested)
+        {
+            cond.wait (mh);
+            continue;
+        }
+
+        String uri = request_uri;
+        int rate = request_rate;
+        int block = request_block;
+        load_requested = false;
+
+        mh.unlock ();
+        Kernel * kernel = load_kernel (uri, rate, block);
+        mh.lock ();
+
+        /* a newer request supersedes this one */
+        if (load_requested)
+            delete kernel;
+        else
+            delete loaded_kernel.exchange (kernel);
+    }
+
+    return nullptr;
+}
+
+static void request_load (const char * uri, int rate, int block)
+{
+    auto mh = mutex.take ();
+
+    request_uri = String (uri);
+    request_rate = rate;
+    request_block = block;
+    load_requested = true;
+
+    cond.notify_all ();
+}
+
+static void ir_changed ()
+{
+    int rate, block;
+
+    {
+        auto mh = mutex.take ();
+        rate = request_rate;
+        block = request_block;
+    }
+
+    if (rate && block)
+        request_load (aud_get_str ("convolver", "file"), rate, block);
+}
+
+static int get_block ()
+{
+    int size = aud::clamp (aud_get_int ("convolver", "block"), 64, 8192);
+
+    /* round up to a power of two */
+    int block = 64;
+    while (block < size)
+        block <<= 1;
+
+    return block;
+}
+
+bool ConvolverPlugin::init ()
+{
+    aud_config_set_defaults ("convolver", convolver_defaults);
+    levels_params.update ();
+    levels_params.watch ("convolver");
+
+    loader_quit = false;
+    load_requested = false;
+    pthread_create (& loader_thread, nullptr, loader, nullptr);
+
+    return true;
+}
+
+void ConvolverPlugin::cleanup ()
+{
+    levels_params.unwatch ("convolver");
+
+    {
+        auto mh = mutex.take ();
+        loader_quit = true;
+        cond.notify_all ();
+    }
+
+    pthread_join (loader_thread, nullptr);
+
+    request_uri = String ();
+    request_rate = request_block = 0;
+    delete loaded_kernel.exchange (nullptr);
+
+    convolver.clear ();
+    output.clear ();
+}
+
+void ConvolverPlugin::start (int & channels, int & rate)
+{
+    int block = get_block ();
+    String uri = aud_get_str ("convolver", "file");
+
+    current_channels = channels;
+    current_rate = rate;
+
+    convolver.start (channels, rate, block);
+
+    const Levels & levels = levels_params.get ();
+    convolver.reset_levels (levels.wet, levels.dry);
+
+    const Kernel * kernel = convolver.kernel ();
+
+    if (! kernel || kernel->rate != rate || strcmp_safe (kernel->uri, uri))
+    {
+        /* a response at the wrong rate would play back at the wrong pitch */
+        if (kernel && kernel->rate != rate)
+            convolver.set_kernel (SmartPtr<Kernel> ());
+
+        request_load (uri, rate, block);
+    }
+}
+
+static void update ()
+{
+    Kernel * kernel = loaded_kernel.exchange (nullptr);
+
+    if (kernel)
+    {
+        if (kernel->parts && kernel->rate == current_rate)
+            convolver.set_kernel (SmartPtr<Kernel> (kernel));
+        else
+        {
+            if (! kernel->parts)
+                convolver.set_kernel (SmartPtr<Kernel> ());
+
+            delete kernel;
+        }
+    }
+
+    const Levels & levels = levels_params.get ();
+    convolver.set_levels (levels.wet, levels.dry);
+}
+
+Index<audio_sample> & ConvolverPlugin::process (Index<audio_sample> & data)
+{
+    update ();
+
+    output.resize (0);
+    convolver.process (data.begin (), data.len () / current_channels, output);
+
+    return output;
+}
+
+bool ConvolverPlugin::flush (bool force)
+{
+    convolver.flush ();
+    return true;
+}
+
+Index<audio_sample> & ConvolverPlugin::finish (Index<audio_sample> & data, bool end_of_playlist)
+{
+    update ();
+
+    output.resize (0);
+    convolver.process (data.begin (), data.len () / current_channels, output);
+
+    /* between songs, the block stays held back so that gapless playback is
+     * not interrupted */
+    if (end_of_playlist)
+        convolver.drain (output);
+
+    return output;
+}
+
+int ConvolverPlugin::adjust_delay (int delay)
+{
+    return delay + aud::rescale<int64_t> (convolver.block (), current_rate, 1000);
+}
@@ -0,0 +1,163 @@
+/*
+ * Convolution Plugin for Audacious
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "fft.h"
+
+void RealFFT::init (int size)
+{
+    if (size == m_size)
+        return;
+
+    m_size = size;
+    m_half = size / 2;
+
+    int bits = 0;
+    while ((1 << bits) < m_half)
+        bits ++;
+
+    m_bitrev.resize (m_half);
+    for (int i = 0; i < m_half; i ++)
+    {
+        int r = 0;
+        for (int b = 0; b < bits; b ++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+
+        m_bitrev[i] = r;
+    }
+
+    m_twiddle.resize (m_half);
+    for (int i = 0; i < m_half / 2; i ++)
+    {
+        m_twiddle[2 * i] = cos (2 * M_PI * i / m_half);
+        m_twiddle[2 * i + 1] = -sin (2 * M_PI * i / m_half);
+    }
+
+    m_post.resize (2 * (m_half + 1));
+    for (int k = 0; k <= m_half; k ++)
+    {
+        m_post[2 * k] = cos (2 * M_PI * k / size);
+        m_post[2 * k + 1] = -sin (2 * M_PI * k / size);
+    }
+
+    m_work.resize (2 * m_half);
+}
+
+/* in-place iterative radix-2 FFT of m_half interleaved complex values */
+void RealFFT::transform (float * data, bool inverse)
+{
+    for (int i = 0; i < m_half; i ++)
+    {
+        int j = m_bitrev[i];
+        if (j > i)
+        {
+            float t0 = data[2 * i], t1 = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = t0;
+            data[2 * j + 1] = t1;
+        }
+    }
+
+    float sign = inverse ? -1 : 1;
+
+    for (int len = 2; len <= m_half; len <<= 1)
+    {
+        int half = len / 2;
+        int step = m_half / len;
+
+        for (int i = 0; i < m_half; i += len)
+        {
+            float * a = data + 2 * i;
+            float * b = a + 2 * half;
+
+            for (int j = 0; j < half; j ++)
+            {
+                float wr = m_twiddle[2 * j * step];
+                float wi = m_twiddle[2 * j * step + 1] * sign;
+
+                float tr = wr * b[2 * j] - wi * b[2 * j + 1];
+                float ti = wr * b[2 * j + 1] + wi * b[2 * j];
+
+                b[2 * j] = a[2 * j] - tr;
+                b[2 * j + 1] = a[2 * j + 1] - ti;
+                a[2 * j] += tr;
+                a[2 * j + 1] += ti;
+            }
+        }
+    }
+}
+
+void RealFFT::forward (const float * in, float * re, float * im)
+{
+    float * z = m_work.begin ();
+
+    /* even samples become the real part, odd samples the imaginary part */
+    memcpy (z, in, sizeof (float) * m_size);
+    transform (z, false);
+
+    for (int k = 0; k <= m_half; k ++)
+    {
+        int a = (k == m_half) ? 0 : k;
+        int b = (k == 0) ? 0 : m_half - k;
+
+        /* even = (Z[k] + conj(Z[M-k])) / 2, odd = (Z[k] - conj(Z[M-k])) / 2i */
+        float er = (z[2 * a] + z[2 * b]) * 0.5f;
+        float ei = (z[2 * a + 1] - z[2 * b + 1]) * 0.5f;
+        float or_ = (z[2 * a + 1] + z[2 * b + 1]) * 0.5f;
+        float oi = (z[2 * b] - z[2 * a]) * 0.5f;
+
+        float wr = m_post[2 * k], wi = m_post[2 * k + 1];
+
+        re[k] = er + wr * or_ - wi * oi;
+        im[k] = ei + wr * oi + wi * or_;
+    }
+}
+
+void RealFFT::inverse (const float * re, const float * im, float * out)
+{
+    float * z = m_work.begin ();
+
+    for (int k = 0; k < m_half; k ++)
+    {
+        int b = m_half - k;
+
+        /* the factors of 2 are folded into the final scaling */
+        float er = re[k] + re[b];
+        float ei = im[k] - im[b];
+        float dr = re[k] - re[b];
+        float di = im[k] + im[b];
+
+        /* multiply the odd part by conj(W^k) */
+        float wr = m_post[2 * k], wi = -m_post[2 * k + 1];
+        float or_ = dr * wr - di * wi;
+        float oi = dr * wi + di * wr;
+
+        z[2 * k] = er - oi;
+        z[2 * k + 1] = ei + or_;
+    }
+
+    transform (z, true);
+
+    float scale = 1.0f / m_size;
+    for (int i = 0; i < m_size; i ++)
+        out[i] = z[i] * scale;
+}
@@ -0,0 +1,50 @@
+/*
+ * Convolution Plugin for Audacious
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef CONVOLVER_FFT_H
+#define CONVOLVER_FFT_H
+
+#include <libaudcore/index.h>
+
+/* Real-input FFT of a power-of-two size, computed as a complex FFT of half the
+ * size.  Spectra are kept in split form (separate real and imaginary arrays of
+ * size / 2 + 1 bins), which is what the multiply-accumulate loops want. */
+class RealFFT
+{
+public:
+    void init (int size);
+    int size () const
+        { return m_size; }
+
+    void forward (const float * in, float * re, float * im);
+
+    /* includes the 1 / size scaling */
+    void inverse (const float * re, const float * im, float * out);
+
+private:
+    void transform (float * data, bool inverse);
+
+    int m_size = 0, m_half = 0;
+    Index<int> m_bitrev;
+    Index<float> m_twiddle; /* for the half-size complex FFT */
+    Index<float> m_post;    /* for splitting/merging the real spectrum */
+    Index<float> m_work;
+};
+
+#endif
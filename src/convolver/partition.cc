@@ -0,0 +1,268 @@
+/*
+ * Convolution Plugin for Audacious
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <string.h>
+
+#include "partition.h"
+
+#define LEVEL_TIME 0.05f /* seconds */
+
+bool Kernel::build (const float * ir, int frames, int channels_, int block_)
+{
+    if (frames <= 0 || channels_ <= 0)
+        return false;
+
+    block = block_;
+    channels = channels_;
+    parts = (frames + block - 1) / block;
+
+    int bins = block + 1;
+    re.resize (channels * parts * bins);
+    im.resize (channels * parts * bins);
+
+    RealFFT fft;
+    fft.init (2 * block);
+
+    Index<float> padded;
+    padded.resize (2 * block);
+
+    for (int c = 0; c < channels; c ++)
+    {
+        for (int p = 0; p < parts; p ++)
+        {
+            int start = p * block;
+            int len = aud::min (block, frames - start);
+
+            padded.erase (0, -1);
+            for (int i = 0; i < len; i ++)
+                padded[i] = ir[(start + i) * channels + c];
+
+            int offset = (c * parts + p) * bins;
+            fft.forward (padded.begin (), & re[offset], & im[offset]);
+        }
+    }
+
+    return true;
+}
+
+/* acc += a * b, over split complex arrays */
+static void mac (float * __restrict acc_re, float * __restrict acc_im,
+ const float * __restrict a_re, const float * __restrict a_im,
+ const float * __restrict b_re, const float * __restrict b_im, int bins)
+{
+    for (int i = 0; i < bins; i ++)
+    {
+        acc_re[i] += a_re[i] * b_re[i] - a_im[i] * b_im[i];
+        acc_im[i] += a_re[i] * b_im[i] + a_im[i] * b_re[i];
+    }
+}
+
+/* Called for each song; unless the format has changed, the block and the tail
+ * held back by finish () carry over into it. */
+void Convolver::start (int channels, int rate, int block)
+{
+    m_wet.setup (LEVEL_TIME, rate);
+    m_dry.setup (LEVEL_TIME, rate);
+
+    if (channels != m_channels || block != m_block)
+    {
+        m_channels = channels;
+        m_block = block;
+
+        m_fft.init (2 * block);
+        m_input.resize (2 * block * channels);
+        m_output.resize (block * channels);
+        m_acc_re.resize (block + 1);
+        m_acc_im.resize (block + 1);
+        m_time.resize (2 * block);
+        m_wet_gain.resize (block);
+        m_dry_gain.resize (block);
+
+        if (m_kernel && m_kernel->block != block)
+            m_kernel.clear ();
+
+        alloc_fdl ();
+        flush ();
+    }
+}
+
+void Convolver::set_kernel (SmartPtr<Kernel> && kernel)
+{
+    if (kernel && kernel->block != m_block)
+        kernel.clear ();
+
+    m_kernel = std::move (kernel);
+
+    /* a new kernel starts with an empty delay line; this only happens when the
+     * impulse response is changed, so the discontinuity is acceptable */
+    alloc_fdl ();
+}
+
+void Convolver::alloc_fdl ()
+{
+    int size = m_kernel ? m_channels * m_kernel->parts * (m_block + 1) : 0;
+
+    m_fdl_re.resize (size);
+    m_fdl_im.resize (size);
+    m_fdl_re.erase (0, -1);
+    m_fdl_im.erase (0, -1);
+    m_fdl_pos = 0;
+}
+
+void Convolver::flush ()
+{
+    m_input.erase (0, -1);
+    m_output.erase (0, -1);
+    m_fdl_re.erase (0, -1);
+    m_fdl_im.erase (0, -1);
+    m_fill = 0;
+    m_fdl_pos = 0;
+}
+
+void Convolver::clear ()
+{
+    m_channels = m_block = 0;
+    m_kernel.clear ();
+
+    m_input.clear ();
+    m_output.clear ();
+    m_fdl_re.clear ();
+    m_fdl_im.clear ();
+    m_acc_re.clear ();
+    m_acc_im.clear ();
+    m_time.clear ();
+    m_wet_gain.clear ();
+    m_dry_gain.clear ();
+}
+
+void Convolver::run_block ()
+{
+    int bins = m_block + 1;
+
+    if (! m_kernel)
+    {
+        /* no impulse response (yet), so pass the input through with the same
+         * delay as when convolving */
+        for (int c = 0; c < m_channels; c ++)
+        {
+            const float * in = & m_input[(2 * c + 1) * m_block];
+            for (int f = 0; f < m_block; f ++)
+                m_output[f * m_channels + c] = in[f];
+        }
+    }
+    else
+    {
+        int parts = m_kernel->parts;
+
+        m_wet.fill (m_wet_gain.begin (), m_block);
+        m_dry.fill (m_dry_gain.begin (), m_block);
+
+        for (int c = 0; c < m_channels; c ++)
+        {
+            float * in = & m_input[2 * c * m_block];
+            float * fdl_re = & m_fdl_re[c * parts * bins];
+            float * fdl_im = & m_fdl_im[c * parts * bins];
+
+            int kc = c % m_kernel->channels;
+            const float * k_re = & m_kernel->re[kc * parts * bins];
+            const float * k_im = & m_kernel->im[kc * parts * bins];
+
+            m_fft.forward (in, & fdl_re[m_fdl_pos * bins], & fdl_im[m_fdl_pos * bins]);
+
+            m_acc_re.erase (0, -1);
+            m_acc_im.erase (0, -1);
+
+            /* partition p of the response meets the input from p blocks ago */
+            for (int p = 0; p < parts; p ++)
+            {
+                int slot = m_fdl_pos - p;
+                if (slot < 0)
+                    slot += parts;
+
+                mac (m_acc_re.begin (), m_acc_im.begin (), & fdl_re[slot * bins],
+                 & fdl_im[slot * bins], & k_re[p * bins], & k_im[p * bins], bins);
+            }
+
+            m_fft.inverse (m_acc_re.begin (), m_acc_im.begin (), m_time.begin ());
+
+            /* overlap-save: only the second half is free of wrap-around */
+            const float * wet = & m_time[m_block];
+            const float * dry = & in[m_block];
+
+            for (int f = 0; f < m_block; f ++)
+                m_output[f * m_channels + c] = wet[f] * m_wet_gain[f] + dry[f] * m_dry_gain[f];
+        }
+
+        m_fdl_pos = (m_fdl_pos + 1) % parts;
+    }
+
+    for (int c = 0; c < m_channels; c ++)
+    {
+        float * in = & m_input[2 * c * m_block];
+        memcpy (in, in + m_block, sizeof (float) * m_block);
+    }
+}
+
+void Convolver::process (const audio_sample * data, int frames, Index<audio_sample> & out)
+{
+    while (frames)
+    {
+        int n = aud::min (frames, m_block - m_fill);
+
+        for (int c = 0; c < m_channels; c ++)
+        {
+            float * in = & m_input[(2 * c + 1) * m_block + m_fill];
+            for (int f = 0; f < n; f ++)
+                in[f] = data[f * m_channels + c];
+        }
+
+        /* the output of the previous block goes out as the input comes in */
+        out.insert (& m_output[m_fill * m_channels], -1, n * m_channels);
+
+        m_fill += n;
+        data += n * m_channels;
+        frames -= n;
+
+        if (m_fill == m_block)
+        {
+            run_block ();
+            m_fill = 0;
+        }
+    }
+}
+
+void Convolver::drain (Index<audio_sample> & out)
+{
+    int held = m_fill;
+    int tail = m_kernel ? m_kernel->parts : 0;
+
+    /* completing the block with silence pushes out the rest of the previous
+     * block; each further block of silence pushes out one more block of the
+     * response, until the delay line has drained; after that, only as many
+     * frames as were actually received in the last block */
+    Index<audio_sample> silence;
+    silence.insert (0, m_block * m_channels);
+
+    process (silence.begin (), m_block - m_fill, out);
+    for (int i = 0; i < tail; i ++)
+        process (silence.begin (), m_block, out);
+
+    out.insert (m_output.begin (), -1, held * m_channels);
+    flush ();
+}
@@ -0,0 +1,104 @@
+/*
+ * Convolution Plugin for Audacious
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef CONVOLVER_PARTITION_H
+#define CONVOLVER_PARTITION_H
+
+#include <libaudcore/index.h>
+#include <libaudcore/objects.h>
+#include <libaudcore/plugin.h>
+
+#include "../effect-common/smoothing.h"
+
+#include "fft.h"
+
+/* An impulse response cut into partitions of <block> frames, each transformed
+ * to the frequency domain (block + 1 bins, zero-padded to 2 * block).  Built
+ * off the audio thread, then handed over to the convolver. */
+struct Kernel
+{
+    String uri;
+    int rate = 0, block = 0;
+    int channels = 0, parts = 0;
+    Index<float> re, im; /* [channel][part][bin] */
+
+    /* <ir> is interleaved; returns false if it is empty */
+    bool build (const float * ir, int frames, int channels, int block);
+};
+
+/* Uniformly partitioned overlap-save convolution.  Each block of input is
+ * transformed once and kept in a frequency-domain delay line, so the cost per
+ * block is one forward and one inverse FFT per channel plus a multiply-add
+ * over all the partitions.  Output lags input by exactly one block. */
+class Convolver
+{
+public:
+    void start (int channels, int rate, int block);
+    void set_kernel (SmartPtr<Kernel> && kernel);
+
+    /* The wet and dry levels move to new settings over a short time, so that
+     * changing them does not click; reset_levels() jumps to them. */
+    void set_levels (float wet, float dry)
+    {
+        m_wet.set_target (wet);
+        m_dry.set_target (dry);
+    }
+    void reset_levels (float wet, float dry)
+    {
+        m_wet.reset (wet);
+        m_dry.reset (dry);
+    }
+
+    /* Appends the processed audio to <out>. */
+    void process (const audio_sample * data, int frames, Index<audio_sample> & out);
+
+    /* Pushes the block still held back to <out>, followed by the rest of the
+     * response to it (the reverb tail). */
+    void drain (Index<audio_sample> & out);
+
+    void flush ();
+    void clear ();
+
+    int block () const
+        { return m_block; }
+    const Kernel * kernel () const
+        { return m_kernel.get (); }
+
+private:
+    void alloc_fdl ();
+    void run_block ();
+
+    int m_channels = 0, m_block = 0;
+    LinearSmoother m_wet, m_dry;
+    Index<float> m_wet_gain, m_dry_gain; /* one block */
+
+    SmartPtr<Kernel> m_kernel;
+    RealFFT m_fft;
+
+    Index<float> m_input;  /* [channel][2 * block], previous and current block */
+    Index<audio_sample> m_output; /* one block, interleaved */
+    int m_fill = 0;
+
+    Index<float> m_fdl_re, m_fdl_im; /* [channel][part][bin] */
+    int m_fdl_pos = 0;
+
+    Index<float> m_acc_re, m_acc_im, m_time;
+};
+
+#endif
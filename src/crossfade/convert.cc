@@ -0,0 +1,379 @@
+/*
+ * Crossfade Plugin for Audacious
+ * Copyright 2010-2014 John Lindgren
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <math.h>
+
+#include <libaudcore/audio.h>
+
+#include "convert.h"
+#include "ramp.h"
+
+/* The filter is 32 taps wide at the output rate, widened proportionally when
+ * downsampling so that the transition band stays the same in output terms.
+ * PHASES sub-sample positions are tabulated and interpolated between. */
+#define BASE_TAPS 32
+#define MAX_TAPS 256
+#define PHASES 128
+#define PASSBAND 0.95
+
+/* output is produced in chunks of this many frames */
+#define CHUNK_FRAMES 1024
+
+/* WAVE channel order, as used throughout Audacious */
+enum {
+    POS_FL, POS_FR, POS_FC, POS_LFE, POS_BL, POS_BR, POS_BC, POS_SL, POS_SR,
+    POS_MONO, POS_OTHER
+};
+
+static const char layouts[][AUD_MAX_CHANNELS] = {
+    {POS_MONO},
+    {POS_FL, POS_FR},
+    {POS_FL, POS_FR, POS_FC},
+    {POS_FL, POS_FR, POS_BL, POS_BR},
+    {POS_FL, POS_FR, POS_FC, POS_BL, POS_BR},
+    {POS_FL, POS_FR, POS_FC, POS_LFE, POS_BL, POS_BR},
+    {POS_FL, POS_FR, POS_FC, POS_LFE, POS_BC, POS_SL, POS_SR},
+    {POS_FL, POS_FR, POS_FC, POS_LFE, POS_BL, POS_BR, POS_SL, POS_SR}
+};
+
+static int channel_pos (int channels, int c)
+{
+    int known = aud::n_elements (layouts);
+
+    if (channels > known)
+        return (c < known) ? layouts[known - 1][c] : POS_OTHER;
+
+    return layouts[channels - 1][c];
+}
+
+static int find_channel (int channels, int pos)
+{
+    for (int c = 0; c < channels; c ++)
+    {
+        if (channel_pos (channels, c) == pos)
+            return c;
+    }
+
+    return -1;
+}
+
+/* Adds <gain> to the matrix entry from <in_c> to the output channel at
+ * position <pos>, returning false if there is no such output channel. */
+static bool route (float * matrix, int in_channels, int out_channels,
+ int in_c, int pos, float gain)
+{
+    int out_c = find_channel (out_channels, pos);
+    if (out_c < 0)
+        return false;
+
+    matrix[out_c * in_channels + in_c] += gain;
+    return true;
+}
+
+static void build_matrix (float * matrix, int in_channels, int out_channels)
+{
+    const float half = 0.5f, root_half = sqrtf (0.5f);
+
+    for (int i = 0; i < in_channels * out_channels; i ++)
+        matrix[i] = 0;
+
+    if (out_channels == 1)
+    {
+        /* mono is the average of the stereo downmix */
+        float stereo[2 * AUD_MAX_CHANNELS];
+        build_matrix (stereo, in_channels, 2);
+
+        for (int c = 0; c < in_channels; c ++)
+            matrix[c] = half * (stereo[c] + stereo[in_channels + c]);
+
+        return;
+    }
+
+    for (int c = 0; c < in_channels; c ++)
+    {
+        int pos = channel_pos (in_channels, c);
+
+        if (route (matrix, in_channels, out_channels, c, pos, 1))
+            continue;
+
+        auto route_pair = [&] (int left, int right, float gain) {
+            int target = (pos == POS_BR || pos == POS_SR) ? right : left;
+            return route (matrix, in_channels, out_channels, c, target, gain);
+        };
+
+        switch (pos)
+        {
+        case POS_MONO:
+            route (matrix, in_channels, out_channels, c, POS_FL, 1);
+            route (matrix, in_channels, out_channels, c, POS_FR, 1);
+            break;
+
+        case POS_FC:
+            route (matrix, in_channels, out_channels, c, POS_FL, root_half);
+            route (matrix, in_channels, out_channels, c, POS_FR, root_half);
+            break;
+
+        case POS_BL:
+        case POS_BR:
+            route_pair (POS_SL, POS_SR, 1) ||
+             route_pair (POS_FL, POS_FR, root_half);
+            break;
+
+        case POS_SL:
+        case POS_SR:
+            route_pair (POS_BL, POS_BR, 1) ||
+             route_pair (POS_FL, POS_FR, root_half);
+            break;
+
+        case POS_BC:
+            if (find_channel (out_channels, POS_BL) >= 0)
+            {
+                route (matrix, in_channels, out_channels, c, POS_BL, root_half);
+                route (matrix, in_channels, out_channels, c, POS_BR, root_half);
+            }
+            else if (find_channel (out_channels, POS_SL) >= 0)
+            {
+                route (matrix, in_channels, out_channels, c, POS_SL, root_half);
+                route (matrix, in_channels, out_channels, c, POS_SR, root_half);
+            }
+            else
+            {
+                route (matrix, in_channels, out_channels, c, POS_FL, half);
+                route (matrix, in_channels, out_channels, c, POS_FR, half);
+            }
+            break;
+
+        default:
+            /* LFE and unknown channels are dropped */
+            break;
+        }
+    }
+}
+
+void Converter::setup_matrix ()
+{
+    m_mix = (m_in_channels != m_out_channels);
+    if (! m_mix)
+        return;
+
+    m_matrix.resize (m_in_channels * m_out_channels);
+    build_matrix (m_matrix.begin (), m_in_channels, m_out_channels);
+}
+
+void Converter::setup_filter ()
+{
+    if (m_in_rate == m_out_rate ||
+     (m_in_rate == m_filter_in_rate && m_out_rate == m_filter_out_rate))
+        return;
+
+    double cutoff = PASSBAND * aud::min (1.0, (double) m_out_rate / m_in_rate);
+    int half = aud::min ((int) ceil (BASE_TAPS / 2 / cutoff), MAX_TAPS / 2);
+
+    m_filter_in_rate = m_in_rate;
+    m_filter_out_rate = m_out_rate;
+    m_filter_taps = half * 2;
+
+    m_filter.resize ((PHASES + 1) * m_filter_taps);
+    m_taps.resize (m_filter_taps);
+
+    for (int p = 0; p <= PHASES; p ++)
+    {
+        float * row = & m_filter[p * m_filter_taps];
+        double sum = 0;
+
+        for (int k = 0; k < m_filter_taps; k ++)
+        {
+            /* distance from the output position, in input frames */
+            double d = k - half + 1 - (double) p / PHASES;
+            double x = M_PI * cutoff * d;
+            double sinc = (x == 0) ? 1 : sin (x) / x;
+            double u = M_PI * d / half;
+            double window = 0.42 + 0.5 * cos (u) + 0.08 * cos (2 * u);
+
+            row[k] = sinc * window;
+            sum += row[k];
+        }
+
+        for (int k = 0; k < m_filter_taps; k ++)
+            row[k] /= sum;
+    }
+}
+
+void Converter::start (RingBuf<audio_sample> & buffer, int in_channels,
+ int in_rate, int out_channels, int out_rate)
+{
+    /* the storage from the last conversion is reused */
+    m_input.resize (0);
+    buffer.move_out (m_input, -1, -1);
+
+    m_in_channels = in_channels;
+    m_in_rate = in_rate;
+    m_out_channels = out_channels;
+    m_out_rate = out_rate;
+
+    m_in_frames = m_input.len () / in_channels;
+    m_out_pos = 0;
+    m_out_frames = (int64_t) m_in_frames * out_rate / in_rate;
+
+    setup_matrix ();
+    setup_filter ();
+}
+
+void Converter::ramp (float a, float b)
+{
+    if (! pending ())
+        return;
+
+    int done = (int64_t) m_out_pos * m_in_rate / m_out_rate;
+    done = aud::min (done, m_in_frames);
+
+    ramp_apply (& m_input[done * m_in_channels],
+     (m_in_frames - done) * m_in_channels, a, b);
+}
+
+void Converter::filter_frame (int64_t pos, float frac, float * acc)
+{
+    int taps = m_filter_taps;
+    int channels = m_in_channels;
+
+    float phase = frac * PHASES;
+    int p = aud::min ((int) phase, PHASES - 1);
+    float t = phase - p;
+
+    const float * h0 = & m_filter[p * taps];
+    const float * h1 = h0 + taps;
+    float * h = m_taps.begin ();
+
+    for (int k = 0; k < taps; k ++)
+        h[k] = h0[k] + (h1[k] - h0[k]) * t;
+
+    for (int c = 0; c < channels; c ++)
+        acc[c] = 0;
+
+    int first = pos - taps / 2 + 1;
+
+    if (first >= 0 && first + taps <= m_in_frames)
+    {
+        const audio_sample * in = & m_input[first * channels];
+
+        for (int k = 0; k < taps; k ++)
+        {
+            for (int c = 0; c < channels; c ++)
+                acc[c] += in[c] * h[k];
+
+            in += channels;
+        }
+    }
+    else
+    {
+        /* near the edges, hold the first/last frame */
+        for (int k = 0; k < taps; k ++)
+        {
+            int f = aud::clamp (first + k, 0, m_in_frames - 1);
+            const audio_sample * in = & m_input[f * channels];
+
+            for (int c = 0; c < channels; c ++)
+                acc[c] += in[c] * h[k];
+        }
+    }
+}
+
+void Converter::convert (audio_sample * dest, int frames)
+{
+    float acc[AUD_MAX_CHANNELS];
+
+    for (int f = 0; f < frames; f ++)
+    {
+        int64_t num = (int64_t) m_out_pos * m_in_rate;
+        int64_t pos = num / m_out_rate;
+
+        if (m_in_rate == m_out_rate)
+        {
+            const audio_sample * in = & m_input[pos * m_in_channels];
+            for (int c = 0; c < m_in_channels; c ++)
+                acc[c] = in[c];
+        }
+        else
+            filter_frame (pos, (float) (num % m_out_rate) / m_out_rate, acc);
+
+        if (m_mix)
+        {
+            const float * row = m_matrix.begin ();
+
+            for (int o = 0; o < m_out_channels; o ++)
+            {
+                float sum = 0;
+                for (int c = 0; c < m_in_channels; c ++)
+                    sum += row[c] * acc[c];
+
+                dest[o] = sum;
+                row += m_in_channels;
+            }
+        }
+        else
+        {
+            for (int c = 0; c < m_out_channels; c ++)
+                dest[c] = acc[c];
+        }
+
+        dest += m_out_channels;
+        m_out_pos ++;
+    }
+}
+
+void Converter::produce (RingBuf<audio_sample> & out, int frames)
+{
+    frames = aud::min (frames, pending ());
+    if (frames <= 0)
+        return;
+
+    if (m_scratch.len () < CHUNK_FRAMES * m_out_channels)
+        m_scratch.resize (CHUNK_FRAMES * m_out_channels);
+
+    while (frames > 0)
+    {
+        int chunk = aud::min (frames, CHUNK_FRAMES);
+
+        convert (m_scratch.begin (), chunk);
+        out.copy_in (m_scratch.begin (), chunk * m_out_channels);
+
+        frames -= chunk;
+    }
+
+    if (! pending ())
+        m_input.resize (0);
+}
+
+void Converter::discard ()
+{
+    m_input.resize (0);
+    m_in_frames = m_out_pos = m_out_frames = 0;
+}
+
+void Converter::clear ()
+{
+    m_input.clear ();
+    m_scratch.clear ();
+    m_matrix.clear ();
+    m_filter.clear ();
+    m_taps.clear ();
+
+    m_filter_in_rate = m_filter_out_rate = 0;
+    m_in_frames = m_out_pos = m_out_frames = 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * Crossfade Plugin for Audacious
+ * Copyright 2010-2014 John Lindgren
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef CROSSFADE_CONVERT_H
+#define CROSSFADE_CONVERT_H
+
+#include <stdint.h>
+#include <libaudcore/index.h>
+#include <libaudcore/plugin.h>
+#include <libaudcore/ringbuf.h>
+
+/* Converts the buffered end of the previous song to the format of the next one.
+ * Conversion is done on demand, so that the cost is spread over the fade rather
+ * than paid all at once when the new song starts.  Resampling uses a windowed
+ * sinc filter (interpolated polyphase table); channels are converted through a
+ * mixing matrix that follows the usual WAVE channel order. */
+class Converter
+{
+public:
+    /* Takes over the contents of <buffer>, which is left empty. */
+    void start (RingBuf<audio_sample> & buffer, int in_channels, int in_rate,
+     int out_channels, int out_rate);
+
+    /* Number of output frames not yet produced. */
+    int pending () const
+        { return m_out_frames - m_out_pos; }
+
+    /* Applies a gain ramp (see ramp_apply) to the unconverted input. */
+    void ramp (float a, float b);
+
+    /* Appends up to <frames> converted frames to <out>, which must have enough
+     * space for them. */
+    void produce (RingBuf<audio_sample> & out, int frames);
+
+    /* Drops the unconverted input but keeps the allocated storage. */
+    void discard ();
+
+    void clear ();
+
+private:
+    void setup_matrix ();
+    void setup_filter ();
+    void filter_frame (int64_t pos, float frac, float * acc);
+    void convert (audio_sample * dest, int frames);
+
+    Index<audio_sample> m_input, m_scratch;
+    Index<float> m_matrix, m_filter, m_taps;
+
+    int m_in_channels = 0, m_in_rate = 0;
+    int m_out_channels = 0, m_out_rate = 0;
+    int m_filter_in_rate = 0, m_filter_out_rate = 0;
+    int m_filter_taps = 0;
+    bool m_mix = false;
+
+    int m_in_frames = 0;
+    int m_out_pos = 0, m_out_frames = 0;
+};
+
+#endif
@@ -17,12 +17,15 @@
  * the use of this software.
  */
 
-#include <math.h>
 #include <libaudcore/i18n.h>
 #include <libaudcore/plugin.h>
 #include <libaudcore/preferences.h>
+#include <libaudcore/ringbuf.h>
 #include <libaudcore/runtime.h>
 
+#include "convert.h"
+#include "ramp.h"
+
 enum
 {
     STATE_OFF,
@@ -103,90 +106,125 @@ EXPORT Crossfade aud_plugin_instance;
 
 static char state = STATE_OFF;
 static int current_channels, current_rate;
-static Index<audio_sample> buffer, output;
+static RingBuf<audio_sample> buffer;
+static Index<audio_sample> output, scratch;
 static int fadein_point;
+static Converter converter;
+
+/* settings are read once per song (in start) rather than in the audio path */
+static struct {
+    bool automatic, manual, no_fade_in;
+    double length, manual_length;
+} config;
+
+static void load_config ()
+{
+    config.automatic = aud_get_bool ("crossfade", "automatic");
+    config.manual = aud_get_bool ("crossfade", "manual");
+    config.no_fade_in = aud_get_bool ("crossfade", "no_fade_in");
+    config.length = aud_get_double ("crossfade", "length");
+    config.manual_length = aud_get_double ("crossfade", "manual_length");
+
+    if (aud_get_bool ("crossfade", "use_sigmoid"))
+        ramp_set_curve (aud_get_double ("crossfade", "sigmoid_steepness"));
+    else
+        ramp_set_curve (0);
+}
 
 bool Crossfade::init ()
 {
     aud_config_set_defaults ("crossfade", crossfade_defaults);
+    ramp_init ();
     return true;
 }
 
 void Crossfade::cleanup ()
 {
     state = STATE_OFF;
-    buffer.clear ();
+    buffer.destroy ();
     output.clear ();
+    scratch.clear ();
+    converter.clear ();
+}
+
+/* Length of the buffer, including the part still waiting to be converted
+ * from the previous song's format. */
+static int buffer_len ()
+{
+    return buffer.len () + converter.pending () * current_channels;
 }
 
-static void do_linear_ramp (audio_sample * data, int length, float a, float b)
+/* The buffer only ever grows, so once playback has settled no more memory is
+ * allocated in the audio path. */
+static void buffer_reserve (int len)
 {
-    for (int i = 0; i < length; i ++)
-        (* data ++) *= (a * (length - i) + b * i) / length;
+    if (buffer.space () < len)
+        buffer.alloc (aud::max (buffer.size () * 2, buffer.len () + len));
 }
 
-static void do_sigmoid_ramp (audio_sample * data, int length, float a, float b)
+static void buffer_append (const audio_sample * data, int len)
 {
-    float steepness = aud_get_double ("crossfade", "sigmoid_steepness");
-    for (int i = 0; i < length; i ++)
+    buffer_reserve (len);
+    buffer.copy_in (data, len);
+}
+
+/* Calls func (pointer, offset, length) on each contiguous part of the range
+ * [pos, pos + len) of the buffer.  The ring buffer stores its contents in at
+ * most two parts: [0, linear) and [linear, len). */
+template<class F>
+static void buffer_foreach (int pos, int len, F func)
+{
+    int done = 0;
+
+    while (done < len)
     {
-        float linear = (a * (length - i) + b * i) / length;
-        (* data ++) *= 0.5f + 0.5f * tanhf (steepness * (linear - 0.5f));
+        int at = pos + done;
+        int end = (at < buffer.linear ()) ? buffer.linear () : buffer.len ();
+        int part = aud::min (len - done, end - at);
+
+        func (& buffer[at], done, part);
+        done += part;
     }
 }
 
-static void do_ramp (audio_sample * data, int length, float a, float b)
+/* Applies a gain ramp from a to b to the range [pos, pos + len). */
+static void buffer_ramp (int pos, int len, float a, float b)
 {
-    if (aud_get_bool ("crossfade", "use_sigmoid"))
-        do_sigmoid_ramp (data, length, a, b);
-    else
-        do_linear_ramp (data, length, a, b);
+    buffer_foreach (pos, len, [=] (audio_sample * data, int offset, int part) {
+        ramp_apply (data, part, a + (b - a) * offset / len,
+         a + (b - a) * (offset + part) / len);
+    });
 }
 
-static void mix (audio_sample * data, audio_sample * add, int length)
+static void convert (int frames)
 {
-    while (length --)
-        (* data ++) += (* add ++);
+    buffer_reserve (aud::min (frames, converter.pending ()) * current_channels);
+    converter.produce (buffer, frames);
+}
+
+static void convert_all ()
+{
+    convert (converter.pending ());
 }
 
-/* stupid simple resampling/rechanneling algorithm */
 static void reformat (int channels, int rate)
 {
     if (channels == current_channels && rate == current_rate)
         return;
 
-    int old_frames = buffer.len () / current_channels;
-    int new_frames = (int64_t) old_frames * rate / current_rate;
-
-    int map[AUD_MAX_CHANNELS];
-    for (int c = 0; c < channels; c ++)
-        map[c] = c * current_channels / channels;
-
-    Index<audio_sample> new_buffer;
-    new_buffer.resize (new_frames * channels);
-
-    for (int f = 0; f < new_frames; f ++)
-    {
-        int f0 = (int64_t) f * current_rate / rate;
-        int s0 = f0 * current_channels;
-        int s = f * channels;
-
-        for (int c = 0; c < channels; c ++)
-            new_buffer[s + c] = buffer[s0 + map[c]];
-    }
-
-    buffer = std::move (new_buffer);
+    convert_all ();
+    converter.start (buffer, current_channels, current_rate, channels, rate);
 }
 
 static int buffer_needed_for_state ()
 {
     double overlap = 0;
 
-    if (state != STATE_FLUSHED && aud_get_bool ("crossfade", "automatic"))
-        overlap = aud_get_double ("crossfade", "length");
+    if (state != STATE_FLUSHED && config.automatic)
+        overlap = config.length;
 
-    if (state != STATE_FINISHED && aud_get_bool ("crossfade", "manual"))
-        overlap = aud::max (overlap, aud_get_double ("crossfade", "manual_length"));
+    if (state != STATE_FINISHED && config.manual)
+        overlap = aud::max (overlap, config.manual_length);
 
     return current_channels * (int) (current_rate * overlap);
 }
@@ -197,11 +235,13 @@ static void output_data_as_ready (int buffer_needed, bool exact)
 
     /* if allowed, wait until we have at least 1/2 second ready to output */
     if (exact ? (copy > 0) : (copy >= current_channels * (current_rate / 2)))
-        output.move_from (buffer, 0, -1, copy, true, true);
+        buffer.move_out (output, -1, copy);
 }
 
 void Crossfade::start (int & channels, int & rate)
 {
+    load_config ();
+
     if (state != STATE_OFF)
         reformat (channels, rate);
 
@@ -210,10 +250,14 @@ void Crossfade::start (int & channels, int & rate)
 
     if (state == STATE_OFF)
     {
-        if (aud_get_bool ("crossfade", "manual"))
+        if (config.manual)
         {
             state = STATE_FLUSHED;
-            buffer.insert (0, buffer_needed_for_state ());
+
+            int silence = buffer_needed_for_state ();
+            buffer_reserve (silence);
+            for (int i = 0; i < silence; i ++)
+                buffer.push (0);
         }
         else
             state = STATE_RUNNING;
@@ -222,33 +266,49 @@ void Crossfade::start (int & channels, int & rate)
 
 static void run_fadeout ()
 {
-    do_ramp (buffer.begin (), buffer.len (), 1.0, 0.0);
+    int converted = buffer.len ();
+    int length = buffer_len ();
+    float split = length ? 1 - (float) converted / length : 0;
+
+    buffer_ramp (0, converted, 1.0, split);
+    converter.ramp (split, 0.0);
 
     state = STATE_FADEIN;
     fadein_point = 0;
 }
 
-static void run_fadein (Index<audio_sample> & data)
+/* returns the number of samples of data used */
+static int run_fadein (Index<audio_sample> & data)
 {
-    int length = buffer.len ();
+    int length = buffer_len ();
+    int copy = 0;
 
     if (fadein_point < length)
     {
-        int copy = aud::min (data.len (), length - fadein_point);
+        copy = aud::min (data.len (), length - fadein_point);
         float a = (float) fadein_point / length;
         float b = (float) (fadein_point + copy) / length;
 
-        if (! aud_get_bool ("crossfade", "no_fade_in"))
-            do_ramp (data.begin (), copy, a, b);
+        /* convert just as much of the old song as we are about to mix into */
+        convert ((fadein_point + copy - buffer.len ()) / current_channels);
+
+        audio_sample * in = data.begin ();
 
-        mix (& buffer[fadein_point], data.begin (), copy);
-        data.remove (0, copy);
+        buffer_foreach (fadein_point, copy, [=] (audio_sample * mix, int offset, int part) {
+            if (config.no_fade_in)
+                ramp_mix (mix, in + offset, part);
+            else
+                ramp_apply (in + offset, part, a + (b - a) * offset / copy,
+                 a + (b - a) * (offset + part) / copy, mix);
+        });
 
         fadein_point += copy;
     }
 
     if (fadein_point == length)
         state = STATE_RUNNING;
+
+    return copy;
 }
 
 Index<audio_sample> & Crossfade::process (Index<audio_sample> & data)
@@ -258,15 +318,17 @@ Index<audio_sample> & Crossfade::process (Index<audio_sample> & data)
 
     output.resize (0);
 
+    int used = 0;
+
     if (state == STATE_FINISHED || state == STATE_FLUSHED)
         run_fadeout ();
 
     if (state == STATE_FADEIN)
-        run_fadein (data);
+        used = run_fadein (data);
 
     if (state == STATE_RUNNING)
     {
-        buffer.insert (data.begin (), -1, data.len ());
+        buffer_append (& data[used], data.len () - used);
         output_data_as_ready (buffer_needed_for_state (), false);
     }
 
@@ -278,18 +340,28 @@ bool Crossfade::flush (bool force)
     if (state == STATE_OFF)
         return true;
 
-    if (! force && aud_get_bool ("crossfade", "manual"))
+    if (! force && config.manual)
     {
+        convert_all ();
+
         state = STATE_FLUSHED;
         int buffer_needed = buffer_needed_for_state ();
         if (buffer.len () > buffer_needed)
-            buffer.remove (buffer_needed, -1);
+        {
+            /* keep the oldest data; the ring buffer can only be trimmed at
+             * the head, so take it out and put it back */
+            scratch.resize (0);
+            buffer.move_out (scratch, -1, buffer_needed);
+            buffer.discard ();
+            buffer.copy_in (scratch.begin (), buffer_needed);
+        }
 
         return false;
     }
 
     state = STATE_RUNNING;
-    buffer.resize (0);
+    buffer.discard ();
+    converter.discard ();
 
     return true;
 }
@@ -301,18 +373,22 @@ Index<audio_sample> & Crossfade::finish (Index<audio_sample> & data, bool end_of
 
     output.resize (0);
 
+    int used = 0;
+
     if (state == STATE_FADEIN)
-        run_fadein (data);
+        used = run_fadein (data);
+
+    convert_all ();
 
     if (state == STATE_RUNNING || state == STATE_FINISHED || state == STATE_FLUSHED)
     {
-        buffer.insert (data.begin (), -1, data.len ());
+        buffer_append (& data[used], data.len () - used);
         output_data_as_ready (buffer_needed_for_state (), state != STATE_RUNNING);
     }
 
     if (state == STATE_FADEIN || state == STATE_RUNNING)
     {
-        if (aud_get_bool ("crossfade", "automatic"))
+        if (config.automatic)
         {
             state = STATE_FINISHED;
             output_data_as_ready (buffer_needed_for_state (), true);
@@ -326,7 +402,7 @@ Index<audio_sample> & Crossfade::finish (Index<audio_sample> & data, bool end_of
 
     if (end_of_playlist && (state == STATE_FINISHED || state == STATE_FLUSHED))
     {
-        do_ramp (buffer.begin (), buffer.len (), 1.0, 0.0);
+        buffer_ramp (0, buffer.len (), 1.0, 0.0);
 
         state = STATE_OFF;
         output_data_as_ready (0, true);
@@ -337,5 +413,5 @@ Index<audio_sample> & Crossfade::finish (Index<audio_sample> & data, bool end_of
 
 int Crossfade::adjust_delay (int delay)
 {
-    return delay + aud::rescale<int64_t> (buffer.len () / current_channels, current_rate, 1000);
+    return delay + aud::rescale<int64_t> (buffer_len () / current_channels, current_rate, 1000);
 }
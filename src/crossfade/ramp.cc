@@ -0,0 +1,268 @@
+/*
+ * Crossfade Plugin for Audacious
+ * Copyright 2010-2014 John Lindgren
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <math.h>
+
+#include "ramp.h"
+
+/* The SIMD kernels only handle 32-bit floats. */
+#ifndef DEF_AUDIO_FLOAT64
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define RAMP_SSE2
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define RAMP_AVX2
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RAMP_NEON
+#endif
+#endif
+
+/* The S-curve is sampled at CURVE_SIZE + 1 points and linearly interpolated.
+ * Ramps are split into segments of RAMP_SEGMENT samples; within a segment the
+ * gain is linear in the sample index, so the kernels only need a start gain and
+ * a step.  The gain at each segment boundary is computed in double precision,
+ * so rounding errors do not accumulate over long ramps. */
+#define CURVE_SIZE 1024
+#define RAMP_SEGMENT 64
+
+typedef void (* RampFunc) (audio_sample * data, int length, float gain, float step);
+typedef void (* RampMixFunc) (audio_sample * dest, const audio_sample * src,
+ int length, float gain, float step);
+
+static float curve[CURVE_SIZE + 1];
+static float curve_steepness = -1;
+
+static void ramp_scalar (audio_sample * data, int length, float gain, float step)
+{
+    for (int i = 0; i < length; i ++)
+        data[i] *= gain + step * i;
+}
+
+static void ramp_mix_scalar (audio_sample * dest, const audio_sample * src,
+ int length, float gain, float step)
+{
+    for (int i = 0; i < length; i ++)
+        dest[i] += src[i] * (gain + step * i);
+}
+
+#ifdef RAMP_SSE2
+static void ramp_sse2 (float * data, int length, float gain, float step)
+{
+    __m128 vgain = _mm_set1_ps (gain);
+    __m128 vstep = _mm_set1_ps (step);
+    __m128 vidx = _mm_setr_ps (0, 1, 2, 3);
+    __m128 vinc = _mm_set1_ps (4);
+
+    int i = 0;
+    for (; i + 4 <= length; i += 4)
+    {
+        __m128 g = _mm_add_ps (vgain, _mm_mul_ps (vstep, vidx));
+        _mm_storeu_ps (data + i, _mm_mul_ps (_mm_loadu_ps (data + i), g));
+        vidx = _mm_add_ps (vidx, vinc);
+    }
+
+    ramp_scalar (data + i, length - i, gain + step * i, step);
+}
+
+static void ramp_mix_sse2 (float * dest, const float * src, int length,
+ float gain, float step)
+{
+    __m128 vgain = _mm_set1_ps (gain);
+    __m128 vstep = _mm_set1_ps (step);
+    __m128 vidx = _mm_setr_ps (0, 1, 2, 3);
+    __m128 vinc = _mm_set1_ps (4);
+
+    int i = 0;
+    for (; i + 4 <= length; i += 4)
+    {
+        __m128 g = _mm_add_ps (vgain, _mm_mul_ps (vstep, vidx));
+        __m128 s = _mm_mul_ps (_mm_loadu_ps (src + i), g);
+        _mm_storeu_ps (dest + i, _mm_add_ps (_mm_loadu_ps (dest + i), s));
+        vidx = _mm_add_ps (vidx, vinc);
+    }
+
+    ramp_mix_scalar (dest + i, src + i, length - i, gain + step * i, step);
+}
+#endif
+
+#ifdef RAMP_AVX2
+__attribute__ ((target ("avx2")))
+static void ramp_avx2 (float * data, int length, float gain, float step)
+{
+    __m256 vgain = _mm256_set1_ps (gain);
+    __m256 vstep = _mm256_set1_ps (step);
+    __m256 vidx = _mm256_setr_ps (0, 1, 2, 3, 4, 5, 6, 7);
+    __m256 vinc = _mm256_set1_ps (8);
+
+    int i = 0;
+    for (; i + 8 <= length; i += 8)
+    {
+        __m256 g = _mm256_add_ps (vgain, _mm256_mul_ps (vstep, vidx));
+        _mm256_storeu_ps (data + i, _mm256_mul_ps (_mm256_loadu_ps (data + i), g));
+        vidx = _mm256_add_ps (vidx, vinc);
+    }
+
+    ramp_scalar (data + i, length - i, gain + step * i, step);
+}
+
+__attribute__ ((target ("avx2")))
+static void ramp_mix_avx2 (float * dest, const float * src, int length,
+ float gain, float step)
+{
+    __m256 vgain = _mm256_set1_ps (gain);
+    __m256 vstep = _mm256_set1_ps (step);
+    __m256 vidx = _mm256_setr_ps (0, 1, 2, 3, 4, 5, 6, 7);
+    __m256 vinc = _mm256_set1_ps (8);
+
+    int i = 0;
+    for (; i + 8 <= length; i += 8)
+    {
+        __m256 g = _mm256_add_ps (vgain, _mm256_mul_ps (vstep, vidx));
+        __m256 s = _mm256_mul_ps (_mm256_loadu_ps (src + i), g);
+        _mm256_storeu_ps (dest + i, _mm256_add_ps (_mm256_loadu_ps (dest + i), s));
+        vidx = _mm256_add_ps (vidx, vinc);
+    }
+
+    ramp_mix_scalar (dest + i, src + i, length - i, gain + step * i, step);
+}
+#endif
+
+#ifdef RAMP_NEON
+static void ramp_neon (float * data, int length, float gain, float step)
+{
+    static const float idx[4] = {0, 1, 2, 3};
+
+    float32x4_t vgain = vdupq_n_f32 (gain);
+    float32x4_t vidx = vld1q_f32 (idx);
+    float32x4_t vinc = vdupq_n_f32 (4);
+
+    int i = 0;
+    for (; i + 4 <= length; i += 4)
+    {
+        float32x4_t g = vmlaq_n_f32 (vgain, vidx, step);
+        vst1q_f32 (data + i, vmulq_f32 (vld1q_f32 (data + i), g));
+        vidx = vaddq_f32 (vidx, vinc);
+    }
+
+    ramp_scalar (data + i, length - i, gain + step * i, step);
+}
+
+static void ramp_mix_neon (float * dest, const float * src, int length,
+ float gain, float step)
+{
+    static const float idx[4] = {0, 1, 2, 3};
+
+    float32x4_t vgain = vdupq_n_f32 (gain);
+    float32x4_t vidx = vld1q_f32 (idx);
+    float32x4_t vinc = vdupq_n_f32 (4);
+
+    int i = 0;
+    for (; i + 4 <= length; i += 4)
+    {
+        float32x4_t g = vmlaq_n_f32 (vgain, vidx, step);
+        vst1q_f32 (dest + i, vmlaq_f32 (vld1q_f32 (dest + i), vld1q_f32 (src + i), g));
+        vidx = vaddq_f32 (vidx, vinc);
+    }
+
+    ramp_mix_scalar (dest + i, src + i, length - i, gain + step * i, step);
+}
+#endif
+
+static RampFunc ramp_func = ramp_scalar;
+static RampMixFunc ramp_mix_func = ramp_mix_scalar;
+
+void ramp_init ()
+{
+    ramp_func = ramp_scalar;
+    ramp_mix_func = ramp_mix_scalar;
+
+#ifdef RAMP_SSE2
+    ramp_func = ramp_sse2;
+    ramp_mix_func = ramp_mix_sse2;
+#endif
+#ifdef RAMP_AVX2
+    if (__builtin_cpu_supports ("avx2"))
+    {
+        ramp_func = ramp_avx2;
+        ramp_mix_func = ramp_mix_avx2;
+    }
+#endif
+#ifdef RAMP_NEON
+    ramp_func = ramp_neon;
+    ramp_mix_func = ramp_mix_neon;
+#endif
+}
+
+void ramp_set_curve (float steepness)
+{
+    if (steepness == curve_steepness)
+        return;
+
+    curve_steepness = steepness;
+
+    for (int i = 0; i <= CURVE_SIZE; i ++)
+    {
+        float linear = (float) i / CURVE_SIZE;
+        if (steepness > 0)
+            curve[i] = 0.5f + 0.5f * tanhf (steepness * (linear - 0.5f));
+        else
+            curve[i] = linear;
+    }
+}
+
+static float curve_gain (double linear)
+{
+    if (curve_steepness <= 0)
+        return linear;
+
+    double pos = aud::clamp (linear, 0.0, 1.0) * CURVE_SIZE;
+    int i = aud::min ((int) pos, CURVE_SIZE - 1);
+    float frac = pos - i;
+
+    return curve[i] + (curve[i + 1] - curve[i]) * frac;
+}
+
+void ramp_apply (audio_sample * data, int length, float a, float b,
+ audio_sample * mix_into)
+{
+    float gain = curve_gain (a);
+
+    for (int pos = 0; pos < length; pos += RAMP_SEGMENT)
+    {
+        int seg = aud::min (length - pos, RAMP_SEGMENT);
+        float next = curve_gain (a + (double) (b - a) * (pos + seg) / length);
+        float step = (next - gain) / seg;
+
+        if (mix_into)
+            ramp_mix_func (mix_into + pos, data + pos, seg, gain, step);
+        else
+            ramp_func (data + pos, seg, gain, step);
+
+        gain = next;
+    }
+}
+
+void ramp_mix (audio_sample * data, const audio_sample * add, int length)
+{
+    ramp_mix_func (data, add, length, 1, 0);
+}
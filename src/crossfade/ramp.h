@@ -0,0 +1,42 @@
+/*
+ * Crossfade Plugin for Audacious
+ * Copyright 2010-2014 John Lindgren
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef CROSSFADE_RAMP_H
+#define CROSSFADE_RAMP_H
+
+#include <libaudcore/plugin.h>
+
+/* Selects the fastest kernels supported by the CPU.  Must be called once
+ * before any of the functions below. */
+void ramp_init ();
+
+/* Rebuilds the S-curve lookup table if the steepness has changed.  Passing a
+ * steepness of zero selects a plain linear fade. */
+void ramp_set_curve (float steepness);
+
+/* Multiplies <length> samples by a gain that moves from <a> to <b> along the
+ * selected curve.  If <mix_into> is given, the scaled samples are instead added
+ * to it and <data> is left untouched. */
+void ramp_apply (audio_sample * data, int length, float a, float b,
+ audio_sample * mix_into = nullptr);
+
+/* Adds <length> samples of <add> to <data>. */
+void ramp_mix (audio_sample * data, const audio_sample * add, int length);
+
+#endif
@@ -18,19 +18,43 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <string.h>
+
 #include <libaudcore/i18n.h>
 #include <libaudcore/runtime.h>
 #include <libaudcore/plugin.h>
 #include <libaudcore/preferences.h>
 
+#include "../effect-common/params.h"
+#include "../effect-common/smoothing.h"
+
+/* The SIMD kernel only handles 32-bit floats. */
+#ifndef DEF_AUDIO_FLOAT64
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define CRYST_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CRYST_NEON
+#endif
+#endif
+
+#define SMOOTH_TIME 0.05f /* seconds */
+#define CHUNK 256         /* frames */
+
 static const char * const cryst_defaults[] = {
  "intensity", "1",
  nullptr};
 
+static void settings_changed ()
+{
+    effect_settings_changed ("crystalizer");
+}
+
 static const PreferencesWidget cryst_widgets[] = {
     WidgetLabel (N_("<b>Crystalizer</b>")),
     WidgetSpin (N_("Intensity:"),
-        WidgetFloat ("crystalizer", "intensity"),
+        WidgetFloat ("crystalizer", "intensity", settings_changed),
         {0, 10, 0.1})
 };
 
@@ -58,41 +82,109 @@ public:
 
 EXPORT Crystalizer aud_plugin_instance;
 
+static void read_intensity (float & intensity)
+{
+    intensity = aud_get_double ("crystalizer", "intensity");
+}
+
+static EffectParams<float> cryst_params (read_intensity);
+static LinearSmoother cryst_intensity;
+
 static int cryst_channels;
-static Index<audio_sample> cryst_prev;
+
+/* The input of a chunk, after the last frame of the chunk before: so each
+ * sample has the one before it <cryst_channels> samples back. */
+static Index<audio_sample> cryst_input;
 
 bool Crystalizer::init ()
 {
     aud_config_set_defaults ("crystalizer", cryst_defaults);
+    cryst_params.update ();
+    cryst_params.watch ("crystalizer");
     return true;
 }
 
 void Crystalizer::cleanup ()
 {
-    cryst_prev.clear ();
+    cryst_params.unwatch ("crystalizer");
+    cryst_input.clear ();
 }
 
 void Crystalizer::start (int & channels, int & rate)
 {
     cryst_channels = channels;
-    cryst_prev.resize (cryst_channels);
-    cryst_prev.erase (0, cryst_channels);
+    cryst_input.resize ((CHUNK + 1) * cryst_channels);
+    cryst_input.erase (0, cryst_channels);
+
+    cryst_intensity.setup (SMOOTH_TIME, rate);
+    cryst_intensity.reset (cryst_params.get ());
+}
+
+/* out = in + (in - prev) * intensity, with the intensity fixed; there is no
+ * recurrence, so the samples are independent whatever the channels */
+static void cryst_block (audio_sample * out, const audio_sample * in,
+ const audio_sample * prev, int samples, float intensity)
+{
+    int i = 0;
+
+#if defined(CRYST_SSE2)
+    const __m128 value = _mm_set1_ps (intensity);
+
+    for (; i + 4 <= samples; i += 4)
+    {
+        __m128 current = _mm_loadu_ps (in + i);
+        __m128 diff = _mm_sub_ps (current, _mm_loadu_ps (prev + i));
+        _mm_storeu_ps (out + i, _mm_add_ps (current, _mm_mul_ps (diff, value)));
+    }
+#elif defined(CRYST_NEON)
+    for (; i + 4 <= samples; i += 4)
+    {
+        float32x4_t current = vld1q_f32 (in + i);
+        float32x4_t diff = vsubq_f32 (current, vld1q_f32 (prev + i));
+        vst1q_f32 (out + i, vaddq_f32 (current, vmulq_n_f32 (diff, intensity)));
+    }
+#endif
+
+    for (; i < samples; i ++)
+        out[i] = in[i] + (in[i] - prev[i]) * intensity;
 }
 
 Index<audio_sample> & Crystalizer::process (Index<audio_sample> & data)
 {
-    float value = aud_get_double ("crystalizer", "intensity");
+    cryst_intensity.set_target (cryst_params.get ());
+
     audio_sample * f = data.begin ();
-    const audio_sample * end = data.end ();
+    int frames = data.len () / cryst_channels;
+    float value[CHUNK];
 
-    while (f < end)
+    audio_sample * prev = cryst_input.begin ();
+    audio_sample * in = prev + cryst_channels;
+
+    while (frames)
     {
-        for (int channel = 0; channel < cryst_channels; channel ++)
+        int chunk = aud::min (frames, CHUNK);
+        int samples = chunk * cryst_channels;
+        bool gliding = ! cryst_intensity.settled ();
+
+        cryst_intensity.fill (value, chunk);
+        memcpy (in, f, sizeof (audio_sample) * samples);
+
+        if (gliding)
         {
-            audio_sample current = * f;
-            * f ++ = current + (current - cryst_prev[channel]) * value;
-            cryst_prev[channel] = current;
+            for (int i = 0, s = 0; i < chunk; i ++)
+            {
+                for (int channel = 0; channel < cryst_channels; channel ++, s ++)
+                    f[s] = in[s] + (in[s] - prev[s]) * value[i];
+            }
         }
+        else
+            cryst_block (f, in, prev, samples, value[0]);
+
+        /* the last frame is the one before the next chunk */
+        memcpy (prev, prev + samples, sizeof (audio_sample) * cryst_channels);
+
+        f += samples;
+        frames -= chunk;
     }
 
     return data;
@@ -100,6 +192,6 @@ Index<audio_sample> & Crystalizer::process (Index<audio_sample> & data)
 
 bool Crystalizer::flush (bool force)
 {
-    cryst_prev.erase (0, cryst_channels);
+    cryst_input.erase (0, cryst_channels);
     return true;
 }
@@ -1,9 +1,16 @@
+#include <math.h>
+
 #include <libaudcore/i18n.h>
 #include <libaudcore/runtime.h>
 #include <libaudcore/plugin.h>
 #include <libaudcore/preferences.h>
 
+#include "../effect-common/params.h"
+#include "../effect-common/smoothing.h"
+
 #define MAX_DELAY 1000
+#define MAX_DEPTH 20      /* ms */
+#define SMOOTH_TIME 0.05f /* seconds */
 
 static const char echo_about[] =
  N_("Echo Plugin\n"
@@ -15,19 +22,42 @@ static const char * const echo_defaults[] = {
  "delay", "500",
  "feedback", "50",
  "volume", "50",
+ "mod_depth", "0",
+ "mod_rate", "0.5",
+ "tape", "FALSE",
+ "tone", "4000",
  nullptr};
 
+static void settings_changed ()
+{
+    effect_settings_changed ("echo_plugin");
+}
+
 static const PreferencesWidget echo_widgets[] = {
     WidgetLabel (N_("<b>Echo</b>")),
     WidgetSpin (N_("Delay:"),
-        WidgetInt ("echo_plugin", "delay"),
+        WidgetInt ("echo_plugin", "delay", settings_changed),
         {0, MAX_DELAY, 10, N_("ms")}),
     WidgetSpin (N_("Feedback:"),
-        WidgetInt ("echo_plugin", "feedback"),
+        WidgetInt ("echo_plugin", "feedback", settings_changed),
         {0, 100, 1, "%"}),
     WidgetSpin (N_("Volume:"),
-        WidgetInt ("echo_plugin", "volume"),
-        {0, 100, 1, "%"})
+        WidgetInt ("echo_plugin", "volume", settings_changed),
+        {0, 100, 1, "%"}),
+    WidgetLabel (N_("<b>Modulation</b>")),
+    WidgetSpin (N_("Depth:"),
+        WidgetFloat ("echo_plugin", "mod_depth", settings_changed),
+        {0, MAX_DEPTH, 0.5, N_("ms")}),
+    WidgetSpin (N_("Rate:"),
+        WidgetFloat ("echo_plugin", "mod_rate", settings_changed),
+        {0.1, 10, 0.1, N_("Hz")}),
+    WidgetLabel (N_("<b>Character</b>")),
+    WidgetCheck (N_("Tape-style feedback"),
+        WidgetBool ("echo_plugin", "tape", settings_changed)),
+    WidgetSpin (N_("Tone:"),
+        WidgetInt ("echo_plugin", "tone", settings_changed),
+        {500, 16000, 100, N_("Hz")},
+        WIDGET_CHILD)
 };
 
 static const PluginPreferences echo_prefs = {{echo_widgets}};
@@ -53,62 +83,242 @@ public:
 
 EXPORT EchoPlugin aud_plugin_instance;
 
+/* The delay line holds a power of two number of frames, so that positions can
+ * be wrapped with a mask.  Delay, volume, and feedback glide towards their
+ * settings instead of jumping, and the delay is not limited to whole frames, so
+ * that moving the delay slider does not click. */
+
+struct EchoConfig {
+    int delay, feedback, volume;
+    float mod_depth, mod_rate;
+    bool tape;
+    int tone;
+};
+
+static void read_config (EchoConfig & config)
+{
+    config.delay = aud_get_int ("echo_plugin", "delay");
+    config.feedback = aud_get_int ("echo_plugin", "feedback");
+    config.volume = aud_get_int ("echo_plugin", "volume");
+    config.mod_depth = aud_get_double ("echo_plugin", "mod_depth");
+    config.mod_rate = aud_get_double ("echo_plugin", "mod_rate");
+    config.tape = aud_get_bool ("echo_plugin", "tape");
+    config.tone = aud_get_int ("echo_plugin", "tone");
+}
+
+static EffectParams<EchoConfig> echo_params (read_config);
+
 static Index<audio_sample> buffer;
+static Index<audio_sample> tape_state;
+static int buffer_mask;
 static int w_ofs;
 
+/* snapping once the difference is inaudible */
+static ExpSmoother cur_delay (0.001f); /* in frames */
+static ExpSmoother cur_depth (0.001f); /* in frames */
+static ExpSmoother cur_feedback (0.0001f);
+static ExpSmoother cur_volume (0.0001f);
+static float lfo_phase;
+
 bool EchoPlugin::init ()
 {
     aud_config_set_defaults ("echo_plugin", echo_defaults);
+    echo_params.update ();
+    echo_params.watch ("echo_plugin");
     return true;
 }
 
 void EchoPlugin::cleanup ()
 {
+    echo_params.unwatch ("echo_plugin");
     buffer.clear ();
+    tape_state.clear ();
 }
 
 static int echo_channels = 0;
 static int echo_rate = 0;
 
+static float target_delay (const EchoConfig & config)
+{
+    float delay = config.delay * echo_rate / 1000.0f;
+
+    /* at least one frame, so that the frame being written is never read */
+    return aud::max (delay, 1.0f);
+}
+
+static float target_depth (const EchoConfig & config)
+{
+    return config.mod_depth * echo_rate / 1000.0f;
+}
+
 void EchoPlugin::start (int & channels, int & rate)
 {
+    const EchoConfig & config = echo_params.get ();
+
     if (channels != echo_channels || rate != echo_rate)
     {
         echo_channels = channels;
         echo_rate = rate;
 
-        buffer.resize (aud::rescale (MAX_DELAY, 1000, rate) * channels);
+        int frames = 1;
+        while (frames < aud::rescale (MAX_DELAY + MAX_DEPTH, 1000, rate) + 2)
+            frames <<= 1;
+
+        buffer.resize (frames * channels);
         buffer.erase (0, -1);
+        buffer_mask = frames - 1;
+
+        tape_state.resize (channels);
+        tape_state.erase (0, -1);
 
         w_ofs = 0;
+        lfo_phase = 0;
+
+        cur_delay.setup (SMOOTH_TIME, rate);
+        cur_depth.setup (SMOOTH_TIME, rate);
+        cur_feedback.setup (SMOOTH_TIME, rate);
+        cur_volume.setup (SMOOTH_TIME, rate);
+
+        cur_delay.reset (target_delay (config));
+        cur_depth.reset (target_depth (config));
+        cur_feedback.reset (config.feedback / 100.0f);
+        cur_volume.reset (config.volume / 100.0f);
     }
 }
 
-Index<audio_sample> & EchoPlugin::process (Index<audio_sample> & data)
+/* One frame at a time, for when the parameters are moving or the feedback is
+ * being filtered. */
+static void process_frames (const EchoConfig & config, audio_sample * data, int frames)
 {
-    int delay = aud_get_int ("echo_plugin", "delay");
-    float feedback = aud_get_int ("echo_plugin", "feedback") / 100.0f;
-    float volume = aud_get_int ("echo_plugin", "volume") / 100.0f;
+    int channels = echo_channels;
+    float lfo_step = 2 * (float) M_PI * config.mod_rate / echo_rate;
+    float tone = config.tape ? 1 - expf (-2 * (float) M_PI * config.tone / echo_rate) : 1;
+
+    for (int f = 0; f < frames; f ++)
+    {
+        /* the modulation is added after smoothing, which would otherwise
+         * flatten it; only its depth glides */
+        float delay = cur_delay.next ();
+        float depth = cur_depth.next ();
+
+        if (depth > 0)
+        {
+            /* the modulation only ever lengthens the delay */
+            delay += depth * 0.5f * (1 - cosf (lfo_phase));
+            lfo_phase += lfo_step;
+            if (lfo_phase > 2 * (float) M_PI)
+                lfo_phase -= 2 * (float) M_PI;
+        }
+
+        float feedback = cur_feedback.next ();
+        float volume = cur_volume.next ();
+
+        int whole = (int) delay;
+        float t = 1 - (delay - whole);
+
+        const audio_sample * a = & buffer[((w_ofs - whole - 1) & buffer_mask) * channels];
+        const audio_sample * b = & buffer[((w_ofs - whole) & buffer_mask) * channels];
+        audio_sample * w = & buffer[w_ofs * channels];
 
-    int interval = aud::rescale (delay, 1000, echo_rate) * echo_channels;
-    interval = aud::clamp (interval, 0, buffer.len ());  // sanity check
+        for (int c = 0; c < channels; c ++)
+        {
+            audio_sample in = data[c];
+            audio_sample echo = a[c] + (b[c] - a[c]) * t;
+            audio_sample fb = echo * feedback;
 
-    int r_ofs = w_ofs - interval;
-    if (r_ofs < 0)
-        r_ofs += buffer.len ();
+            if (config.tape)
+            {
+                /* darken each repeat and round off its peaks */
+                tape_state[c] += (fb - tape_state[c]) * tone;
+                fb = tape_state[c] / (1 + fabs (tape_state[c]) * 0.25f);
+            }
 
-    const audio_sample * end = data.end ();
+            data[c] = in + echo * volume;
+            w[c] = in + fb;
+        }
 
-    for (audio_sample * f = data.begin (); f < end; f++)
+        data += channels;
+        w_ofs = (w_ofs + 1) & buffer_mask;
+    }
+}
+
+/* With everything settled, no frame read within a span of at most <delay>
+ * frames was written within the same span, so the span can be done in
+ * contiguous runs (split where the read or write position wraps around) whose
+ * loops vectorize. */
+static void process_span (audio_sample * data, int frames)
+{
+    int channels = echo_channels;
+    int size = buffer_mask + 1;
+    float delay = cur_delay.target ();
+    int whole = (int) delay;
+    float t = 1 - (delay - whole);
+    float feedback = cur_feedback.target (), volume = cur_volume.target ();
+
+    while (frames)
     {
-        audio_sample in = * f;
-        audio_sample buf = buffer[r_ofs];
+        int w = w_ofs;
+        int ra = (w_ofs - whole - 1) & buffer_mask;
+        int rb = (w_ofs - whole) & buffer_mask;
+
+        int run = aud::min (frames, size - w);
+        run = aud::min (run, size - ra);
+        run = aud::min (run, size - rb);
 
-        * f = in + buf * volume;
-        buffer[w_ofs] = in + buf * feedback;
+        const audio_sample * __restrict a = & buffer[ra * channels];
+        const audio_sample * __restrict b = & buffer[rb * channels];
+        audio_sample * __restrict wp = & buffer[w * channels];
+        audio_sample * __restrict d = data;
+
+        for (int i = 0; i < run * channels; i ++)
+        {
+            audio_sample in = d[i];
+            audio_sample echo = a[i] + (b[i] - a[i]) * t;
+
+            d[i] = in + echo * volume;
+            wp[i] = in + echo * feedback;
+        }
+
+        data += run * channels;
+        frames -= run;
+        w_ofs = (w_ofs + run) & buffer_mask;
+    }
+}
+
+Index<audio_sample> & EchoPlugin::process (Index<audio_sample> & data)
+{
+    const EchoConfig & config = echo_params.get ();
+
+    audio_sample * f = data.begin ();
+    int frames = data.len () / echo_channels;
+
+    cur_delay.set_target (target_delay (config));
+    cur_depth.set_target (target_depth (config));
+    cur_feedback.set_target (config.feedback / 100.0f);
+    cur_volume.set_target (config.volume / 100.0f);
+
+    while (frames)
+    {
+        bool steady = ! config.tape && cur_delay.settled () &&
+         cur_depth.settled () && ! cur_depth.target () &&
+         cur_feedback.settled () && cur_volume.settled ();
 
-        r_ofs = (r_ofs + 1) % buffer.len ();
-        w_ofs = (w_ofs + 1) % buffer.len ();
+        if (steady)
+        {
+            int span = aud::min (frames, (int) cur_delay.target ());
+            process_span (f, span);
+            f += span * echo_channels;
+            frames -= span;
+        }
+        else
+        {
+            /* a short stretch at a time, so the fast path resumes soon after
+             * the parameters settle */
+            int span = aud::min (frames, 64);
+            process_frames (config, f, span);
+            f += span * echo_channels;
+            frames -= span;
+        }
     }
 
     return data;
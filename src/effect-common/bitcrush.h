@@ -0,0 +1,67 @@
+/*
+ * Bit depth reduction for Audacious effect plugins
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef AUDACIOUS_EFFECT_BITCRUSH_H
+#define AUDACIOUS_EFFECT_BITCRUSH_H
+
+#include <math.h>
+
+#include <libaudcore/plugin.h>
+#include <libaudcore/templates.h>
+
+/* The quantizer of the Bitcrusher, shared with the Simple DSP Chain so that
+ * both sound the same.  A sample is boosted by a gain that grows as the bit
+ * depth falls, rounded to a step of the depth, and scaled back. */
+
+struct CrushFactors {
+    audio_sample mul; /* from a sample to steps, with the gain */
+    audio_sample inv; /* and back */
+};
+
+static inline CrushFactors crush_factors (float bit_depth)
+{
+    double scale = pow (2., bit_depth) / 2.;
+    double gain = (33. - bit_depth) / 8.;
+
+    return {(audio_sample) (gain * scale), (audio_sample) (1 / (gain * scale))};
+}
+
+/* floor (x * mul + 0.5), without a division.  For floats, floor() is done as
+ * SSE2 and NEON must do it, so that the Bitcrusher's SIMD kernel gives the very
+ * same result: by truncating to an integer and stepping down for negatives.
+ * From 2^23 on, floats are whole numbers already (and may not fit in an
+ * integer). */
+static inline audio_sample crush_sample (audio_sample x, CrushFactors f)
+{
+#ifdef DEF_AUDIO_FLOAT64
+    return floor (x * f.mul + 0.5) * f.inv;
+#else
+    const float whole = 8388608.0f;
+
+    float steps = x * f.mul;
+    float t = steps + 0.5f;
+    float n = (float) (int) aud::clamp (t, -whole, whole);
+
+    n -= (n > t) ? 1.0f : 0.0f;
+
+    return ((fabsf (steps) < whole) ? n : steps) * f.inv;
+#endif
+}
+
+#endif
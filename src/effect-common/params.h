@@ -0,0 +1,85 @@
+/*
+ * Effect settings for the audio thread, for Audacious plugins
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef AUDACIOUS_EFFECT_PARAMS_H
+#define AUDACIOUS_EFFECT_PARAMS_H
+
+#include <atomic>
+
+#include <libaudcore/audstrings.h>
+#include <libaudcore/hook.h>
+
+/* Settings of a config section are changed on the main thread, and the effect
+ * is told through the "<section> changed" hook.  The preferences widgets of an
+ * effect call this from their callbacks, so that every effect sharing the
+ * section hears of it. */
+static inline void effect_settings_changed (const char * section)
+{
+    hook_call (str_concat ({section, " changed"}), nullptr);
+}
+
+/* The settings of an effect, as a plain struct <T> filled in by a read
+ * function.  They are read on the main thread, whenever a watched section
+ * changes, and handed to the audio thread through a triple buffer, so that
+ * process() picks up the newest ones without locking or looking them up.
+ *
+ * Only one thread may call update() and only one may call get(). */
+template<class T>
+class EffectParams
+{
+public:
+    typedef void (* ReadFunc) (T & params);
+
+    constexpr EffectParams (ReadFunc read) :
+        m_read (read) {}
+
+    /* main thread */
+    void update ()
+    {
+        m_read (m_slots[m_back]);
+        m_back = m_middle.exchange (m_back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    void watch (const char * section)
+        { hook_associate (str_concat ({section, " changed"}), changed, this); }
+    void unwatch (const char * section)
+        { hook_dissociate (str_concat ({section, " changed"}), changed, this); }
+
+    /* audio thread; the settings stay put until the next call */
+    const T & get ()
+    {
+        if (m_middle.load (std::memory_order_relaxed) & FRESH)
+            m_front = m_middle.exchange (m_front, std::memory_order_acq_rel) & INDEX;
+
+        return m_slots[m_front];
+    }
+
+private:
+    static constexpr int INDEX = 3, FRESH = 4;
+
+    static void changed (void *, void * me)
+        { ((EffectParams *) me)->update (); }
+
+    const ReadFunc m_read;
+    T m_slots[3] {};
+    std::atomic<int> m_middle {1};
+    int m_back = 2, m_front = 0;
+};
+
+#endif
@@ -0,0 +1,167 @@
+/*
+ * Parameter smoothing for Audacious effect plugins
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef AUDACIOUS_EFFECT_SMOOTHING_H
+#define AUDACIOUS_EFFECT_SMOOTHING_H
+
+#include <math.h>
+
+#include <libaudcore/templates.h>
+
+/* Smoothers move a parameter to a new setting over a short time instead of in
+ * one step, which would click.  They give one value per frame, either one at a
+ * time with next() or a block at a time with fill(), whose loops vectorize.
+ * Once settled, they give the setting itself, so a steady parameter is used
+ * exactly as set. */
+
+/* moves in a straight line, taking a fixed time for any change */
+class LinearSmoother
+{
+public:
+    void setup (float seconds, int rate)
+        { m_length = aud::max ((int) lroundf (seconds * rate), 1); }
+
+    /* jumps to <value> */
+    void reset (float value)
+    {
+        m_value = m_start = m_target = value;
+        m_done = m_left = 0;
+    }
+
+    void set_target (float target)
+    {
+        if (target == m_target)
+            return;
+
+        m_start = m_value;
+        m_target = target;
+        m_step = (target - m_value) / m_length;
+        m_done = 0;
+        m_left = m_length;
+    }
+
+    float target () const
+        { return m_target; }
+    bool settled () const
+        { return ! m_left; }
+
+    void fill (float * out, int frames)
+    {
+        int ramp = aud::min (frames, m_left);
+
+        for (int i = 0; i < ramp; i ++)
+            out[i] = m_start + m_step * (float) (m_done + i + 1);
+
+        m_done += ramp;
+        m_left -= ramp;
+
+        if (ramp)
+        {
+            if (! m_left)
+                out[ramp - 1] = m_target;
+
+            m_value = out[ramp - 1];
+        }
+
+        for (int i = ramp; i < frames; i ++)
+            out[i] = m_target;
+    }
+
+    float next ()
+    {
+        float value;
+        fill (& value, 1);
+        return value;
+    }
+
+private:
+    float m_value = 0, m_start = 0, m_target = 0, m_step = 0;
+    int m_length = 1, m_done = 0, m_left = 0;
+};
+
+/* moves a fixed fraction of the remaining way each frame (a one-pole low-pass
+ * filter), snapping to the setting once within <snap> of it */
+class ExpSmoother
+{
+public:
+    constexpr ExpSmoother (float snap) :
+        m_snap (snap) {}
+
+    /* <seconds> is the time constant */
+    void setup (float seconds, int rate)
+    {
+        m_coeff = 1 - expf (-1 / (seconds * rate));
+
+        float decay = 1;
+        for (float & d : m_decay)
+            d = (decay *= 1 - m_coeff);
+    }
+
+    void reset (float value)
+        { m_value = m_target = value; }
+    void set_target (float target)
+        { m_target = target; }
+
+    float target () const
+        { return m_target; }
+    bool settled () const
+        { return m_value == m_target; }
+
+    float next ()
+    {
+        if (fabsf (m_target - m_value) < m_snap)
+            m_value = m_target;
+        else
+            m_value += (m_target - m_value) * m_coeff;
+
+        return m_value;
+    }
+
+    /* The same curve as next(), but computed in closed form for up to
+     * <CHUNK> frames at a time, so it may differ from next() by rounding.
+     * Snapping happens at the end of each chunk. */
+    void fill (float * out, int frames)
+    {
+        while (frames)
+        {
+            int chunk = aud::min (frames, CHUNK);
+            float distance = m_value - m_target;
+
+            for (int i = 0; i < chunk; i ++)
+                out[i] = m_target + distance * m_decay[i];
+
+            m_value = out[chunk - 1];
+            if (fabsf (m_target - m_value) < m_snap)
+                m_value = m_target;
+
+            out += chunk;
+            frames -= chunk;
+        }
+    }
+
+private:
+    static constexpr int CHUNK = 16;
+
+    const float m_snap;
+    float m_coeff = 1;
+    float m_value = 0, m_target = 0;
+    float m_decay[CHUNK] {};
+};
+
+#endif
@@ -73,12 +73,22 @@ public:
 
 EXPORT FFaudio aud_plugin_instance;
 
-const char * const FFaudio::defaults[] = {"enable_dsd", "FALSE", nullptr};
+const char * const FFaudio::defaults[] = {
+    "enable_dsd", "FALSE",
+    "demux_thread", "FALSE",
+    "read_ahead", "0",
+    nullptr};
 
 const PreferencesWidget FFaudio::widgets[] = {
     WidgetLabel(N_("<b>Output</b>")),
     WidgetCheck(N_("Enable DSD stream output"),
-                WidgetBool("ffaudio", "enable_dsd"))};
+                WidgetBool("ffaudio", "enable_dsd")),
+    WidgetLabel(N_("<b>Input</b>")),
+    WidgetCheck(N_("Read packets on a separate thread (for slow network files)"),
+                WidgetBool("ffaudio", "demux_thread")),
+    WidgetSpin(N_("Read ahead:"),
+                WidgetInt("ffaudio", "read_ahead"),
+                {0, 64, 1, N_("MB")})};
 
 const PluginPreferences FFaudio::prefs = {{widgets}};
 
@@ -291,7 +301,7 @@ void FFaudio::cleanup ()
 #endif
 }
 
-static int log_result (const char * func, int ret)
+int log_result (const char * func, int ret)
 {
     if (ret < 0 && ret != (int) AVERROR_EOF && ret != AVERROR (EAGAIN))
     {
@@ -305,8 +315,6 @@ static int log_result (const char * func, int ret)
     return ret;
 }
 
-#define LOG(function, ...) log_result (#function, function (__VA_ARGS__))
-
 static void create_extension_dict ()
 {
     AVInputFormat * f;
@@ -394,7 +402,9 @@ static AVInputFormat * get_format (const char * name, VFSFile & file)
     return f ? f : get_format_by_content (name, file);
 }
 
-static AVFormatContext * open_input_file (const char * name, VFSFile & file)
+/* For playback, <byte_rate> is that of the file, or 0 if not known */
+static AVFormatContext * open_input_file (const char * name, VFSFile & file,
+ bool playback = false, int64_t byte_rate = 0)
 {
     AVInputFormat * f = get_format (name, file);
 
@@ -405,7 +415,8 @@ static AVFormatContext * open_input_file (const char * name, VFSFile & file)
     }
 
     AVFormatContext * c = avformat_alloc_context ();
-    AVIOContext * io = io_context_new (file);
+    AVIOContext * io = playback ? io_context_new_for_playback (name, file, byte_rate)
+                                : io_context_new (file);
     c->pb = io;
 
     if (LOG (avformat_open_input, & c, name, f, nullptr) < 0)
@@ -574,8 +585,20 @@ static bool convert_format (int ff_fmt, int & aud_fmt, bool & planar)
 
 bool FFaudio::play (const char * filename, VFSFile & file)
 {
+    /* the bitrate found by read_tag(), or else the average */
+    Tuple tuple = get_playback_tuple ();
+    int bitrate = tuple.get_int (Tuple::Bitrate);
+    int length = tuple.get_int (Tuple::Length);
+    int64_t size = file.fsize ();
+
+    int64_t byte_rate = 0;
+    if (bitrate > 0)
+        byte_rate = (int64_t) bitrate * 1000 / 8;
+    else if (length > 0 && size > 0)
+        byte_rate = size * 1000 / length;
+
     SmartPtr<AVFormatContext, close_input_file>
-     ic (open_input_file (filename, file));
+     ic (open_input_file (filename, file, true, byte_rate));
 
     if (! ic)
         return false;
@@ -618,6 +641,12 @@ bool FFaudio::play (const char * filename, VFSFile & file)
     bool eof = false;
 
     Index<char> buf;
+    ScopedPacket pkt;
+
+    /* From here on, only the queue's thread uses the format context */
+    SmartPtr<PacketQueue> queue;
+    if (aud_get_bool ("ffaudio", "demux_thread"))
+        queue = SmartNew<PacketQueue> (ic.get (), cinfo.stream_idx);
 
     while (! eof && ! check_stop ())
     {
@@ -625,14 +654,21 @@ bool FFaudio::play (const char * filename, VFSFile & file)
 
         if (seek_value >= 0)
         {
-            if (LOG (av_seek_frame, ic.get (), -1, (int64_t) seek_value *
-             AV_TIME_BASE / 1000, AVSEEK_FLAG_ANY) >= 0)
+            int64_t time = (int64_t) seek_value * AV_TIME_BASE / 1000;
+
+            if (queue)
+            {
+                /* nothing read before the seek may reach the decoder */
+                queue->seek (time);
+                avcodec_flush_buffers (context.ptr);
+            }
+            else if (LOG (av_seek_frame, ic.get (), -1, time, AVSEEK_FLAG_ANY) >= 0)
                 errcount = 0;
         }
 
         /* Read next frame (or more) of data */
-        ScopedPacket pkt;
-        int ret = LOG (av_read_frame, ic.get (), pkt.ptr);
+        av_packet_unref (pkt.ptr);
+        int ret = queue ? queue->pop (pkt.ptr) : LOG (av_read_frame, ic.get (), pkt.ptr);
 
         if (ret < 0)
         {
@@ -642,7 +678,7 @@ bool FFaudio::play (const char * filename, VFSFile & file)
                 pkt.clear ();
                 eof = true;
             }
-            else if (++ errcount > 4)
+            else if (queue || ++ errcount > 4) /* the queue has retried already */
                 return false;
             else
                 continue;
@@ -19,31 +19,263 @@
 #define WANT_VFS_STDIO_COMPAT
 #include "ffaudio-stdinc.h"
 
+#include <libaudcore/ringbuf.h>
+#include <libaudcore/runtime.h>
+
 #define IOBUF 4096
+#define IOBUF_MAX (1 << 20)
+#define READ_CHUNK 65536
 
-static int read_cb (void * file, unsigned char * buf, int size)
+/* Where the AVIOContext gets its data: the VFSFile itself, or a buffer a
+ * thread keeps filled from the VFSFile. */
+class IOSource
 {
-    int ret = ((VFSFile *) file)->fread (buf, 1, size);
-    return (ret > 0) ? ret : AVERROR_EOF;
-}
+public:
+    virtual ~IOSource () {}
+
+    virtual int read (unsigned char * buf, int size) = 0;
+    virtual int64_t seek (int64_t offset, int whence) = 0;
+};
+
+class VFSSource : public IOSource
+{
+public:
+    VFSSource (VFSFile & file) : m_file (file) {}
+
+    int read (unsigned char * buf, int size)
+    {
+        int ret = m_file.fread (buf, 1, size);
+        return (ret > 0) ? ret : AVERROR_EOF;
+    }
+
+    int64_t seek (int64_t offset, int whence)
+    {
+        if (whence == AVSEEK_SIZE)
+            return m_file.fsize ();
+        if (m_file.fseek (offset, to_vfs_seek_type (whence & ~(int) AVSEEK_FORCE)))
+            return -1;
+        return m_file.ftell ();
+    }
+
+private:
+    VFSFile & m_file;
+};
 
-static int64_t seek_cb (void * file, int64_t offset, int whence)
+static int64_t seek_target (int64_t offset, int whence, int64_t pos, int64_t size)
 {
-    if (whence == AVSEEK_SIZE)
-        return ((VFSFile *) file)->fsize ();
-    if (((VFSFile *) file)->fseek (offset, to_vfs_seek_type (whence & ~(int) AVSEEK_FORCE)))
+    switch (whence & ~(int) AVSEEK_FORCE)
+    {
+    case SEEK_SET:
+        return offset;
+    case SEEK_CUR:
+        return pos + offset;
+    case SEEK_END:
+        return (size >= 0) ? size + offset : -1;
+    default:
         return -1;
-    return ((VFSFile *) file)->ftell ();
+    }
+}
+
+/* A thread reads ahead of the decoder, up to the size of the buffer.  Seeks
+ * within what has been read already are served from the buffer; others wait
+ * for the read in progress and then seek the file (so that a failed seek is
+ * reported as before). */
+class ReadAheadSource : public IOSource
+{
+public:
+    ReadAheadSource (VFSFile & file, int buffer_size) :
+        m_file (file),
+        m_size (file.fsize ()),
+        m_pos (file.ftell ())
+    {
+        m_rb.alloc (buffer_size);
+        m_chunk.resize (READ_CHUNK);
+        m_running = ! pthread_create (& m_thread, nullptr, run, this);
+
+        if (! m_running)
+            AUDERR ("Failed to create read-ahead thread.\n");
+    }
+
+    ~ReadAheadSource ()
+    {
+        pthread_mutex_lock (& m_mutex);
+        m_quit = true;
+        pthread_cond_broadcast (& m_cond);
+        pthread_mutex_unlock (& m_mutex);
+
+        if (m_running)
+            pthread_join (m_thread, nullptr);
+    }
+
+    bool running () const
+        { return m_running; }
+
+    int read (unsigned char * buf, int size)
+    {
+        pthread_mutex_lock (& m_mutex);
+
+        while (! m_rb.len () && ! m_eof)
+            pthread_cond_wait (& m_cond, & m_mutex);
+
+        int len = aud::min (m_rb.len (), size);
+
+        if (len)
+        {
+            m_rb.move_out ((char *) buf, len);
+            m_pos += len;
+            pthread_cond_broadcast (& m_cond);
+        }
+
+        pthread_mutex_unlock (& m_mutex);
+
+        return len ? len : AVERROR_EOF;
+    }
+
+    int64_t seek (int64_t offset, int whence)
+    {
+        if (whence == AVSEEK_SIZE)
+            return m_size;
+
+        pthread_mutex_lock (& m_mutex);
+
+        int64_t pos = seek_target (offset, whence, m_pos, m_size);
+
+        if (pos >= m_pos && pos <= m_pos + m_rb.len ())
+        {
+            m_rb.discard (pos - m_pos);
+            m_pos = pos;
+        }
+        else if (pos >= 0)
+        {
+            m_seeking = true;
+
+            while (m_reading)
+                pthread_cond_wait (& m_cond, & m_mutex);
+
+            m_rb.discard ();
+
+            if (m_file.fseek (pos, VFS_SEEK_SET))
+                pos = -1;
+
+            /* after a failed seek, reading goes on from wherever the
+             * file is now */
+            m_pos = m_file.ftell ();
+            m_eof = false;
+            m_seeking = false;
+
+            pthread_cond_broadcast (& m_cond);
+        }
+
+        pthread_mutex_unlock (& m_mutex);
+
+        return pos;
+    }
+
+private:
+    VFSFile & m_file;
+    int64_t m_size;
+    int64_t m_pos; /* of the first byte in the buffer */
+
+    pthread_t m_thread;
+    bool m_running = false;
+
+    pthread_mutex_t m_mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t m_cond = PTHREAD_COND_INITIALIZER;
+
+    RingBuf<char> m_rb;
+    Index<char> m_chunk;
+    bool m_reading = false, m_seeking = false, m_eof = false, m_quit = false;
+
+    static void * run (void * me)
+    {
+        ((ReadAheadSource *) me)->read_loop ();
+        return nullptr;
+    }
+
+    void read_loop ()
+    {
+        pthread_mutex_lock (& m_mutex);
+
+        while (! m_quit)
+        {
+            if (m_seeking || m_eof || m_rb.space () < READ_CHUNK)
+            {
+                pthread_cond_wait (& m_cond, & m_mutex);
+                continue;
+            }
+
+            m_reading = true;
+            pthread_mutex_unlock (& m_mutex);
+
+            int64_t len = m_file.fread (m_chunk.begin (), 1, READ_CHUNK);
+
+            pthread_mutex_lock (& m_mutex);
+            m_reading = false;
+
+            if (len > 0)
+                m_rb.copy_in (m_chunk.begin (), len);
+            else
+                m_eof = true;
+
+            pthread_cond_broadcast (& m_cond);
+        }
+
+        pthread_mutex_unlock (& m_mutex);
+    }
+};
+
+static int read_cb (void * source, unsigned char * buf, int size)
+{
+    return ((IOSource *) source)->read (buf, size);
+}
+
+static int64_t seek_cb (void * source, int64_t offset, int whence)
+{
+    return ((IOSource *) source)->seek (offset, whence);
+}
+
+static AVIOContext * io_context_for (IOSource * source, int size)
+{
+    void * buf = av_malloc (size);
+    return avio_alloc_context ((unsigned char *) buf, size, 0, source, read_cb, nullptr, seek_cb);
 }
 
 AVIOContext * io_context_new (VFSFile & file)
 {
-    void * buf = av_malloc (IOBUF);
-    return avio_alloc_context ((unsigned char *) buf, IOBUF, 0, & file, read_cb, nullptr, seek_cb);
+    return io_context_for (new VFSSource (file), IOBUF);
+}
+
+AVIOContext * io_context_new_for_playback (const char * filename, VFSFile & file,
+ int64_t byte_rate)
+{
+    /* about 16 refills a second, rather than thousands for DSD or hi-res PCM */
+    int size = IOBUF;
+    while (size < IOBUF_MAX && size < byte_rate / 16)
+        size *= 2;
+
+    IOSource * source = nullptr;
+    int read_ahead = aud::clamp (aud_get_int ("ffaudio", "read_ahead"), 0, 64);
+
+    if (read_ahead)
+    {
+        auto ahead = new ReadAheadSource (file, read_ahead << 20);
+
+        if (ahead->running ())
+            source = ahead;
+        else
+            delete ahead;
+    }
+
+    if (! source)
+        source = new VFSSource (file);
+
+    AUDDBG ("I/O buffer of %d bytes for %s.\n", size, filename);
+    return io_context_for (source, size);
 }
 
 void io_context_free (AVIOContext * io)
 {
+    delete (IOSource *) io->opaque;
     av_free (io->buffer);
     av_free (io);
 }
@@ -0,0 +1,219 @@
+/*
+ * ffaudio-queue.cc
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ */
+
+#include "ffaudio-stdinc.h"
+
+#include <libaudcore/runtime.h>
+
+/* The queue holds up to max_packets packets (or max_bytes of them) in a ring.
+ * The packets themselves are kept for reuse rather than freed once played, so
+ * after the queue has filled up, reading allocates nothing but the packet
+ * data (which the demuxer may hand out by reference anyway). */
+
+static AVPacket * packet_new ()
+{
+#if CHECK_LIBAVCODEC_VERSION(57, 12, 100)
+    return av_packet_alloc ();
+#else
+    AVPacket * pkt = new AVPacket ();
+    av_init_packet (pkt);
+    return pkt;
+#endif
+}
+
+static void packet_free (AVPacket * pkt)
+{
+#if CHECK_LIBAVCODEC_VERSION(57, 12, 100)
+    av_packet_free (& pkt);
+#else
+    av_packet_unref (pkt);
+    delete pkt;
+#endif
+}
+
+PacketQueue::PacketQueue (AVFormatContext * ic, int stream_idx) :
+    m_ic (ic),
+    m_stream_idx (stream_idx)
+{
+    if (pthread_create (& m_thread, nullptr, run, this))
+    {
+        AUDERR ("Failed to create demuxer thread.\n");
+        m_status = AVERROR (EAGAIN);
+    }
+    else
+        m_running = true;
+}
+
+PacketQueue::~PacketQueue ()
+{
+    pthread_mutex_lock (& m_mutex);
+    m_quit = true;
+    pthread_cond_broadcast (& m_cond);
+    pthread_mutex_unlock (& m_mutex);
+
+    if (m_running)
+        pthread_join (m_thread, nullptr);
+
+    for (int i = 0; i < m_count; i ++)
+        packet_free (m_ring[(m_head + i) % max_packets]);
+
+    for (AVPacket * pkt : m_pool)
+        packet_free (pkt);
+}
+
+/* call with the mutex locked */
+void PacketQueue::recycle (AVPacket * pkt)
+{
+    av_packet_unref (pkt);
+    m_pool.append (pkt);
+}
+
+int PacketQueue::pop (AVPacket * pkt)
+{
+    pthread_mutex_lock (& m_mutex);
+
+    while (! m_count && ! m_status)
+        pthread_cond_wait (& m_cond, & m_mutex);
+
+    if (! m_count)
+    {
+        int status = m_status;
+        pthread_mutex_unlock (& m_mutex);
+        return status;
+    }
+
+    AVPacket * item = m_ring[m_head];
+    m_head = (m_head + 1) % max_packets;
+    m_count --;
+    m_bytes -= item->size;
+
+    av_packet_move_ref (pkt, item);
+    m_pool.append (item);
+
+    pthread_cond_broadcast (& m_cond);
+    pthread_mutex_unlock (& m_mutex);
+
+    return 0;
+}
+
+void PacketQueue::seek (int64_t time)
+{
+    pthread_mutex_lock (& m_mutex);
+
+    for (; m_count; m_count --)
+    {
+        recycle (m_ring[m_head]);
+        m_head = (m_head + 1) % max_packets;
+    }
+
+    m_head = 0;
+    m_bytes = 0;
+
+    /* after the end or an error, reading starts over */
+    if (m_running)
+        m_status = 0;
+
+    m_generation ++;
+    m_seek_pending = true;
+    m_seek_time = time;
+
+    pthread_cond_broadcast (& m_cond);
+    pthread_mutex_unlock (& m_mutex);
+}
+
+void * PacketQueue::run (void * me)
+{
+    ((PacketQueue *) me)->read_loop ();
+    return nullptr;
+}
+
+void PacketQueue::read_loop ()
+{
+    int errcount = 0;
+
+    pthread_mutex_lock (& m_mutex);
+
+    while (! m_quit)
+    {
+        if (m_seek_pending)
+        {
+            int64_t time = m_seek_time;
+            m_seek_pending = false;
+
+            pthread_mutex_unlock (& m_mutex);
+
+            if (LOG (av_seek_frame, m_ic, -1, time, AVSEEK_FLAG_ANY) >= 0)
+                errcount = 0;
+
+            pthread_mutex_lock (& m_mutex);
+            continue;
+        }
+
+        if (m_status || m_count == max_packets || m_bytes >= max_bytes)
+        {
+            pthread_cond_wait (& m_cond, & m_mutex);
+            continue;
+        }
+
+        AVPacket * pkt;
+
+        if (m_pool.len ())
+        {
+            pkt = m_pool[m_pool.len () - 1];
+            m_pool.remove (m_pool.len () - 1, 1);
+        }
+        else
+            pkt = packet_new ();
+
+        int generation = m_generation;
+
+        pthread_mutex_unlock (& m_mutex);
+        int ret = LOG (av_read_frame, m_ic, pkt);
+        pthread_mutex_lock (& m_mutex);
+
+        /* the packet is from before a seek, or not of our stream */
+        if (generation != m_generation || (ret >= 0 && pkt->stream_index != m_stream_idx))
+        {
+            recycle (pkt);
+            continue;
+        }
+
+        if (ret < 0)
+        {
+            recycle (pkt);
+
+            if (ret == (int) AVERROR_EOF || ++ errcount > 4)
+            {
+                m_status = ret;
+                pthread_cond_broadcast (& m_cond);
+            }
+
+            continue;
+        }
+
+        errcount = 0;
+
+        m_ring[(m_head + m_count) % max_packets] = pkt;
+        m_count ++;
+        m_bytes += pkt->size;
+
+        pthread_cond_broadcast (& m_cond);
+    }
+
+    pthread_mutex_unlock (& m_mutex);
+}
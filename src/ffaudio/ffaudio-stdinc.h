@@ -20,6 +20,7 @@
 #define __FFAUDIO_STDINC_H__GUARD
 
 #define __STDC_CONSTANT_MACROS
+#include <pthread.h>
 #include <libaudcore/plugin.h>
 
 extern "C" {
@@ -33,6 +34,54 @@ extern "C" {
 #define CHECK_LIBAVUTIL_VERSION(a, b, c) (LIBAVUTIL_VERSION_INT >= AV_VERSION_INT (a, b, c))
 
 AVIOContext * io_context_new (VFSFile & file);
+/* <byte_rate> is 0 if not known */
+AVIOContext * io_context_new_for_playback (const char * filename, VFSFile & file,
+ int64_t byte_rate);
 void io_context_free (AVIOContext * context);
 
+int log_result (const char * func, int ret);
+#define LOG(function, ...) log_result (#function, function (__VA_ARGS__))
+
+/* Packets of one stream, read ahead by a thread of their own so that a slow
+ * read does not hold up decoding.  Only that thread uses the format context
+ * while the queue exists; seeking is done there too. */
+class PacketQueue
+{
+public:
+    PacketQueue (AVFormatContext * ic, int stream_idx);
+    ~PacketQueue ();
+
+    /* Moves the next packet into <pkt>; returns AVERROR_EOF at the end, or
+     * another error once reading has failed repeatedly. */
+    int pop (AVPacket * pkt);
+    void seek (int64_t time);
+
+private:
+    static constexpr int max_packets = 256;
+    static constexpr int max_bytes = 4 << 20;
+
+    AVFormatContext * m_ic;
+    int m_stream_idx;
+
+    pthread_t m_thread;
+    bool m_running = false;
+
+    pthread_mutex_t m_mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t m_cond = PTHREAD_COND_INITIALIZER;
+
+    AVPacket * m_ring[max_packets];
+    int m_head = 0, m_count = 0, m_bytes = 0;
+    Index<AVPacket *> m_pool; /* blank packets to read into */
+
+    int m_status = 0; /* why reading stopped */
+    int m_generation = 0; /* bumped by a seek */
+    bool m_seek_pending = false;
+    int64_t m_seek_time = 0;
+    bool m_quit = false;
+
+    static void * run (void * me);
+    void read_loop ();
+    void recycle (AVPacket * pkt);
+};
+
 #endif
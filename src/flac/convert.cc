@@ -0,0 +1,168 @@
+/*
+ *  A FLAC decoder plugin for the Audacious Media Player
+ *  Copyright (C) 2026 Audacious developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <math.h>
+
+#include "flacng.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define CONVERT_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CONVERT_NEON
+#endif
+
+/*
+ * Each kernel converts four frames at a time and leaves the rest to the
+ * scalar loop at its end.  The conversion is the same as the core's for
+ * packed integers (a multiplication by a power of two), so the floats are
+ * exactly what writing FMT_S16_NE etc. used to give.
+ */
+
+/* one channel, <stride> floats apart in the output */
+static void convert_channel(const FLAC__int32 *in, float *out, unsigned stride,
+ unsigned frames, float scale)
+{
+    unsigned f = 0;
+
+    if (stride == 1)
+    {
+#if defined(CONVERT_SSE2)
+        const __m128 mul = _mm_set1_ps(scale);
+
+        for (; f + 4 <= frames; f += 4)
+        {
+            __m128i x = _mm_loadu_si128((const __m128i *)(in + f));
+            _mm_storeu_ps(out + f, _mm_mul_ps(_mm_cvtepi32_ps(x), mul));
+        }
+#elif defined(CONVERT_NEON)
+        for (; f + 4 <= frames; f += 4)
+            vst1q_f32(out + f, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(in + f)), scale));
+#endif
+    }
+
+    for (; f < frames; f++)
+        out[f * stride] = (float) in[f] * scale;
+}
+
+static void convert_stereo(const FLAC__int32 *left, const FLAC__int32 *right,
+ float *out, unsigned frames, float scale)
+{
+    unsigned f = 0;
+
+#if defined(CONVERT_SSE2)
+    const __m128 mul = _mm_set1_ps(scale);
+
+    for (; f + 4 <= frames; f += 4)
+    {
+        __m128 l = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(left + f))), mul);
+        __m128 r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(right + f))), mul);
+
+        _mm_storeu_ps(out + 2 * f, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(out + 2 * f + 4, _mm_unpackhi_ps(l, r));
+    }
+#elif defined(CONVERT_NEON)
+    for (; f + 4 <= frames; f += 4)
+    {
+        float32x4x2_t lr;
+        lr.val[0] = vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(left + f)), scale);
+        lr.val[1] = vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(right + f)), scale);
+        vst2q_f32(out + 2 * f, lr);
+    }
+#endif
+
+    for (; f < frames; f++)
+    {
+        out[2 * f] = (float) left[f] * scale;
+        out[2 * f + 1] = (float) right[f] * scale;
+    }
+}
+
+/* four neighbouring channels out of <stride>, transposed four frames at a time */
+static void convert_quad(const FLAC__int32 *const in[], float *out, unsigned stride,
+ unsigned frames, float scale)
+{
+    unsigned f = 0;
+
+#if defined(CONVERT_SSE2)
+    const __m128 mul = _mm_set1_ps(scale);
+
+    for (; f + 4 <= frames; f += 4)
+    {
+        __m128 a = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(in[0] + f))), mul);
+        __m128 b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(in[1] + f))), mul);
+        __m128 c = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(in[2] + f))), mul);
+        __m128 d = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(in[3] + f))), mul);
+
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+
+        float *o = out + f * stride;
+        _mm_storeu_ps(o, a);
+        _mm_storeu_ps(o + stride, b);
+        _mm_storeu_ps(o + 2 * stride, c);
+        _mm_storeu_ps(o + 3 * stride, d);
+    }
+#elif defined(CONVERT_NEON)
+    for (; f + 4 <= frames; f += 4)
+    {
+        float32x4_t a = vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(in[0] + f)), scale);
+        float32x4_t b = vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(in[1] + f)), scale);
+        float32x4_t c = vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(in[2] + f)), scale);
+        float32x4_t d = vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(in[3] + f)), scale);
+
+        float32x4x2_t ac = vzipq_f32(a, c);
+        float32x4x2_t bd = vzipq_f32(b, d);
+        float32x4x2_t lo = vzipq_f32(ac.val[0], bd.val[0]);
+        float32x4x2_t hi = vzipq_f32(ac.val[1], bd.val[1]);
+
+        float *o = out + f * stride;
+        vst1q_f32(o, lo.val[0]);
+        vst1q_f32(o + stride, lo.val[1]);
+        vst1q_f32(o + 2 * stride, hi.val[0]);
+        vst1q_f32(o + 3 * stride, hi.val[1]);
+    }
+#endif
+
+    for (; f < frames; f++)
+    {
+        for (unsigned channel = 0; channel < 4; channel++)
+            out[f * stride + channel] = (float) in[channel][f] * scale;
+    }
+}
+
+void convert_to_float(const FLAC__int32 *const in[], float *out, unsigned channels,
+ unsigned frames, unsigned bits_per_sample)
+{
+    float scale = ldexpf(1, 1 - (int) bits_per_sample);
+
+    if (channels == 2)
+    {
+        convert_stereo(in[0], in[1], out, frames, scale);
+        return;
+    }
+
+    unsigned channel = 0;
+
+    for (; channel + 4 <= channels; channel += 4)
+        convert_quad(in + channel, out + channel, channels, frames, scale);
+
+    for (; channel < channels; channel++)
+        convert_channel(in[channel], out + channel, channels, frames, scale);
+}
@@ -24,6 +24,7 @@
 
 #include <libaudcore/i18n.h>
 #include <libaudcore/plugin.h>
+#include <libaudcore/preferences.h>
 
 class FLACng : public InputPlugin
 {
@@ -31,11 +32,15 @@ public:
     static const char about[];
     static const char *const exts[];
     static const char *const mimes[];
+    static const char *const defaults[];
+    static const PreferencesWidget widgets[];
+    static const PluginPreferences prefs;
 
     static constexpr PluginInfo info = {
         N_("FLAC Decoder"),
         PACKAGE,
-        about
+        about,
+        &prefs
     };
 
     constexpr FLACng() : InputPlugin(info, InputInfo(FlagWritesTag)
@@ -50,36 +55,72 @@ public:
     bool read_tag(const char *filename, VFSFile &file, Tuple &tuple, Index<char> *image);
     bool write_tuple(const char *filename, VFSFile &file, const Tuple &tuple);
     bool play(const char *filename, VFSFile &file);
+
+private:
+    bool play_parallel(uint64_t total_samples, unsigned sample_rate);
 };
 
-#define BUFFER_SIZE_SAMP (FLAC__MAX_BLOCK_SIZE * FLAC__MAX_CHANNELS)
-#define BUFFER_SIZE_BYTE (BUFFER_SIZE_SAMP * (FLAC__MAX_BITS_PER_SAMPLE/8))
+using StreamDecoderPtr = SmartPtr<FLAC__StreamDecoder, FLAC__stream_decoder_delete>;
+
+/* Frames are decoded until there are at least this many samples per channel
+ * to pass to write_audio() at once. */
+#define BATCH_SIZE_SAMP 8192
+
+/* Points to seek to, about a second apart, for files without a SEEKTABLE.
+ * They are gathered while playing and kept in the user's cache directory,
+ * under the URI, size and modification time of the file. */
+class SeekIndex
+{
+public:
+    struct Point {
+        uint64_t sample;
+        uint64_t offset; /* of the frame starting at <sample> */
+    };
+
+    bool load(const char *filename, VFSFile &file, unsigned sample_rate);
+    void save();
+    void clear();
+    void forget();
 
-#define SAMPLE_SIZE(a) (a == 8 ? 1 : (a == 16 ? 2 : 4))
-#define SAMPLE_FMT(a) (a == 8 ? FMT_S8 : (a == 16 ? FMT_S16_NE : (a == 24 ? FMT_S24_NE : FMT_S32_NE)))
+    bool wants(uint64_t sample) const;
+    void add(uint64_t sample, uint64_t offset);
+    bool find(uint64_t sample, Point &point) const;
+
+private:
+    String m_key, m_path;
+    unsigned m_interval = 0;
+    Index<Point> m_points;
+    bool m_changed = false;
+
+    int position(uint64_t sample) const;
+};
 
 struct callback_info
 {
     unsigned bits_per_sample = 0;
     unsigned sample_rate = 0;
     unsigned channels = 0;
+    unsigned max_blocksize = 0;
     unsigned long total_samples = 0;
-    Index<int32_t> output_buffer;
-    int32_t *write_pointer = nullptr;
+    Index<float> output_buffer; /* interleaved; grows as needed */
     unsigned buffer_used = 0;
     VFSFile *fd = nullptr;
     int bitrate = 0;
+    bool has_seektable = false;
+    uint64_t next_sample = 0; /* following the last frame decoded */
+    SeekIndex *index = nullptr; /* to add points to */
 
+    /* room for a batch and the frame that completes it */
     void alloc()
     {
-        output_buffer.resize(BUFFER_SIZE_SAMP);
+        unsigned blocksize = max_blocksize ? max_blocksize : FLAC__MAX_BLOCK_SIZE;
+        output_buffer.resize((BATCH_SIZE_SAMP + blocksize) * channels);
         reset();
     }
 
     void reset()
     {
         buffer_used = 0;
-        write_pointer = output_buffer.begin();
     }
 };
 
@@ -98,6 +139,19 @@ FLAC__StreamDecoderWriteStatus write_callback(const FLAC__StreamDecoder *decoder
 void error_callback(const FLAC__StreamDecoder *decoder, FLAC__StreamDecoderErrorStatus status, void *client_data);
 void metadata_callback(const FLAC__StreamDecoder *decoder, const FLAC__StreamMetadata *metadata, void *client_data);
 
+/* convert.cc */
+void convert_to_float(const FLAC__int32 *const in[], float *out, unsigned channels,
+ unsigned frames, unsigned bits_per_sample);
+
+/* parallel.cc */
+bool parallel_start(const char *filename, const callback_info &info);
+void parallel_seek(uint64_t sample);
+bool parallel_read(Index<float> &audio, bool &error);
+void parallel_stop();
+
+/* seekindex.cc */
+bool seek_with_index(FLAC__StreamDecoder *decoder, callback_info &info, uint64_t sample);
+
 /* tools.c */
 bool is_ogg_flac(VFSFile &file);
 bool read_metadata(FLAC__StreamDecoder* decoder, callback_info* info);
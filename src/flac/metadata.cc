@@ -138,6 +138,29 @@ static void insert_int_tuple_to_vc (FLAC__StreamMetadata * vc_block,
         vc_block->data.vorbis_comment.num_comments, entry, true);
 }
 
+/* Unlike the fields above, a ReplayGain entry is left in the block as read
+ * from the file when the tuple has no value for it. */
+static void insert_gain_tuple_to_vc (FLAC__StreamMetadata * vc_block,
+ const Tuple & tuple, Tuple::Field field, Tuple::Field divisor_field,
+ const char * format, const char * field_name)
+{
+    FLAC__StreamMetadata_VorbisComment_Entry entry;
+    int divisor = tuple.get_int (divisor_field);
+
+    if (tuple.get_value_type (field) != Tuple::Int || divisor <= 0)
+        return;
+
+    FLAC__metadata_object_vorbiscomment_remove_entries_matching(vc_block,
+        field_name);
+
+    StringBuf val = str_printf (format, (double) tuple.get_int (field) / divisor);
+    StringBuf str = str_printf ("%s=%s", field_name, (const char *) val);
+    entry.entry = (FLAC__byte *) (char *) str;
+    entry.length = strlen(str);
+    FLAC__metadata_object_vorbiscomment_insert_comment(vc_block,
+        vc_block->data.vorbis_comment.num_comments, entry, true);
+}
+
 bool FLACng::write_tuple(const char *filename, VFSFile &file, const Tuple &tuple)
 {
     if (is_ogg_flac(file))
@@ -193,6 +216,15 @@ bool FLACng::write_tuple(const char *filename, VFSFile &file, const Tuple &tuple
     insert_str_tuple_to_vc(vc_block, tuple, Tuple::Publisher, "publisher");
     insert_str_tuple_to_vc(vc_block, tuple, Tuple::CatalogNum, "CATALOGNUMBER");
 
+    insert_gain_tuple_to_vc(vc_block, tuple, Tuple::TrackGain, Tuple::GainDivisor,
+        "%+.2f dB", "REPLAYGAIN_TRACK_GAIN");
+    insert_gain_tuple_to_vc(vc_block, tuple, Tuple::TrackPeak, Tuple::PeakDivisor,
+        "%.6f", "REPLAYGAIN_TRACK_PEAK");
+    insert_gain_tuple_to_vc(vc_block, tuple, Tuple::AlbumGain, Tuple::GainDivisor,
+        "%+.2f dB", "REPLAYGAIN_ALBUM_GAIN");
+    insert_gain_tuple_to_vc(vc_block, tuple, Tuple::AlbumPeak, Tuple::PeakDivisor,
+        "%.6f", "REPLAYGAIN_ALBUM_PEAK");
+
     FLAC__metadata_iterator_delete(iter);
     FLAC__metadata_chain_sort_padding(chain);
 
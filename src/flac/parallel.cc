@@ -0,0 +1,262 @@
+/*
+ *  A FLAC decoder plugin for the Audacious Media Player
+ *  Copyright (C) 2026 Audacious developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <libaudcore/runtime.h>
+
+#include "flacng.h"
+
+/*
+ * Decoding on several cores, for when the output takes audio faster than it
+ * plays (converting files, for one).  The file is split into segments of
+ * SEGMENT_SIZE_SAMP samples per channel, each decoded whole by one of the
+ * workers.  A worker has a decoder and a handle on the file of its own, and
+ * finds the start of a segment with FLAC__stream_decoder_seek_absolute(),
+ * which goes by the SEEKTABLE if there is one and searches for frame sync
+ * codes if not.  The segments are handed back in order, and at most two per
+ * worker are decoded ahead.
+ */
+
+#define MAX_WORKERS 8
+#define SEGMENT_SIZE_SAMP 65536
+#define WINDOW_MAX (2 * MAX_WORKERS)
+
+struct Segment
+{
+    Index<float> audio;
+    bool done = false;
+    bool failed = false;
+    bool at_end = false; /* the stream ended short of the segment's end */
+};
+
+static pthread_t threads[MAX_WORKERS];
+static int n_threads;
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+
+static String s_filename;
+static uint64_t s_total_samples;
+static bool s_quit;
+
+/* Bumped by a seek; a worker drops a segment it took on before then. */
+static int generation;
+
+static uint64_t first_sample; /* where the first segment starts */
+static int64_t n_segments, next_write, next_assign;
+
+static Segment window[WINDOW_MAX]; /* segment n is in window[n % window_size] */
+static int window_size;
+
+static bool decode_segment(FLAC__StreamDecoder *decoder, callback_info &info,
+ uint64_t start, uint64_t end, Segment &segment)
+{
+    info.reset();
+
+    if (!FLAC__stream_decoder_seek_absolute(decoder, start))
+    {
+        AUDERR("Could not seek to sample %lu!\n", (unsigned long)start);
+        FLAC__stream_decoder_flush(decoder);
+        return false;
+    }
+
+    unsigned wanted = (end - start) * info.channels;
+
+    while (info.buffer_used < wanted)
+    {
+        if (FLAC__stream_decoder_get_state(decoder) == FLAC__STREAM_DECODER_END_OF_STREAM)
+        {
+            segment.at_end = true;
+            break;
+        }
+
+        if (!FLAC__stream_decoder_process_single(decoder))
+        {
+            AUDERR("Error while decoding!\n");
+            return false;
+        }
+    }
+
+    /* the last frame may run past the end */
+    segment.audio.insert(info.output_buffer.begin(), 0,
+     aud::min(info.buffer_used, wanted));
+
+    return true;
+}
+
+static void *worker(void *)
+{
+    VFSFile file(s_filename, "r");
+    callback_info info;
+    info.fd = &file;
+
+    auto decoder = StreamDecoderPtr(FLAC__stream_decoder_new());
+
+    bool ready = file && decoder && FLAC__stream_decoder_init_stream(decoder.get(),
+     read_callback, seek_callback, tell_callback, length_callback,
+     eof_callback, write_callback, metadata_callback, error_callback,
+     &info) == FLAC__STREAM_DECODER_INIT_STATUS_OK && read_metadata(decoder.get(), &info);
+
+    if (!ready)
+        AUDERR("Could not open %s for decoding!\n", (const char *)s_filename);
+
+    pthread_mutex_lock(&mutex);
+
+    while (1)
+    {
+        while (!s_quit && (next_assign >= n_segments ||
+         next_assign >= next_write + window_size))
+            pthread_cond_wait(&work_cond, &mutex);
+
+        if (s_quit)
+            break;
+
+        int64_t n = next_assign++;
+        int seen = generation;
+
+        uint64_t start = aud::max((uint64_t)n * SEGMENT_SIZE_SAMP, first_sample);
+        uint64_t end = aud::min((uint64_t)(n + 1) * SEGMENT_SIZE_SAMP, s_total_samples);
+
+        pthread_mutex_unlock(&mutex);
+
+        Segment segment;
+        segment.failed = !ready || !decode_segment(decoder.get(), info, start, end, segment);
+        segment.done = true;
+
+        pthread_mutex_lock(&mutex);
+
+        if (generation == seen)
+        {
+            window[n % window_size] = std::move(segment);
+            pthread_cond_broadcast(&done_cond);
+        }
+    }
+
+    pthread_mutex_unlock(&mutex);
+    return nullptr;
+}
+
+bool parallel_start(const char *filename, const callback_info &info)
+{
+    int cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int count = aud::min(cores, MAX_WORKERS);
+
+    if (count < 2)
+        return false;
+
+    s_filename = String(filename);
+    s_total_samples = info.total_samples;
+    s_quit = false;
+
+    generation++;
+    first_sample = 0;
+    n_segments = (s_total_samples + SEGMENT_SIZE_SAMP - 1) / SEGMENT_SIZE_SAMP;
+    next_write = next_assign = 0;
+    window_size = 2 * count;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (pthread_create(&threads[n_threads], nullptr, worker, nullptr))
+        {
+            AUDERR("Failed to create worker thread.\n");
+            break;
+        }
+
+        n_threads++;
+    }
+
+    if (!n_threads)
+    {
+        s_filename = String();
+        return false;
+    }
+
+    AUDDBG("Decoding with %d threads.\n", n_threads);
+    return true;
+}
+
+void parallel_seek(uint64_t sample)
+{
+    pthread_mutex_lock(&mutex);
+
+    generation++;
+    first_sample = sample;
+    next_write = next_assign = sample / SEGMENT_SIZE_SAMP;
+
+    for (Segment &segment : window)
+        segment = Segment();
+
+    pthread_cond_broadcast(&work_cond);
+    pthread_mutex_unlock(&mutex);
+}
+
+/* Waits for the next segment.  Returns false at the end of the stream, or on
+ * error, in which case <error> is set. */
+bool parallel_read(Index<float> &audio, bool &error)
+{
+    pthread_mutex_lock(&mutex);
+
+    if (next_write >= n_segments)
+    {
+        pthread_mutex_unlock(&mutex);
+        return false;
+    }
+
+    Segment &segment = window[next_write % window_size];
+
+    while (!segment.done)
+        pthread_cond_wait(&done_cond, &mutex);
+
+    if (segment.failed)
+    {
+        pthread_mutex_unlock(&mutex);
+        error = true;
+        return false;
+    }
+
+    audio = std::move(segment.audio);
+    next_write = segment.at_end ? n_segments : next_write + 1;
+    segment = Segment();
+
+    pthread_cond_broadcast(&work_cond);
+    pthread_mutex_unlock(&mutex);
+
+    return true;
+}
+
+void parallel_stop()
+{
+    pthread_mutex_lock(&mutex);
+    s_quit = true;
+    pthread_cond_broadcast(&work_cond);
+    pthread_mutex_unlock(&mutex);
+
+    for (int i = 0; i < n_threads; i++)
+        pthread_join(threads[i], nullptr);
+
+    n_threads = 0;
+
+    for (Segment &segment : window)
+        segment = Segment();
+
+    s_filename = String();
+}
@@ -26,12 +26,27 @@
 
 EXPORT FLACng aud_plugin_instance;
 
-using StreamDecoderPtr = SmartPtr<FLAC__StreamDecoder, FLAC__stream_decoder_delete>;
 static StreamDecoderPtr s_decoder, s_ogg_decoder;
 static callback_info s_cinfo;
+static SeekIndex s_index;
+
+const char *const FLACng::defaults[] = {
+    "parallel_decode", "FALSE",
+    nullptr
+};
+
+const PreferencesWidget FLACng::widgets[] = {
+    WidgetLabel(N_("<b>Advanced</b>")),
+    WidgetCheck(N_("Decode local files on several cores (faster converting)"),
+        WidgetBool("flacng", "parallel_decode"))
+};
+
+const PluginPreferences FLACng::prefs = {{widgets}};
 
 bool FLACng::init()
 {
+    aud_config_set_defaults("flacng", defaults);
+
     /* Callback structure and decoder for main decoding loop */
     auto flac_decoder = StreamDecoderPtr(FLAC__stream_decoder_new());
     if (!flac_decoder)
@@ -40,6 +55,9 @@ bool FLACng::init()
         return false;
     }
 
+    /* to know whether to keep a seek index */
+    FLAC__stream_decoder_set_metadata_respond(flac_decoder.get(), FLAC__METADATA_TYPE_SEEKTABLE);
+
     auto ret1 = FLAC__stream_decoder_init_stream(flac_decoder.get(),
         read_callback, seek_callback, tell_callback, length_callback,
         eof_callback, write_callback, metadata_callback, error_callback,
@@ -96,39 +114,8 @@ bool FLACng::is_our_file(const char *filename, VFSFile &file)
     return ! strncmp (buf, "fLaC", sizeof buf);
 }
 
-static void squeeze_audio(int32_t* src, void* dst, unsigned count, unsigned res)
-{
-    int32_t* rp = src;
-    int8_t*  wp = (int8_t*) dst;
-    int16_t* wp2 = (int16_t*) dst;
-    int32_t* wp4 = (int32_t*) dst;
-
-    switch (res)
-    {
-        case 8:
-            for (unsigned i = 0; i < count; i++, wp++, rp++)
-                *wp = *rp & 0xff;
-            break;
-
-        case 16:
-            for (unsigned i = 0; i < count; i++, wp2++, rp++)
-                *wp2 = *rp & 0xffff;
-            break;
-
-        case 24:
-        case 32:
-            for (unsigned i = 0; i < count; i++, wp4++, rp++)
-                *wp4 = *rp;
-            break;
-
-        default:
-            AUDERR("Can not convert to %u bps\n", res);
-    }
-}
-
 bool FLACng::play(const char *filename, VFSFile &file)
 {
-    Index<char> play_buffer;
     bool error = false;
     bool stream = (file.fsize() < 0);
     bool _is_ogg_flac = is_ogg_flac(file);
@@ -151,13 +138,26 @@ bool FLACng::play(const char *filename, VFSFile &file)
         goto ERR;
     }
 
-    play_buffer.resize(BUFFER_SIZE_BYTE);
+    s_cinfo.alloc();
 
     if (stream && tuple.fetch_stream_info(file))
         set_playback_tuple(tuple.ref());
 
     set_stream_bitrate(s_cinfo.bitrate);
-    open_audio(SAMPLE_FMT(s_cinfo.bits_per_sample), s_cinfo.sample_rate, s_cinfo.channels);
+    open_audio(FMT_FLOAT, s_cinfo.sample_rate, s_cinfo.channels);
+
+    /* the workers open the file again for themselves */
+    if (!stream && !_is_ogg_flac && s_cinfo.total_samples > 0 &&
+        !strncmp(filename, "file://", 7) && aud_get_bool("flacng", "parallel_decode") &&
+        parallel_start(filename, s_cinfo))
+    {
+        error = !play_parallel(s_cinfo.total_samples, s_cinfo.sample_rate);
+        goto ERR;
+    }
+
+    if (!stream && !_is_ogg_flac && !s_cinfo.has_seektable &&
+        s_index.load(filename, file, s_cinfo.sample_rate))
+        s_cinfo.index = &s_index;
 
     while (FLAC__stream_decoder_get_state(decoder) != FLAC__STREAM_DECODER_END_OF_STREAM)
     {
@@ -173,7 +173,8 @@ bool FLACng::play(const char *filename, VFSFile &file)
             if (s_cinfo.total_samples > 0)
                 sample = aud::min<uint64_t>(sample, s_cinfo.total_samples - 1);
 
-            if (! FLAC__stream_decoder_seek_absolute(decoder, sample))
+            if (! seek_with_index(decoder, s_cinfo, sample) &&
+                ! FLAC__stream_decoder_seek_absolute(decoder, sample))
             {
                 AUDERR("Error while seeking!\n");
                 error = true;
@@ -181,26 +182,35 @@ bool FLACng::play(const char *filename, VFSFile &file)
             }
         }
 
-        /* Try to decode a single frame of audio */
-        if (FLAC__stream_decoder_process_single(decoder) == false)
+        /* Decode frames until there is a batch of audio (a seek has left
+         * the rest of its frame in the buffer already) */
+        while (s_cinfo.buffer_used < BATCH_SIZE_SAMP * s_cinfo.channels &&
+         FLAC__stream_decoder_get_state(decoder) != FLAC__STREAM_DECODER_END_OF_STREAM)
         {
-            AUDERR("Error while decoding!\n");
-            error = true;
-            break;
+            if (FLAC__stream_decoder_process_single(decoder) == false)
+            {
+                AUDERR("Error while decoding!\n");
+                error = true;
+                break;
+            }
         }
 
+        if (error)
+            break;
+
         if (stream && tuple.fetch_stream_info(file))
             set_playback_tuple(tuple.ref());
 
-        squeeze_audio(s_cinfo.output_buffer.begin(), play_buffer.begin(),
-         s_cinfo.buffer_used, s_cinfo.bits_per_sample);
-        write_audio(play_buffer.begin(), s_cinfo.buffer_used *
-         SAMPLE_SIZE(s_cinfo.bits_per_sample));
+        write_audio(s_cinfo.output_buffer.begin(), s_cinfo.buffer_used * sizeof(float));
 
         s_cinfo.reset();
     }
 
 ERR:
+    if (s_cinfo.index)
+        s_index.save();
+
+    s_index.clear();
     s_cinfo.reset();
 
     if (FLAC__stream_decoder_flush(decoder) == false)
@@ -210,6 +220,30 @@ ERR:
     return ! error;
 }
 
+bool FLACng::play_parallel(uint64_t total_samples, unsigned sample_rate)
+{
+    Index<float> audio;
+    bool error = false;
+
+    while (!check_stop())
+    {
+        int seek_value = check_seek();
+        if (seek_value >= 0)
+        {
+            uint64_t sample = (uint64_t) seek_value * sample_rate / 1000;
+            parallel_seek(aud::min(sample, total_samples - 1));
+        }
+
+        if (!parallel_read(audio, error))
+            break;
+
+        write_audio(audio.begin(), audio.len() * sizeof(float));
+    }
+
+    parallel_stop();
+    return !error;
+}
+
 const char FLACng::about[] =
  N_("Original code by\n"
     "Ralf Ertzinger <ralf@skytale.net>\n\n"
@@ -122,16 +122,28 @@ FLAC__StreamDecoderWriteStatus write_callback(const FLAC__StreamDecoder *decoder
         return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
     }
 
-    if (!info->output_buffer.len())
-        info->alloc();
+    unsigned frames = frame->header.blocksize;
+    unsigned needed = info->buffer_used + frames * info->channels;
 
-    for (unsigned sample = 0; sample < frame->header.blocksize; sample++)
+    /* STREAMINFO gave the largest frame, but it is only a hint */
+    if ((unsigned) info->output_buffer.len() < needed)
+        info->output_buffer.resize(needed);
+
+    convert_to_float(buffer, info->output_buffer.begin() + info->buffer_used,
+     info->channels, frames, frame->header.bits_per_sample);
+
+    info->buffer_used = needed;
+
+    /* libFLAC numbers even fixed-blocksize frames by sample */
+    if (frame->header.number_type == FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER)
     {
-        for (unsigned channel = 0; channel < frame->header.channels; channel++)
-        {
-            *(info->write_pointer++) = buffer[channel][sample];
-            info->buffer_used += 1;
-        }
+        info->next_sample = frame->header.number.sample_number + frames;
+
+        /* the position is that of the next frame */
+        FLAC__uint64 offset;
+        if (info->index && info->index->wants(info->next_sample) &&
+            FLAC__stream_decoder_get_decode_position(decoder, &offset))
+            info->index->add(info->next_sample, offset);
     }
 
     return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
@@ -161,6 +173,9 @@ void metadata_callback(const FLAC__StreamDecoder *decoder, const FLAC__StreamMet
         info->sample_rate = metadata->data.stream_info.sample_rate;
         AUDDBG("sample_rate=%d\n", metadata->data.stream_info.sample_rate);
 
+        info->max_blocksize = metadata->data.stream_info.max_blocksize;
+        AUDDBG("max_blocksize=%d\n", metadata->data.stream_info.max_blocksize);
+
         size = info->fd->fsize ();
 
         if (size == -1 || info->total_samples == 0)
@@ -170,4 +185,17 @@ void metadata_callback(const FLAC__StreamDecoder *decoder, const FLAC__StreamMet
 
         AUDDBG("bitrate=%d\n", info->bitrate);
     }
+    else if (metadata->type == FLAC__METADATA_TYPE_SEEKTABLE)
+    {
+        /* a table of placeholders is no help */
+        const FLAC__StreamMetadata_SeekTable &table = metadata->data.seek_table;
+
+        for (unsigned i = 0; i < table.num_points; i++)
+        {
+            if (table.points[i].sample_number != FLAC__STREAM_METADATA_SEEKPOINT_PLACEHOLDER)
+                info->has_seektable = true;
+        }
+
+        AUDDBG("has_seektable=%d\n", info->has_seektable);
+    }
 }
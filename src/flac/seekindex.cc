@@ -0,0 +1,308 @@
+/*
+ *  A FLAC decoder plugin for the Audacious Media Player
+ *  Copyright (C) 2026 Audacious developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <libaudcore/audstrings.h>
+#include <libaudcore/runtime.h>
+
+#include "flacng.h"
+
+/*
+ * Without a SEEKTABLE, FLAC__stream_decoder_seek_absolute() has to search the
+ * file for the frame to seek to, which on a network share or over HTTP is a
+ * lot of round trips.  Instead, the frames ending about a second apart are
+ * noted while playing, and a seek goes to the nearest one before the sample
+ * and decodes forward from there.
+ *
+ * The cache file holds the key, then the points as differences from the one
+ * before, all numbers in 7-bit groups (the last with the top bit clear).
+ */
+
+static const char magic[] = "audacious flac seek index 1\n";
+
+static void put_number(Index<char> &data, uint64_t n)
+{
+    for (; n >= 0x80; n >>= 7)
+        data.append((char)(n | 0x80));
+
+    data.append((char)n);
+}
+
+static bool get_number(const char *&p, const char *end, uint64_t &n)
+{
+    n = 0;
+
+    for (int shift = 0; p < end && shift < 64; shift += 7)
+    {
+        unsigned char c = *p++;
+        n |= (uint64_t)(c & 0x7f) << shift;
+
+        if (!(c & 0x80))
+            return true;
+    }
+
+    return false;
+}
+
+/* The local transport has no metadata; remote ones may give "last-modified". */
+static String file_stamp(const char *filename, VFSFile &file)
+{
+    if (!strncmp(filename, "file://", 7))
+    {
+        StringBuf path = uri_to_filename(filename);
+        GStatBuf st;
+
+        if (path && g_stat(path, &st) == 0)
+            return String(str_printf("%" PRId64, (int64_t)st.st_mtime));
+
+        return String();
+    }
+
+    return file.get_metadata("last-modified");
+}
+
+bool SeekIndex::load(const char *filename, VFSFile &file, unsigned sample_rate)
+{
+    clear();
+
+    int64_t size = file.fsize();
+    String stamp = file_stamp(filename, file);
+
+    if (size < 0 || !stamp || !sample_rate)
+        return false;
+
+    m_key = String(str_printf("%s\n%" PRId64 "\n%s", filename, size, (const char *)stamp));
+    m_interval = sample_rate;
+
+    char *sum = g_compute_checksum_for_string(G_CHECKSUM_MD5, m_key, -1);
+    m_path = String(filename_build({g_get_user_cache_dir(), "audacious", "flac-seek", sum}));
+    g_free(sum);
+
+    char *data;
+    gsize len;
+
+    if (!g_file_get_contents(m_path, &data, &len, nullptr))
+        return true;
+
+    const char *p = data, *end = data + len;
+    uint64_t key_len, count, sample = 0, offset = 0;
+    bool valid = false;
+
+    if (len >= sizeof magic - 1 && !memcmp(p, magic, sizeof magic - 1))
+    {
+        p += sizeof magic - 1;
+
+        /* another file with the same checksum, or an old copy of this one */
+        valid = get_number(p, end, key_len) && key_len == strlen(m_key) &&
+         (uint64_t)(end - p) >= key_len && !memcmp(p, m_key, key_len);
+
+        if (valid)
+        {
+            p += key_len;
+            valid = get_number(p, end, count) && count <= (uint64_t)(end - p);
+        }
+
+        for (uint64_t i = 0; valid && i < count; i++)
+        {
+            uint64_t samples, bytes;
+            valid = get_number(p, end, samples) && get_number(p, end, bytes) &&
+             (samples && bytes);
+
+            sample += samples;
+            offset += bytes;
+
+            if (valid)
+                m_points.append(Point{sample, offset});
+        }
+    }
+
+    g_free(data);
+
+    if (!valid)
+    {
+        AUDDBG("Ignoring seek index %s.\n", (const char *)m_path);
+        m_points.clear();
+    }
+
+    AUDDBG("%d seek points for %s.\n", m_points.len(), filename);
+    return true;
+}
+
+void SeekIndex::save()
+{
+    if (!m_changed)
+        return;
+
+    Index<char> data;
+    data.insert(magic, 0, sizeof magic - 1);
+
+    int key_len = strlen(m_key);
+    put_number(data, key_len);
+    data.insert(m_key, -1, key_len);
+
+    put_number(data, m_points.len());
+
+    uint64_t sample = 0, offset = 0;
+
+    for (const Point &point : m_points)
+    {
+        put_number(data, point.sample - sample);
+        put_number(data, point.offset - offset);
+
+        sample = point.sample;
+        offset = point.offset;
+    }
+
+    StringBuf dir = filename_get_parent(m_path);
+    GError *error = nullptr;
+
+    if (g_mkdir_with_parents(dir, 0755) != 0)
+        AUDERR("Cannot create %s: %s.\n", (const char *)dir, strerror(errno));
+    else if (!g_file_set_contents(m_path, data.begin(), data.len(), &error))
+    {
+        AUDERR("Cannot write %s: %s.\n", (const char *)m_path, error->message);
+        g_error_free(error);
+    }
+
+    m_changed = false;
+}
+
+void SeekIndex::clear()
+{
+    m_key = String();
+    m_path = String();
+    m_interval = 0;
+    m_points.clear();
+    m_changed = false;
+}
+
+/* the number of points at or before <sample> */
+int SeekIndex::position(uint64_t sample) const
+{
+    int low = 0, high = m_points.len();
+
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+
+        if (m_points[mid].sample <= sample)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+/* whether there is no point within a second of <sample> yet */
+bool SeekIndex::wants(uint64_t sample) const
+{
+    if (!m_interval)
+        return false;
+
+    int pos = position(sample);
+
+    return (pos == 0 || sample >= m_points[pos - 1].sample + m_interval) &&
+     (pos == m_points.len() || m_points[pos].sample >= sample + m_interval);
+}
+
+void SeekIndex::add(uint64_t sample, uint64_t offset)
+{
+    if (!wants(sample))
+        return;
+
+    Point point = {sample, offset};
+    m_points.insert(&point, position(sample), 1);
+    m_changed = true;
+}
+
+/* Gives the nearest point before <sample>, unless it is so far back that the
+ * index has a gap there (the rest of the file has not been played yet). */
+bool SeekIndex::find(uint64_t sample, Point &point) const
+{
+    int pos = position(sample);
+
+    if (pos == 0 || sample - m_points[pos - 1].sample >= 2 * (uint64_t)m_interval)
+        return false;
+
+    point = m_points[pos - 1];
+    return true;
+}
+
+void SeekIndex::forget()
+{
+    m_points.clear();
+    m_changed = true;
+}
+
+/* Seeks with a single fseek() and the decoding of a few frames.  Leaves what
+ * is left of the frame holding <sample> in the buffer, as libFLAC's own
+ * seeking does.  If it cannot be done, seek_absolute() is the way. */
+bool seek_with_index(FLAC__StreamDecoder *decoder, callback_info &info, uint64_t sample)
+{
+    SeekIndex::Point point;
+
+    if (!info.index || !info.index->find(sample, point))
+        return false;
+
+    if (info.fd->fseek(point.offset, VFS_SEEK_SET) != 0 ||
+        !FLAC__stream_decoder_flush(decoder))
+        return false;
+
+    bool first = true;
+
+    do
+    {
+        info.reset();
+
+        if (!FLAC__stream_decoder_process_single(decoder) || !info.buffer_used)
+        {
+            info.reset();
+            return false;
+        }
+
+        uint64_t frame_start = info.next_sample - info.buffer_used / info.channels;
+
+        if (first && frame_start != point.sample)
+        {
+            AUDWARN("The seek index does not match the file; dropping it.\n");
+            info.index->forget();
+            info.reset();
+            return false;
+        }
+
+        first = false;
+    }
+    while (info.next_sample <= sample);
+
+    /* drop the start of the frame */
+    unsigned skip = (sample - (info.next_sample - info.buffer_used / info.channels)) * info.channels;
+    float *buffer = info.output_buffer.begin();
+
+    memmove(buffer, buffer + skip, (info.buffer_used - skip) * sizeof(float));
+    info.buffer_used -= skip;
+
+    return true;
+}
@@ -17,6 +17,7 @@
  * the use of this software.
  */
 
+#include <inttypes.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -74,6 +75,8 @@ protected:
 
     int fflush ();
 
+    String get_metadata (const char * field);
+
 private:
     String m_filename;
     GFile * m_file = nullptr;
@@ -370,6 +373,31 @@ FAILED:
     return -1;
 }
 
+String GIOFile::get_metadata (const char * field)
+{
+    if (strcmp (field, "last-modified"))
+        return String ();
+
+    GError * error = nullptr;
+    GFileInfo * info = g_file_query_info (m_file, G_FILE_ATTRIBUTE_TIME_MODIFIED,
+     G_FILE_QUERY_INFO_NONE, nullptr, & error);
+    CHECK_ERROR ("query", m_filename);
+
+    {
+        String stamp;
+
+        if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_TIME_MODIFIED))
+            stamp = String (str_printf ("%" PRIu64, (uint64_t)
+             g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED)));
+
+        g_object_unref (info);
+        return stamp;
+    }
+
+FAILED:
+    return String ();
+}
+
 VFSFileTest GIOTransport::test_file (const char * filename, VFSFileTest test, String & error)
 {
     GFile * file = g_file_new_for_uri (filename);
@@ -25,6 +25,7 @@
 #include <libaudcore/runtime.h>
 
 static int ladspa_channels, ladspa_rate;
+static bool ladspa_threads;
 
 static void start_plugin (LoadedPlugin & loaded)
 {
@@ -53,9 +54,6 @@ static void start_plugin (LoadedPlugin & loaded)
 
     int instances = ladspa_channels / ports;
 
-    loaded.in_bufs.insert (0, ladspa_channels);
-    loaded.out_bufs.insert (0, ladspa_channels);
-
     for (int i = 0; i < instances; i ++)
     {
         LADSPA_Handle handle = desc.instantiate (& desc, ladspa_rate);
@@ -65,74 +63,159 @@ static void start_plugin (LoadedPlugin & loaded)
         for (int c = 0; c < controls; c ++)
             desc.connect_port (handle, plugin.controls[c].port, & loaded.values[c]);
 
+        if (desc.activate)
+            desc.activate (handle);
+    }
+
+    /* the audio ports are connected by wire_plugin () */
+    loaded.wired = -1;
+}
+
+/* The chain works on two sets of planar buffers, LADSPA_BUFLEN frames per
+ * channel.  The data is de-interleaved into one set once per block; from then
+ * on each plugin reads its input from the set the previous one wrote to, and
+ * writes its output to the same set, or to the other set if it cannot work in
+ * place.  The result is re-interleaved once at the end. */
+static Index<LADSPA_Data> chain_bufs[2];
+
+static LADSPA_Data * chain_buf (int set, int channel)
+    { return & chain_bufs[set][LADSPA_BUFLEN * channel]; }
+
+/* Connects the audio ports to read from <set>.  Returns the set that the
+ * output goes to. */
+static int wire_plugin (LoadedPlugin & loaded, int set)
+{
+    PluginData & plugin = loaded.plugin;
+    const LADSPA_Descriptor & desc = plugin.desc;
+
+    int out_set = LADSPA_IS_INPLACE_BROKEN (desc.Properties) ? 1 - set : set;
+
+    if (loaded.wired == set)
+        return out_set;
+
+    int ports = plugin.in_ports.len ();
+    int instances = loaded.instances.len ();
+
+    for (int i = 0; i < instances; i ++)
+    {
         for (int p = 0; p < ports; p ++)
         {
             int channel = ports * i + p;
+            desc.connect_port (loaded.instances[i], plugin.in_ports[p], chain_buf (set, channel));
+            desc.connect_port (loaded.instances[i], plugin.out_ports[p], chain_buf (out_set, channel));
+        }
+    }
 
-            Index<LADSPA_Data> & in = loaded.in_bufs[channel];
-            in.insert (0, LADSPA_BUFLEN);
-            desc.connect_port (handle, plugin.in_ports[p], in.begin ());
+    loaded.wired = set;
+    return out_set;
+}
 
-            Index<LADSPA_Data> & out = loaded.out_bufs[channel];
-            out.insert (0, LADSPA_BUFLEN);
-            desc.connect_port (handle, plugin.out_ports[p], out.begin ());
-        }
+struct RunJob {
+    LoadedPlugin * loaded;
+    int frames;
+};
 
-        if (desc.activate)
-            desc.activate (handle);
-    }
+/* Instances touch only their own channels, so all the instances of a plugin
+ * can run at the same time. */
+static void run_instance (int i, void * data)
+{
+    auto job = (RunJob *) data;
+    job->loaded->plugin.desc.run (job->loaded->instances[i], job->frames);
 }
 
-static void run_plugin (LoadedPlugin & loaded, audio_sample * data, int samples)
+/* Returns the set that the output went to. */
+static int run_plugin (LoadedPlugin & loaded, int frames, int set)
 {
     if (! loaded.instances.len ())
-        return;
+        return set;
 
-    PluginData & plugin = loaded.plugin;
-    const LADSPA_Descriptor & desc = plugin.desc;
+    assert (loaded.plugin.in_ports.len () * loaded.instances.len () == ladspa_channels);
 
-    int ports = plugin.in_ports.len ();
-    int instances = loaded.instances.len ();
-    assert (ports * instances == ladspa_channels);
+    int out_set = wire_plugin (loaded, set);
+    RunJob job = {& loaded, frames};
 
+    if (ladspa_threads)
+        workers_run (loaded.instances.len (), run_instance, & job);
+    else
+    {
+        for (int i = 0; i < loaded.instances.len (); i ++)
+            run_instance (i, & job);
+    }
+
+    return out_set;
+}
+
+/* Fixed channel counts let the compiler unroll the channel loop and vectorize
+ * the frame loop (a transpose of a frames x channels matrix). */
+template<int channels>
+static void deinterleave_n (const audio_sample * __restrict data, int frames)
+{
+    for (int c = 0; c < channels; c ++)
+    {
+        LADSPA_Data * __restrict out = chain_buf (0, c);
+        for (int f = 0; f < frames; f ++)
+            out[f] = data[channels * f + c];
+    }
+}
+
+template<int channels>
+static void interleave_n (audio_sample * __restrict data, int frames, int set)
+{
+    for (int c = 0; c < channels; c ++)
+    {
+        const LADSPA_Data * __restrict in = chain_buf (set, c);
+        for (int f = 0; f < frames; f ++)
+            data[channels * f + c] = in[f];
+    }
+}
+
+static void deinterleave (const audio_sample * data, int frames)
+{
+    switch (ladspa_channels)
+    {
+        case 1: deinterleave_n<1> (data, frames); return;
+        case 2: deinterleave_n<2> (data, frames); return;
+        case 6: deinterleave_n<6> (data, frames); return;
+    }
+
+    for (int c = 0; c < ladspa_channels; c ++)
+    {
+        LADSPA_Data * out = chain_buf (0, c);
+        for (int f = 0; f < frames; f ++)
+            out[f] = data[ladspa_channels * f + c];
+    }
+}
+
+static void interleave (audio_sample * data, int frames, int set)
+{
+    switch (ladspa_channels)
+    {
+        case 1: interleave_n<1> (data, frames, set); return;
+        case 2: interleave_n<2> (data, frames, set); return;
+        case 6: interleave_n<6> (data, frames, set); return;
+    }
+
+    for (int c = 0; c < ladspa_channels; c ++)
+    {
+        const LADSPA_Data * in = chain_buf (set, c);
+        for (int f = 0; f < frames; f ++)
+            data[ladspa_channels * f + c] = in[f];
+    }
+}
+
+static void run_chain (audio_sample * data, int samples)
+{
     while (samples / ladspa_channels > 0)
     {
         int frames = aud::min (samples / ladspa_channels, LADSPA_BUFLEN);
+        int set = 0;
 
-        for (int i = 0; i < instances; i ++)
-        {
-            LADSPA_Handle handle = loaded.instances[i];
-
-            for (int p = 0; p < ports; p ++)
-            {
-                int channel = ports * i + p;
-                audio_sample * get = data + channel;
-                LADSPA_Data * in = loaded.in_bufs[channel].begin ();
-                const LADSPA_Data * in_end = in + frames;
-
-                while (in < in_end)
-                {
-                    * in ++ = * get;
-                    get += ladspa_channels;
-                }
-            }
-
-            desc.run (handle, frames);
-
-            for (int p = 0; p < ports; p ++)
-            {
-                int channel = ports * i + p;
-                audio_sample * set = data + channel;
-                LADSPA_Data * out = loaded.out_bufs[channel].begin ();
-                const LADSPA_Data * out_end = out + frames;
-
-                while (out < out_end)
-                {
-                    * set = * out ++;
-                    set += ladspa_channels;
-                }
-            }
-        }
+        deinterleave (data, frames);
+
+        for (auto & loaded : loadeds)
+            set = run_plugin (* loaded, frames, set);
+
+        interleave (data, frames, set);
 
         data += ladspa_channels * frames;
         samples -= ladspa_channels * frames;
@@ -181,8 +264,6 @@ void shutdown_plugin_locked (LoadedPlugin & loaded)
     }
 
     loaded.instances.clear ();
-    loaded.in_bufs.clear ();
-    loaded.out_bufs.clear ();
 }
 
 void LADSPAHost::start (int & channels, int & rate)
@@ -194,6 +275,15 @@ void LADSPAHost::start (int & channels, int & rate)
 
     ladspa_channels = channels;
     ladspa_rate = rate;
+    ladspa_threads = aud_get_bool ("ladspa", "threads");
+
+    for (auto & bufs : chain_bufs)
+        bufs.resize (LADSPA_BUFLEN * channels);
+
+    if (ladspa_threads)
+        workers_start ();
+    else
+        workers_stop ();
 
     pthread_mutex_unlock (& mutex);
 }
@@ -203,10 +293,9 @@ Index<audio_sample> & LADSPAHost::process (Index<audio_sample> & data)
     pthread_mutex_lock (& mutex);
 
     for (auto & loaded : loadeds)
-    {
         start_plugin (* loaded);
-        run_plugin (* loaded, data.begin (), data.len ());
-    }
+
+    run_chain (data.begin (), data.len ());
 
     pthread_mutex_unlock (& mutex);
     return data;
@@ -228,11 +317,13 @@ Index<audio_sample> & LADSPAHost::finish (Index<audio_sample> & data, bool end_o
     pthread_mutex_lock (& mutex);
 
     for (auto & loaded : loadeds)
-    {
         start_plugin (* loaded);
-        run_plugin (* loaded, data.begin (), data.len ());
 
-        if (end_of_playlist)
+    run_chain (data.begin (), data.len ());
+
+    if (end_of_playlist)
+    {
+        for (auto & loaded : loadeds)
             shutdown_plugin_locked (* loaded);
     }
 
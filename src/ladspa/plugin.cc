@@ -37,6 +37,7 @@
 
 const char * const LADSPAHost::defaults[] = {
  "plugin_count", "0",
+ "threads", "FALSE",
  nullptr};
 
 pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -330,6 +331,8 @@ void LADSPAHost::cleanup ()
     module_path = String ();
 
     pthread_mutex_unlock (& mutex);
+
+    workers_stop ();
 }
 
 static void set_module_path (GtkEntry * entry)
@@ -562,7 +565,9 @@ const char LADSPAHost::about[] =
     "Copyright 2011 John Lindgren");
 
 const PreferencesWidget LADSPAHost::widgets[] = {
-    WidgetCustomGTK (make_config_widget)
+    WidgetCustomGTK (make_config_widget),
+    WidgetCheck (N_("Run plugins on several CPU cores"),
+        WidgetBool ("ladspa", "threads"))
 };
 
 const PluginPreferences LADSPAHost::prefs = {{widgets}};
@@ -59,7 +59,7 @@ struct LoadedPlugin
     bool selected = false;
     bool active = false;
     Index<LADSPA_Handle> instances;
-    Index<Index<LADSPA_Data>> in_bufs, out_bufs;
+    int wired = -1; /* buffer set the audio ports read from */
     GtkWidget * settings_win = nullptr;
 
     LoadedPlugin (PluginData & plugin) :
@@ -114,6 +114,17 @@ void disable_plugin_locked (LoadedPlugin & loaded);
 
 void shutdown_plugin_locked (LoadedPlugin & loaded);
 
+/* workers.c */
+
+typedef void (* WorkerFunc) (int task, void * data);
+
+void workers_start ();
+void workers_stop ();
+
+/* Calls func () for each task from 0 to tasks - 1, spread over the workers if
+ * they are running, and returns when all are done. */
+void workers_run (int tasks, WorkerFunc func, void * data);
+
 /* plugin-list.c */
 
 GtkWidget * create_plugin_list ();
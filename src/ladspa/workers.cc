@@ -0,0 +1,195 @@
+/*
+ * LADSPA Host for Audacious
+ * Copyright 2011 John Lindgren
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#include "plugin.h"
+
+#include <libaudcore/runtime.h>
+
+#define MAX_WORKERS 4
+
+/* A small pool of threads that help the audio thread run independent plugin
+ * instances.  The audio thread hands out a job and then works on it too, so
+ * a job with N tasks keeps up to N cores busy. */
+
+static pthread_t threads[MAX_WORKERS];
+static int n_threads;
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+
+static int generation;
+static bool quit;
+static int finished; /* workers done with the current job */
+
+static WorkerFunc job_func;
+static void * job_data;
+static int job_tasks;
+static std::atomic<int> next_task;
+
+static void do_tasks ()
+{
+    int task;
+    while ((task = next_task ++) < job_tasks)
+        job_func (task, job_data);
+}
+
+/* <arg> is the generation when the worker was created; one handed out since
+ * then is not missed, even if the thread has not run yet */
+static void * worker (void * arg)
+{
+    int seen = (intptr_t) arg;
+
+    pthread_mutex_lock (& pool_mutex);
+
+    while (1)
+    {
+        while (! quit && generation == seen)
+            pthread_cond_wait (& work_cond, & pool_mutex);
+
+        if (quit)
+            break;
+
+        seen = generation;
+
+        pthread_mutex_unlock (& pool_mutex);
+        do_tasks ();
+        pthread_mutex_lock (& pool_mutex);
+
+        if (++ finished == n_threads)
+            pthread_cond_signal (& done_cond);
+    }
+
+    pthread_mutex_unlock (& pool_mutex);
+    return nullptr;
+}
+
+/* Keeps each worker on a core of its own.  The first of the allowed cores is
+ * skipped, since the audio thread is most likely there. */
+static void pin_thread (pthread_t thread, int index)
+{
+#ifdef __linux__
+    cpu_set_t allowed;
+    if (sched_getaffinity (0, sizeof allowed, & allowed))
+        return;
+
+    int count = CPU_COUNT (& allowed);
+    if (count < 2)
+        return;
+
+    int want = (index + 1) % count;
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu ++)
+    {
+        if (CPU_ISSET (cpu, & allowed) && ! want --)
+        {
+            cpu_set_t set;
+            CPU_ZERO (& set);
+            CPU_SET (cpu, & set);
+            pthread_setaffinity_np (thread, sizeof set, & set);
+            break;
+        }
+    }
+#endif
+}
+
+void workers_start ()
+{
+    if (n_threads)
+        return;
+
+    int cores = sysconf (_SC_NPROCESSORS_ONLN);
+    int count = aud::clamp (cores - 1, 0, MAX_WORKERS);
+
+    pthread_mutex_lock (& pool_mutex);
+
+    quit = false;
+
+    for (int i = 0; i < count; i ++)
+    {
+        if (pthread_create (& threads[n_threads], nullptr, worker, (void *) (intptr_t) generation))
+        {
+            AUDERR ("Failed to create worker thread.\n");
+            break;
+        }
+
+        pin_thread (threads[n_threads], n_threads);
+        n_threads ++;
+    }
+
+    pthread_mutex_unlock (& pool_mutex);
+}
+
+void workers_stop ()
+{
+    if (! n_threads)
+        return;
+
+    pthread_mutex_lock (& pool_mutex);
+    quit = true;
+    pthread_cond_broadcast (& work_cond);
+    pthread_mutex_unlock (& pool_mutex);
+
+    for (int i = 0; i < n_threads; i ++)
+        pthread_join (threads[i], nullptr);
+
+    n_threads = 0;
+}
+
+void workers_run (int tasks, WorkerFunc func, void * data)
+{
+    if (! n_threads || tasks < 2)
+    {
+        for (int task = 0; task < tasks; task ++)
+            func (task, data);
+
+        return;
+    }
+
+    pthread_mutex_lock (& pool_mutex);
+
+    job_func = func;
+    job_data = data;
+    job_tasks = tasks;
+    next_task = 0;
+    finished = 0;
+
+    generation ++;
+    pthread_cond_broadcast (& work_cond);
+    pthread_mutex_unlock (& pool_mutex);
+
+    do_tasks ();
+
+    /* every worker has to check in, even one that wakes up too late to find
+     * anything left to do, so that none is still looking at this job when the
+     * next one is handed out */
+    pthread_mutex_lock (& pool_mutex);
+
+    while (finished < n_threads)
+        pthread_cond_wait (& done_cond, & pool_mutex);
+
+    pthread_mutex_unlock (& pool_mutex);
+}
@@ -0,0 +1,398 @@
+/*
+ * Loudness measurement (ITU-R BS.1770 / EBU R128) for Audacious plugins
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "loudness.h"
+
+#define ABSOLUTE_GATE   -70.0  /* LUFS */
+#define RELATIVE_GATE   -10.0  /* LU, integrated loudness */
+#define RANGE_GATE      -20.0  /* LU, loudness range */
+
+#define PEAK_TAPS  12  /* per phase of the true peak interpolator */
+
+static double energy_to_lufs (double energy)
+    { return (energy > 0) ? -0.691 + 10 * log10 (energy) : -HUGE_VAL; }
+static double lufs_to_energy (double lufs)
+    { return pow (10, (lufs + 0.691) / 10); }
+
+/* The filter coefficients are derived for any rate the same way as by
+ * libebur128; at 48 kHz they match the tables of BS.1770. */
+void KFilter::setup (int channels, int rate)
+{
+    double f0 = 1681.974450955533;
+    double G = 3.999843853973347;
+    double Q = 0.7071752369554196;
+
+    double K = tan (M_PI * f0 / rate);
+    double Vh = pow (10, G / 20);
+    double Vb = pow (Vh, 0.4996667741545416);
+    double a0 = 1 + K / Q + K * K;
+
+    m_b[0][0] = (Vh + Vb * K / Q + K * K) / a0;
+    m_b[0][1] = 2 * (K * K - Vh) / a0;
+    m_b[0][2] = (Vh - Vb * K / Q + K * K) / a0;
+    m_a[0][0] = 1;
+    m_a[0][1] = 2 * (K * K - 1) / a0;
+    m_a[0][2] = (1 - K / Q + K * K) / a0;
+
+    f0 = 38.13547087602444;
+    Q = 0.5003270373238773;
+
+    K = tan (M_PI * f0 / rate);
+    a0 = 1 + K / Q + K * K;
+
+    m_b[1][0] = 1;
+    m_b[1][1] = -2;
+    m_b[1][2] = 1;
+    m_a[1][0] = 1;
+    m_a[1][1] = 2 * (K * K - 1) / a0;
+    m_a[1][2] = (1 - K / Q + K * K) / a0;
+
+    m_channels = channels;
+    m_state.resize (4 * channels);
+    reset ();
+}
+
+void KFilter::reset ()
+{
+    for (double & s : m_state)
+        s = 0;
+}
+
+/* both stages as transposed direct form II; <N> is the channel count, or 0
+ * for a count only known at run time */
+template<int N>
+static void run_kfilter (const double (* b)[3], const double (* a)[3],
+ double * state, const audio_sample * in, audio_sample * out, int frames,
+ int channels)
+{
+    if (N)
+        channels = N;
+
+    double * s1 = state;
+    double * s2 = state + channels;
+    double * t1 = state + 2 * channels;
+    double * t2 = state + 3 * channels;
+
+    for (int f = 0; f < frames; f ++)
+    {
+        for (int c = 0; c < channels; c ++)
+        {
+            double x = in[c];
+            double y = b[0][0] * x + s1[c];
+            s1[c] = b[0][1] * x - a[0][1] * y + s2[c];
+            s2[c] = b[0][2] * x - a[0][2] * y;
+
+            double z = b[1][0] * y + t1[c];
+            t1[c] = b[1][1] * y - a[1][1] * z + t2[c];
+            t2[c] = b[1][2] * y - a[1][2] * z;
+
+            out[c] = z;
+        }
+
+        in += channels;
+        out += channels;
+    }
+}
+
+void KFilter::process (const audio_sample * in, audio_sample * out, int frames)
+{
+    switch (m_channels)
+    {
+    case 1:
+        run_kfilter<1> (m_b, m_a, m_state.begin (), in, out, frames, 1);
+        break;
+    case 2:
+        run_kfilter<2> (m_b, m_a, m_state.begin (), in, out, frames, 2);
+        break;
+    case 6:
+        run_kfilter<6> (m_b, m_a, m_state.begin (), in, out, frames, 6);
+        break;
+    default:
+        run_kfilter<0> (m_b, m_a, m_state.begin (), in, out, frames, m_channels);
+        break;
+    }
+}
+
+void LoudnessMeter::start (int channels, int rate)
+{
+    m_channels = channels;
+    m_rate = rate;
+    m_filter.setup (channels, rate);
+
+    /* BS.1770 weights the surround channels of 5.1 up and leaves out LFE */
+    m_weights.resize (channels);
+    for (int c = 0; c < channels; c ++)
+        m_weights[c] = 1;
+
+    if (channels == 6)
+    {
+        m_weights[3] = 0;
+        m_weights[4] = m_weights[5] = 1.41;
+    }
+
+    m_subblock_len = aud::max (rate / 10, 1);
+
+    /* the true peak is found by interpolating to at least 192 kHz with a
+     * windowed sinc, as suggested in BS.1770 annex 2 */
+    m_oversample = (rate < 96000) ? 4 : (rate < 192000) ? 2 : 1;
+
+    if (m_oversample > 1)
+    {
+        int L = m_oversample;
+        int len = L * PEAK_TAPS;
+        double center = (len - 1) / 2.0;
+
+        m_phases.resize (len);
+
+        for (int p = 0; p < L; p ++)
+        {
+            double sum = 0;
+
+            for (int j = 0; j < PEAK_TAPS; j ++)
+            {
+                int n = p + (PEAK_TAPS - 1 - j) * L;
+                double x = (n - center) / L;
+                double sinc = (x == 0) ? 1 : sin (M_PI * x) / (M_PI * x);
+                double window = 0.42 + 0.5 * cos (M_PI * (n - center) / (center + 1))
+                 + 0.08 * cos (2 * M_PI * (n - center) / (center + 1));
+
+                m_phases[p * PEAK_TAPS + j] = sinc * window;
+                sum += sinc * window;
+            }
+
+            /* each phase on its own passes DC unchanged */
+            for (int j = 0; j < PEAK_TAPS; j ++)
+                m_phases[p * PEAK_TAPS + j] /= sum;
+        }
+
+        m_history.resize (2 * PEAK_TAPS * channels);
+    }
+    else
+    {
+        m_phases.clear ();
+        m_history.clear ();
+    }
+
+    reset ();
+}
+
+void LoudnessMeter::reset ()
+{
+    m_filter.reset ();
+
+    m_subblock_count = 0;
+    m_subblock_pos = 0;
+    m_energy = 0;
+
+    m_blocks.resize (0);
+    m_short_blocks.resize (0);
+
+    m_sample_peak = m_true_peak = 0;
+
+    for (float & h : m_history)
+        h = 0;
+
+    m_history_pos = 0;
+}
+
+void LoudnessMeter::scan_true_peak (const audio_sample * data, int frames)
+{
+    int L = m_oversample;
+    float peak = m_true_peak;
+
+    for (int f = 0; f < frames; f ++)
+    {
+        int pos = m_history_pos = (m_history_pos + 1) % PEAK_TAPS;
+
+        for (int c = 0; c < m_channels; c ++)
+        {
+            float * hist = & m_history[2 * PEAK_TAPS * c];
+            hist[pos] = hist[pos + PEAK_TAPS] = data[c];
+
+            /* the last PEAK_TAPS samples, oldest first */
+            const float * window = hist + pos + 1;
+
+            for (int p = 0; p < L; p ++)
+            {
+                const float * taps = & m_phases[p * PEAK_TAPS];
+                float y = 0;
+
+                for (int j = 0; j < PEAK_TAPS; j ++)
+                    y += taps[j] * window[j];
+
+                y = fabsf (y);
+                peak = (y > peak) ? y : peak;
+            }
+        }
+
+        data += m_channels;
+    }
+
+    m_true_peak = peak;
+}
+
+void LoudnessMeter::process (const audio_sample * data, int frames)
+{
+    int samples = frames * m_channels;
+
+    audio_sample peak = m_sample_peak;
+    for (int i = 0; i < samples; i ++)
+    {
+        audio_sample a = data[i] < 0 ? -data[i] : data[i];
+        peak = (a > peak) ? a : peak;
+    }
+
+    m_sample_peak = peak;
+
+    if (m_oversample > 1)
+        scan_true_peak (data, frames);
+    else
+        m_true_peak = m_sample_peak;
+
+    m_filtered.resize (samples);
+    m_filter.process (data, m_filtered.begin (), frames);
+
+    const audio_sample * in = m_filtered.begin ();
+
+    while (frames)
+    {
+        int count = aud::min (frames, m_subblock_len - m_subblock_pos);
+
+        for (int c = 0; c < m_channels; c ++)
+        {
+            if (! m_weights[c])
+                continue;
+
+            double sum = 0;
+            for (int f = 0; f < count; f ++)
+                sum += in[f * m_channels + c] * in[f * m_channels + c];
+
+            m_energy += m_weights[c] * sum;
+        }
+
+        in += count * m_channels;
+        frames -= count;
+
+        if ((m_subblock_pos += count) == m_subblock_len)
+            end_subblock ();
+    }
+}
+
+/* The gating blocks of 400 ms overlap by 75%, so a new one ends with every
+ * subblock of 100 ms; likewise a new block for the range (which BS.1770 lets
+ * overlap by more than EBU Tech 3342's minimum) ends with every subblock. */
+void LoudnessMeter::end_subblock ()
+{
+    m_subblocks[m_subblock_count % 30] = m_energy / m_subblock_len;
+    m_subblock_count ++;
+
+    m_energy = 0;
+    m_subblock_pos = 0;
+
+    if (m_subblock_count >= 4)
+        m_blocks.append (lufs_to_energy (momentary ()));
+    if (m_subblock_count >= 30)
+        m_short_blocks.append (lufs_to_energy (short_term ()));
+}
+
+static double mean_subblocks (const double * subblocks, int count, int len)
+{
+    if (count < len)
+        return -HUGE_VAL;
+
+    double sum = 0;
+    for (int i = count - len; i < count; i ++)
+        sum += subblocks[i % 30];
+
+    return energy_to_lufs (sum / len);
+}
+
+double LoudnessMeter::momentary () const
+    { return mean_subblocks (m_subblocks, m_subblock_count, 4); }
+double LoudnessMeter::short_term () const
+    { return mean_subblocks (m_subblocks, m_subblock_count, 30); }
+
+/* mean energy of the blocks above <gate> (an energy too) */
+static double gated_mean (const Index<float> & blocks, double gate)
+{
+    double sum = 0;
+    int count = 0;
+
+    for (float energy : blocks)
+    {
+        if (energy > gate)
+        {
+            sum += energy;
+            count ++;
+        }
+    }
+
+    return count ? sum / count : 0;
+}
+
+double LoudnessMeter::integrated () const
+{
+    double mean = gated_mean (m_blocks, lufs_to_energy (ABSOLUTE_GATE));
+    if (! mean)
+        return -HUGE_VAL;
+
+    double gate = mean * pow (10, RELATIVE_GATE / 10);
+    return energy_to_lufs (gated_mean (m_blocks, gate));
+}
+
+double LoudnessMeter::range () const
+{
+    double mean = gated_mean (m_short_blocks, lufs_to_energy (ABSOLUTE_GATE));
+    if (! mean)
+        return 0;
+
+    double gate = mean * pow (10, RANGE_GATE / 10);
+
+    Index<float> values;
+    for (float energy : m_short_blocks)
+    {
+        if (energy > gate)
+            values.append (energy);
+    }
+
+    if (values.len () < 2)
+        return 0;
+
+    values.sort ([] (const float & a, const float & b)
+        { return (a > b) - (a < b); });
+
+    /* the range is the spread from the 10th to the 95th percentile */
+    int n = values.len ();
+    double low = values[(int) ((n - 1) * 0.10 + 0.5)];
+    double high = values[(int) ((n - 1) * 0.95 + 0.5)];
+
+    return energy_to_lufs (high) - energy_to_lufs (low);
+}
+
+void LoudnessMeter::add (const LoudnessMeter & other)
+{
+    m_blocks.insert (other.m_blocks.begin (), -1, other.m_blocks.len ());
+    m_short_blocks.insert (other.m_short_blocks.begin (), -1, other.m_short_blocks.len ());
+
+    m_sample_peak = aud::max (m_sample_peak, other.m_sample_peak);
+    m_true_peak = aud::max (m_true_peak, other.m_true_peak);
+}
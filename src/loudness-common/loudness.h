@@ -0,0 +1,97 @@
+/*
+ * Loudness measurement (ITU-R BS.1770 / EBU R128) for Audacious plugins
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef AUDACIOUS_LOUDNESS_H
+#define AUDACIOUS_LOUDNESS_H
+
+#include <libaudcore/index.h>
+#include <libaudcore/plugin.h>
+
+/* The K-weighting filter of BS.1770: a high shelf modelling the head followed
+ * by a high pass.  The state of all channels is kept side by side, so the
+ * per-frame work over the channels vectorizes. */
+class KFilter
+{
+public:
+    void setup (int channels, int rate);
+    void reset ();
+
+    /* interleaved; <in> and <out> may be the same */
+    void process (const audio_sample * in, audio_sample * out, int frames);
+
+private:
+    int m_channels = 0;
+    double m_b[2][3] {}, m_a[2][3] {};
+    Index<double> m_state; /* [stage][delay][channel] */
+};
+
+/* A BS.1770-4 loudness meter with the EBU R128 measures: momentary (400 ms),
+ * short-term (3 s), gated integrated loudness, loudness range, and sample and
+ * true peak.  Loudness values are in LUFS (LU for the range), peaks are linear;
+ * loudness of silence is -HUGE_VAL. */
+class LoudnessMeter
+{
+public:
+    void start (int channels, int rate);
+    void reset ();
+
+    /* interleaved */
+    void process (const audio_sample * data, int frames);
+
+    double momentary () const;
+    double short_term () const;
+    double integrated () const;
+    double range () const;
+
+    double sample_peak () const
+        { return m_sample_peak; }
+    double true_peak () const
+        { return m_true_peak; }
+
+    /* takes in the measurements of another meter, so that a meter can give
+     * the values for a whole album */
+    void add (const LoudnessMeter & other);
+
+private:
+    void end_subblock ();
+    void scan_true_peak (const audio_sample * data, int frames);
+
+    int m_channels = 0, m_rate = 0;
+    KFilter m_filter;
+    Index<double> m_weights;
+    Index<audio_sample> m_filtered;
+
+    /* energy of each of the last 30 subblocks of 100 ms */
+    double m_subblocks[30] {};
+    int m_subblock_count = 0;
+    int m_subblock_len = 0, m_subblock_pos = 0;
+    double m_energy = 0;
+
+    Index<float> m_blocks;       /* 400 ms gating blocks, for integrated */
+    Index<float> m_short_blocks; /* 3 s blocks, for the range */
+
+    double m_sample_peak = 0, m_true_peak = 0;
+
+    int m_oversample = 1;
+    Index<float> m_phases;  /* [phase][tap], taps in history order */
+    Index<float> m_history; /* [channel][2 * taps] */
+    int m_history_pos = 0;
+};
+
+#endif
@@ -0,0 +1,475 @@
+/*
+ * Channel Mixer Plugin for Audacious
+ * Copyright 2011-2012 John Lindgren and Michał Lipski
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <libaudcore/audstrings.h>
+
+#include "matrix.h"
+
+/* The SIMD kernels only handle 32-bit floats. */
+#ifndef DEF_AUDIO_FLOAT64
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define MIX_SSE2
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MIX_NEON
+#endif
+#endif
+
+#define MINUS_3DB 0.70710678f
+
+/* speaker positions, in the channel orders that Audacious uses */
+enum {
+    FL, FR, FC, LFE, BL, BR, SL, SR, BC, N_POSITIONS
+};
+
+#define MAX_LAYOUT 8
+
+static const signed char layouts[MAX_LAYOUT + 1][MAX_LAYOUT] = {
+    {},
+    {FC},
+    {FL, FR},
+    {FL, FR, FC},
+    {FL, FR, BL, BR},
+    {FL, FR, FC, BL, BR},
+    {FL, FR, FC, LFE, BL, BR},
+    {FL, FR, FC, LFE, BC, SL, SR},
+    {FL, FR, FC, LFE, BL, BR, SL, SR}
+};
+
+/* adds a channel at position <pos> to the speakers that are <present>, folding
+ * it into the nearest ones where it is missing */
+static void spread (int pos, const bool * present, float gain, float * to)
+{
+    if (present[pos])
+    {
+        to[pos] += gain;
+        return;
+    }
+
+    switch (pos)
+    {
+    case FC:
+        spread (FL, present, gain * MINUS_3DB, to);
+        spread (FR, present, gain * MINUS_3DB, to);
+        break;
+    case BL:
+        if (present[SL])
+            spread (SL, present, gain, to);
+        else
+            spread (FL, present, gain * MINUS_3DB, to);
+        break;
+    case BR:
+        if (present[SR])
+            spread (SR, present, gain, to);
+        else
+            spread (FR, present, gain * MINUS_3DB, to);
+        break;
+    case SL:
+        if (present[BL])
+            spread (BL, present, gain, to);
+        else
+            spread (FL, present, gain * MINUS_3DB, to);
+        break;
+    case SR:
+        if (present[BR])
+            spread (BR, present, gain, to);
+        else
+            spread (FR, present, gain * MINUS_3DB, to);
+        break;
+    case BC:
+        spread (BL, present, gain * MINUS_3DB, to);
+        spread (BR, present, gain * MINUS_3DB, to);
+        break;
+    }
+
+    /* FL and FR are only missing in mono, which is made from stereo; LFE is
+     * left out of a downmix */
+}
+
+static void standard_matrix (int in, int out, audio_sample * matrix)
+{
+    for (int i = 0; i < in * out; i ++)
+        matrix[i] = 0;
+
+    if (in > MAX_LAYOUT || out > MAX_LAYOUT)
+    {
+        for (int i = 0; i < aud::min (in, out); i ++)
+            matrix[i * in + i] = 1;
+
+        return;
+    }
+
+    /* mono is the mean of the stereo downmix */
+    int mix_out = (out == 1 && in > 1) ? 2 : out;
+
+    bool present[N_POSITIONS] = {};
+    for (int o = 0; o < mix_out; o ++)
+        present[layouts[mix_out][o]] = true;
+
+    for (int i = 0; i < in; i ++)
+    {
+        float to[N_POSITIONS] = {};
+        spread (layouts[in][i], present, 1, to);
+
+        for (int o = 0; o < mix_out; o ++)
+        {
+            float gain = to[layouts[mix_out][o]];
+            if (mix_out != out)
+                matrix[i] += gain / 2;
+            else
+                matrix[o * in + i] = gain;
+        }
+    }
+}
+
+static const audio_sample classic_1_2[] = {1, 1};
+static const audio_sample classic_2_1[] = {0.5, 0.5};
+static const audio_sample classic_2_4[] = {1, 0, 0, 1, 1, 0, 0, 1};
+static const audio_sample classic_4_2[] = {1, 0, 0.7, 0, 0, 1, 0, 0.7};
+static const audio_sample classic_5_2[] = {1, 0, 0.5, 1, 0, 0, 1, 0.5, 0, 1};
+static const audio_sample classic_6_2[] =
+ {1, 0, 0.5, 0.5, 0.5, 0, 0, 1, 0.5, 0.5, 0, 0.5};
+
+static const audio_sample * classic_matrix (int in, int out)
+{
+    if (in == 1 && out == 2)
+        return classic_1_2;
+    if (in == 2 && out == 1)
+        return classic_2_1;
+    if (in == 2 && out == 4)
+        return classic_2_4;
+    if (in == 4 && out == 2)
+        return classic_4_2;
+    if (in == 5 && out == 2)
+        return classic_5_2;
+    if (in == 6 && out == 2)
+        return classic_6_2;
+
+    return nullptr;
+}
+
+/* BS.775 only covers downmixing, so upmixing is done as before */
+void matrix_from_preset (int preset, int in, int out, audio_sample * matrix)
+{
+    const audio_sample * classic;
+
+    if ((preset == PRESET_CLASSIC || in < out) && (classic = classic_matrix (in, out)))
+        memcpy (matrix, classic, sizeof (audio_sample) * in * out);
+    else
+        standard_matrix (in, out, matrix);
+}
+
+/* splits on any of <delims>, skipping empty items */
+static Index<String> split (const char * text, const char * delims)
+{
+    Index<String> items = str_list_to_index (text, delims);
+
+    for (int i = items.len (); i --; )
+    {
+        if (! items[i][0])
+            items.remove (i, 1);
+    }
+
+    return items;
+}
+
+bool matrix_from_string (const char * text, int in, int out, audio_sample * matrix)
+{
+    for (const String & part : split (text, "|"))
+    {
+        Index<String> rows = split (part, ";");
+        if (rows.len () != out)
+            continue;
+
+        bool fits = true;
+
+        for (int o = 0; o < out && fits; o ++)
+        {
+            Index<String> values = split (rows[o], " ,\t");
+            if (values.len () != in)
+            {
+                fits = false;
+                break;
+            }
+
+            for (int i = 0; i < in; i ++)
+                matrix[o * in + i] = str_to_double (values[i]);
+        }
+
+        if (fits)
+            return true;
+    }
+
+    return false;
+}
+
+void matrix_normalize (int in, int out, audio_sample * matrix)
+{
+    for (int o = 0; o < out; o ++)
+    {
+        audio_sample * row = matrix + o * in;
+        audio_sample sum = 0;
+
+        for (int i = 0; i < in; i ++)
+            sum += fabs (row[i]);
+
+        if (sum > 1)
+        {
+            for (int i = 0; i < in; i ++)
+                row[i] /= sum;
+        }
+    }
+}
+
+/* The kernels with the shape fixed at compile time keep the coefficients in
+ * registers and leave the unrolling to the compiler. */
+template<int IN, int OUT>
+static void mix_fixed (const audio_sample * matrix, int, int,
+ const audio_sample * in, audio_sample * out, int frames)
+{
+    for (int f = 0; f < frames; f ++)
+    {
+        for (int o = 0; o < OUT; o ++)
+        {
+            audio_sample sum = 0;
+            for (int i = 0; i < IN; i ++)
+                sum += matrix[o * IN + i] * in[i];
+
+            out[o] = sum;
+        }
+
+        in += IN;
+        out += OUT;
+    }
+}
+
+static void mix_generic (const audio_sample * matrix, int n_in, int n_out,
+ const audio_sample * in, audio_sample * out, int frames)
+{
+    for (int f = 0; f < frames; f ++)
+    {
+        for (int o = 0; o < n_out; o ++)
+        {
+            const audio_sample * row = matrix + o * n_in;
+            audio_sample sum = 0;
+
+            for (int i = 0; i < n_in; i ++)
+                sum += row[i] * in[i];
+
+            out[o] = sum;
+        }
+
+        in += n_in;
+        out += n_out;
+    }
+}
+
+#ifdef MIX_SSE2
+static void mix_1_2_sse2 (const float * matrix, int, int, const float * in,
+ float * out, int frames)
+{
+    __m128 left = _mm_set1_ps (matrix[0]);
+    __m128 right = _mm_set1_ps (matrix[1]);
+
+    int f = 0;
+    for (; f + 4 <= frames; f += 4)
+    {
+        __m128 x = _mm_loadu_ps (in + f);
+        __m128 l = _mm_mul_ps (x, left);
+        __m128 r = _mm_mul_ps (x, right);
+        _mm_storeu_ps (out + 2 * f, _mm_unpacklo_ps (l, r));
+        _mm_storeu_ps (out + 2 * f + 4, _mm_unpackhi_ps (l, r));
+    }
+
+    mix_fixed<1, 2> (matrix, 1, 2, in + f, out + 2 * f, frames - f);
+}
+
+static void mix_2_1_sse2 (const float * matrix, int, int, const float * in,
+ float * out, int frames)
+{
+    __m128 left = _mm_set1_ps (matrix[0]);
+    __m128 right = _mm_set1_ps (matrix[1]);
+
+    int f = 0;
+    for (; f + 4 <= frames; f += 4)
+    {
+        __m128 a = _mm_loadu_ps (in + 2 * f);
+        __m128 b = _mm_loadu_ps (in + 2 * f + 4);
+        __m128 l = _mm_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0));
+        __m128 r = _mm_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1));
+        _mm_storeu_ps (out + f, _mm_add_ps (_mm_mul_ps (l, left), _mm_mul_ps (r, right)));
+    }
+
+    mix_fixed<2, 1> (matrix, 2, 1, in + 2 * f, out + f, frames - f);
+}
+
+/* 6 or 8 channels to stereo: each output is a dot product of the frame with a
+ * row, and both are summed horizontally together */
+template<int IN>
+static void mix_to_stereo_sse2 (const float * matrix, int, int, const float * in,
+ float * out, int frames)
+{
+    static_assert (IN == 6 || IN == 8, "6 or 8 channels");
+
+    float rows[2][8] = {};
+    for (int o = 0; o < 2; o ++)
+        memcpy (rows[o], matrix + o * IN, sizeof (float) * IN);
+
+    __m128 l0 = _mm_loadu_ps (rows[0]), l1 = _mm_loadu_ps (rows[0] + 4);
+    __m128 r0 = _mm_loadu_ps (rows[1]), r1 = _mm_loadu_ps (rows[1] + 4);
+
+    for (int f = 0; f < frames; f ++)
+    {
+        __m128 x0 = _mm_loadu_ps (in);
+        __m128 x1 = (IN == 8) ? _mm_loadu_ps (in + 4) :
+         _mm_loadl_pi (_mm_setzero_ps (), (const __m64 *) (in + 4));
+
+        __m128 l = _mm_add_ps (_mm_mul_ps (x0, l0), _mm_mul_ps (x1, l1));
+        __m128 r = _mm_add_ps (_mm_mul_ps (x0, r0), _mm_mul_ps (x1, r1));
+
+        /* {l0 + l2, r0 + r2, l1 + l3, r1 + r3} */
+        __m128 t = _mm_add_ps (_mm_unpacklo_ps (l, r), _mm_unpackhi_ps (l, r));
+        _mm_storel_pi ((__m64 *) out, _mm_add_ps (t, _mm_movehl_ps (t, t)));
+
+        in += IN;
+        out += 2;
+    }
+}
+#endif
+
+#ifdef MIX_NEON
+static void mix_1_2_neon (const float * matrix, int, int, const float * in,
+ float * out, int frames)
+{
+    int f = 0;
+    for (; f + 4 <= frames; f += 4)
+    {
+        float32x4_t x = vld1q_f32 (in + f);
+        float32x4x2_t lr = {{vmulq_n_f32 (x, matrix[0]), vmulq_n_f32 (x, matrix[1])}};
+        vst2q_f32 (out + 2 * f, lr);
+    }
+
+    mix_fixed<1, 2> (matrix, 1, 2, in + f, out + 2 * f, frames - f);
+}
+
+static void mix_2_1_neon (const float * matrix, int, int, const float * in,
+ float * out, int frames)
+{
+    int f = 0;
+    for (; f + 4 <= frames; f += 4)
+    {
+        float32x4x2_t lr = vld2q_f32 (in + 2 * f);
+        float32x4_t sum = vmulq_n_f32 (lr.val[0], matrix[0]);
+        vst1q_f32 (out + f, vmlaq_n_f32 (sum, lr.val[1], matrix[1]));
+    }
+
+    mix_fixed<2, 1> (matrix, 2, 1, in + 2 * f, out + f, frames - f);
+}
+
+template<int IN>
+static void mix_to_stereo_neon (const float * matrix, int, int, const float * in,
+ float * out, int frames)
+{
+    static_assert (IN == 6 || IN == 8, "6 or 8 channels");
+
+    float rows[2][8] = {};
+    for (int o = 0; o < 2; o ++)
+        memcpy (rows[o], matrix + o * IN, sizeof (float) * IN);
+
+    float32x4_t l0 = vld1q_f32 (rows[0]), l1 = vld1q_f32 (rows[0] + 4);
+    float32x4_t r0 = vld1q_f32 (rows[1]), r1 = vld1q_f32 (rows[1] + 4);
+
+    for (int f = 0; f < frames; f ++)
+    {
+        float32x4_t x0 = vld1q_f32 (in);
+        float32x4_t x1 = (IN == 8) ? vld1q_f32 (in + 4) :
+         vcombine_f32 (vld1_f32 (in + 4), vdup_n_f32 (0));
+
+        float32x4_t l = vmlaq_f32 (vmulq_f32 (x0, l0), x1, l1);
+        float32x4_t r = vmlaq_f32 (vmulq_f32 (x0, r0), x1, r1);
+
+        float32x2_t ls = vadd_f32 (vget_low_f32 (l), vget_high_f32 (l));
+        float32x2_t rs = vadd_f32 (vget_low_f32 (r), vget_high_f32 (r));
+        vst1_f32 (out, vpadd_f32 (ls, rs));
+
+        in += IN;
+        out += 2;
+    }
+}
+#endif
+
+MixFunc matrix_get_func (int in, int out)
+{
+    if (in == 1 && out == 2)
+    {
+#if defined(MIX_SSE2)
+        return mix_1_2_sse2;
+#elif defined(MIX_NEON)
+        return mix_1_2_neon;
+#else
+        return mix_fixed<1, 2>;
+#endif
+    }
+    if (in == 2 && out == 1)
+    {
+#if defined(MIX_SSE2)
+        return mix_2_1_sse2;
+#elif defined(MIX_NEON)
+        return mix_2_1_neon;
+#else
+        return mix_fixed<2, 1>;
+#endif
+    }
+    if (in == 6 && out == 2)
+    {
+#if defined(MIX_SSE2)
+        return mix_to_stereo_sse2<6>;
+#elif defined(MIX_NEON)
+        return mix_to_stereo_neon<6>;
+#else
+        return mix_fixed<6, 2>;
+#endif
+    }
+    if (in == 8 && out == 2)
+    {
+#if defined(MIX_SSE2)
+        return mix_to_stereo_sse2<8>;
+#elif defined(MIX_NEON)
+        return mix_to_stereo_neon<8>;
+#else
+        return mix_fixed<8, 2>;
+#endif
+    }
+
+    if (in == 2 && out == 4)
+        return mix_fixed<2, 4>;
+    if (in == 4 && out == 2)
+        return mix_fixed<4, 2>;
+    if (in == 5 && out == 2)
+        return mix_fixed<5, 2>;
+    if (in == 7 && out == 2)
+        return mix_fixed<7, 2>;
+
+    return mix_generic;
+}
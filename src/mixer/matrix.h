@@ -0,0 +1,52 @@
+/*
+ * Channel Mixer Plugin for Audacious
+ * Copyright 2011-2012 John Lindgren and Michał Lipski
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef MIXER_MATRIX_H
+#define MIXER_MATRIX_H
+
+#include <libaudcore/plugin.h>
+
+/* A mixing matrix has one row of <in> coefficients for each of the <out>
+ * output channels, so output channel o of a frame is the sum over i of
+ * matrix[o * in + i] * input channel i. */
+
+enum {
+    PRESET_STANDARD, /* ITU-R BS.775 downmix; LFE left out */
+    PRESET_CLASSIC,  /* the mixes of earlier versions */
+    PRESET_CUSTOM
+};
+
+/* The shape of the matrix is passed on with it; a function returned by
+ * matrix_get_func() for a given shape may ignore it. */
+typedef void (* MixFunc) (const audio_sample * matrix, int in_channels,
+ int out_channels, const audio_sample * in, audio_sample * out, int frames);
+
+void matrix_from_preset (int preset, int in, int out, audio_sample * matrix);
+
+/* Parses user-defined matrices, in which numbers are separated by spaces or
+ * commas, rows by semicolons and matrices by "|", and takes the one that has
+ * <out> rows of <in> numbers.  Returns false if there is none. */
+bool matrix_from_string (const char * text, int in, int out, audio_sample * matrix);
+
+/* scales rows down as needed so that no output can exceed full scale */
+void matrix_normalize (int in, int out, audio_sample * matrix);
+
+MixFunc matrix_get_func (int in, int out);
+
+#endif
@@ -17,8 +17,7 @@
  * the use of this software.
  */
 
-/* TODO: implement more surround converters.
-         There should be more options for in * out cases (for example,
+/* TODO: There should be more options for in * out cases (for example,
          the user may wish to mix stereo up to quadro but keep 5.1 as-is,
          rather than downmixing 5.1 to quadro). A possible design might
          be a choice of output channels for each input channel count that
@@ -31,6 +30,8 @@
 #include <libaudcore/plugin.h>
 #include <libaudcore/preferences.h>
 
+#include "matrix.h"
+
 class ChannelMixer : public EffectPlugin
 {
 public:
@@ -58,154 +59,13 @@ public:
 
 EXPORT ChannelMixer aud_plugin_instance;
 
-typedef Index<audio_sample> & (* Converter) (Index<audio_sample> & data);
-
 static Index<audio_sample> mixer_buf;
 
-static Index<audio_sample> & mono_to_stereo (Index<audio_sample> & data)
-{
-    int frames = data.len ();
-    mixer_buf.resize (2 * frames);
-
-    audio_sample * get = data.begin ();
-    audio_sample * set = mixer_buf.begin ();
-
-    while (frames --)
-    {
-        audio_sample val = * get ++;
-        * set ++ = val;
-        * set ++ = val;
-    }
-
-    return mixer_buf;
-}
-
-static Index<audio_sample> & stereo_to_mono (Index<audio_sample> & data)
-{
-    int frames = data.len () / 2;
-    mixer_buf.resize (frames);
-
-    audio_sample * get = data.begin ();
-    audio_sample * set = mixer_buf.begin ();
-
-    while (frames --)
-    {
-        audio_sample val = * get ++;
-        val += * get ++;
-        * set ++ = val / 2;
-    }
-
-    return mixer_buf;
-}
-
-static Index<audio_sample> & quadro_to_stereo (Index<audio_sample> & data)
-{
-    int frames = data.len () / 4;
-    mixer_buf.resize (2 * frames);
-
-    audio_sample * get = data.begin ();
-    audio_sample * set = mixer_buf.begin ();
-
-    while (frames --)
-    {
-        audio_sample front_left  = * get ++;
-        audio_sample front_right = * get ++;
-        audio_sample back_left   = * get ++;
-        audio_sample back_right  = * get ++;
-        * set ++ = front_left + (back_left * 0.7);
-        * set ++ = front_right + (back_right * 0.7);
-    }
-
-    return mixer_buf;
-}
-
-static Index<audio_sample> & stereo_to_quadro (Index<audio_sample> & data)
-{
-    int frames = data.len () / 2;
-    mixer_buf.resize (4 * frames);
-
-    audio_sample * get = data.begin ();
-    audio_sample * set = mixer_buf.begin();
-
-    while (frames --)
-    {
-        audio_sample left  = * get ++;
-        audio_sample right = * get ++;
-        * set ++ = left;   // front left
-        * set ++ = right;  // front right
-        * set ++ = left;   // rear left
-        * set ++ = right;  // rear right
-    }
-
-    return mixer_buf;
-}
-
-static Index<audio_sample> & surround_5p1_to_stereo (Index<audio_sample> & data)
-{
-    int frames = data.len () / 6;
-    mixer_buf.resize (2 * frames);
-
-    audio_sample * get = data.begin ();
-    audio_sample * set = mixer_buf.begin ();
-
-    while (frames --)
-    {
-        audio_sample front_left  = * get ++;
-        audio_sample front_right = * get ++;
-        audio_sample center = * get ++;
-        audio_sample lfe    = * get ++;
-        audio_sample rear_left   = * get ++;
-        audio_sample rear_right  = * get ++;
-        * set ++ = front_left + (center * 0.5) + (lfe * 0.5) + (rear_left * 0.5);
-        * set ++ = front_right + (center * 0.5) + (lfe * 0.5) + (rear_right * 0.5);
-    }
-
-    return mixer_buf;
-}
-
-/* 5 channels case. Quad + center channel */
-static Index<audio_sample> & quadro_5_to_stereo (Index<audio_sample> & data)
-{
-    int frames = data.len () / 5;
-    mixer_buf.resize (2 * frames);
-
-    audio_sample * get = data.begin ();
-    audio_sample * set = mixer_buf.begin ();
-
-    while (frames --)
-    {
-        audio_sample front_left  = * get ++;
-        audio_sample front_right = * get ++;
-        audio_sample center = * get ++;
-        audio_sample rear_left   = * get ++;
-        audio_sample rear_right  = * get ++;
-        * set ++ = front_left + (center * 0.5) + rear_left;
-        * set ++ = front_right + (center * 0.5) + rear_right;
-    }
-
-    return mixer_buf;
-}
-
-static Converter get_converter (int in, int out)
-{
-    if (in == 1 && out == 2)
-        return mono_to_stereo;
-    if (in == 2 && out == 1)
-        return stereo_to_mono;
-    if (in == 2 && out == 4)
-        return stereo_to_quadro;
-    if (in == 4 && out == 2)
-        return quadro_to_stereo;
-    if (in == 5 && out == 2)
-        return quadro_5_to_stereo;
-    if (in == 6 && out == 2)
-        return surround_5p1_to_stereo;
-
-    return nullptr;
-}
-
 static int input_channels, output_channels;
+static audio_sample matrix[AUD_MAX_CHANNELS * AUD_MAX_CHANNELS];
+static MixFunc mix_func;
 
+/* the coefficients are worked out once per stream, here */
 void ChannelMixer::start (int & channels, int & rate)
 {
     input_channels = channels;
@@ -214,13 +74,26 @@ void ChannelMixer::start (int & channels, int & rate)
     if (input_channels == output_channels)
         return;
 
-    if (! get_converter (input_channels, output_channels))
+    int preset = aud_get_int ("mixer", "preset");
+
+    if (preset == PRESET_CUSTOM)
     {
-        AUDERR ("Converting %d to %d channels is not implemented.\n",
-         input_channels, output_channels);
-        return;
+        String text = aud_get_str ("mixer", "matrix");
+
+        if (! matrix_from_string (text, input_channels, output_channels, matrix))
+        {
+            AUDWARN ("No custom matrix for %d to %d channels; using the standard mix.\n",
+             input_channels, output_channels);
+            matrix_from_preset (PRESET_STANDARD, input_channels, output_channels, matrix);
+        }
     }
+    else
+        matrix_from_preset (preset, input_channels, output_channels, matrix);
+
+    if (aud_get_bool ("mixer", "normalize"))
+        matrix_normalize (input_channels, output_channels, matrix);
 
+    mix_func = matrix_get_func (input_channels, output_channels);
     channels = output_channels;
 }
 
@@ -229,15 +102,20 @@ Index<audio_sample> & ChannelMixer::process (Index<audio_sample> & data)
     if (input_channels == output_channels)
         return data;
 
-    Converter converter = get_converter (input_channels, output_channels);
-    if (converter)
-        return converter (data);
+    int frames = data.len () / input_channels;
+    mixer_buf.resize (output_channels * frames);
 
-    return data;
+    mix_func (matrix, input_channels, output_channels, data.begin (),
+     mixer_buf.begin (), frames);
+
+    return mixer_buf;
 }
 
 const char * const ChannelMixer::defaults[] = {
  "channels", "2",
+ "preset", "0",
+ "matrix", "",
+ "normalize", "FALSE",
   nullptr};
 
 bool ChannelMixer::init ()
@@ -255,11 +133,27 @@ const char ChannelMixer::about[] =
  N_("Channel Mixer Plugin for Audacious\n"
     "Copyright 2011-2012 John Lindgren and Michał Lipski");
 
+static const ComboItem preset_list[] = {
+    ComboItem (N_("Standard (ITU-R BS.775)"), PRESET_STANDARD),
+    ComboItem (N_("Classic"), PRESET_CLASSIC),
+    ComboItem (N_("Custom"), PRESET_CUSTOM)
+};
+
 const PreferencesWidget ChannelMixer::widgets[] = {
     WidgetLabel (N_("<b>Channel Mixer</b>")),
     WidgetSpin (N_("Output channels:"),
         WidgetInt ("mixer", "channels"),
-        {1, AUD_MAX_CHANNELS, 1})
+        {1, AUD_MAX_CHANNELS, 1}),
+    WidgetCombo (N_("Mix:"),
+        WidgetInt ("mixer", "preset"),
+        {{preset_list}}),
+    WidgetEntry (N_("Custom matrix:"),
+        WidgetString ("mixer", "matrix")),
+    WidgetLabel (N_("One row of input channel gains per output channel, "
+     "rows separated by \";\"\nand several matrices by \"|\"; "
+     "for example 1 0 0.7; 0 1 0.7")),
+    WidgetCheck (N_("Prevent clipping"),
+        WidgetBool ("mixer", "normalize"))
 };
 
 const PluginPreferences ChannelMixer::prefs = {{widgets}};
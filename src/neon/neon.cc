@@ -162,6 +162,7 @@ private:
     int64_t m_content_length = -1;      /* Total content length, counting from
                                            content_start, if known. -1 if unknown */
     bool m_can_ranges = false;          /* true if the webserver advertised accept-range: bytes */
+    String m_last_modified;             /* Last-Modified header, if any */
     int64_t m_icy_metaint = 0;          /* Interval in which the server will
                                            send metadata announcements. 0 if no announcments */
     int64_t m_icy_metaleft = 0;         /* Bytes left until the next metadata block */
@@ -400,6 +401,12 @@ void NeonFile::handle_headers ()
             AUDDBG ("Content-Type: %s\n", value);
             m_icy_metadata.stream_contenttype = String (str_to_utf8 (value, -1));
         }
+        else if (str_has_prefix_nocase (name, "last-modified"))
+        {
+            /* Kept as is; it is only compared, not parsed */
+            AUDDBG ("Last-Modified: %s\n", value);
+            m_last_modified = String (value);
+        }
         else if (str_has_prefix_nocase (name, "icy-metaint"))
         {
             /* The server sent us a ICY metaint header. Parse and store. */
@@ -1144,6 +1151,9 @@ String NeonFile::get_metadata (const char * field)
     if (! strcmp (field, "content-type") && m_icy_metadata.stream_contenttype)
         return m_icy_metadata.stream_contenttype;
 
+    if (! strcmp (field, "last-modified") && m_last_modified)
+        return m_last_modified;
+
     if (! strcmp (field, "content-bitrate"))
         return String (int_to_str (m_icy_metadata.stream_bitrate * 1000));
 
@@ -0,0 +1,214 @@
+/*
+ * Parametric Equalizer Plugin for Audacious
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include "cascade.h"
+
+/* The SIMD kernels only handle 32-bit floats. */
+#ifndef DEF_AUDIO_FLOAT64
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define CASCADE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CASCADE_NEON
+#endif
+#endif
+
+#define LANES 4
+#define STRETCH 256 /* frames */
+
+/* One biquad over <frames> frames for the <N> channels of a group, which lie
+ * <stride> samples apart.  <z> holds z1 and z2 for each of the lanes. */
+
+#if defined(CASCADE_SSE2)
+
+template<int N> static inline __m128 load_lanes (const float * p);
+template<int N> static inline void store_lanes (float * p, __m128 v);
+
+template<> inline __m128 load_lanes<1> (const float * p)
+    { return _mm_load_ss (p); }
+template<> inline __m128 load_lanes<2> (const float * p)
+    { return _mm_castpd_ps (_mm_load_sd ((const double *) p)); }
+template<> inline __m128 load_lanes<3> (const float * p)
+    { return _mm_movelh_ps (load_lanes<2> (p), _mm_load_ss (p + 2)); }
+template<> inline __m128 load_lanes<4> (const float * p)
+    { return _mm_loadu_ps (p); }
+
+template<> inline void store_lanes<1> (float * p, __m128 v)
+    { _mm_store_ss (p, v); }
+template<> inline void store_lanes<2> (float * p, __m128 v)
+    { _mm_store_sd ((double *) p, _mm_castps_pd (v)); }
+template<> inline void store_lanes<3> (float * p, __m128 v)
+    { store_lanes<2> (p, v); _mm_store_ss (p + 2, _mm_movehl_ps (v, v)); }
+template<> inline void store_lanes<4> (float * p, __m128 v)
+    { _mm_storeu_ps (p, v); }
+
+template<int N>
+static void run_biquad (const Biquad & c, float * z, float * data, int stride, int frames)
+{
+    __m128 b0 = _mm_set1_ps (c.b0), b1 = _mm_set1_ps (c.b1), b2 = _mm_set1_ps (c.b2);
+    __m128 a1 = _mm_set1_ps (c.a1), a2 = _mm_set1_ps (c.a2);
+    __m128 z1 = _mm_loadu_ps (z), z2 = _mm_loadu_ps (z + LANES);
+
+    for (int f = 0; f < frames; f ++, data += stride)
+    {
+        __m128 x = load_lanes<N> (data);
+        __m128 y = _mm_add_ps (_mm_mul_ps (b0, x), z1);
+
+        z1 = _mm_add_ps (_mm_sub_ps (_mm_mul_ps (b1, x), _mm_mul_ps (a1, y)), z2);
+        z2 = _mm_sub_ps (_mm_mul_ps (b2, x), _mm_mul_ps (a2, y));
+
+        store_lanes<N> (data, y);
+    }
+
+    _mm_storeu_ps (z, z1);
+    _mm_storeu_ps (z + LANES, z2);
+}
+
+#elif defined(CASCADE_NEON)
+
+template<int N> static inline float32x4_t load_lanes (const float * p);
+template<int N> static inline void store_lanes (float * p, float32x4_t v);
+
+template<> inline float32x4_t load_lanes<1> (const float * p)
+    { return vsetq_lane_f32 (p[0], vdupq_n_f32 (0), 0); }
+template<> inline float32x4_t load_lanes<2> (const float * p)
+    { return vcombine_f32 (vld1_f32 (p), vdup_n_f32 (0)); }
+template<> inline float32x4_t load_lanes<3> (const float * p)
+    { return vsetq_lane_f32 (p[2], load_lanes<2> (p), 2); }
+template<> inline float32x4_t load_lanes<4> (const float * p)
+    { return vld1q_f32 (p); }
+
+template<> inline void store_lanes<1> (float * p, float32x4_t v)
+    { vst1q_lane_f32 (p, v, 0); }
+template<> inline void store_lanes<2> (float * p, float32x4_t v)
+    { vst1_f32 (p, vget_low_f32 (v)); }
+template<> inline void store_lanes<3> (float * p, float32x4_t v)
+    { store_lanes<2> (p, v); vst1q_lane_f32 (p + 2, v, 2); }
+template<> inline void store_lanes<4> (float * p, float32x4_t v)
+    { vst1q_f32 (p, v); }
+
+template<int N>
+static void run_biquad (const Biquad & c, float * z, float * data, int stride, int frames)
+{
+    float32x4_t z1 = vld1q_f32 (z), z2 = vld1q_f32 (z + LANES);
+
+    for (int f = 0; f < frames; f ++, data += stride)
+    {
+        float32x4_t x = load_lanes<N> (data);
+        float32x4_t y = vmlaq_n_f32 (z1, x, c.b0);
+
+        z1 = vmlsq_n_f32 (vmlaq_n_f32 (z2, x, c.b1), y, c.a1);
+        z2 = vmlsq_n_f32 (vmulq_n_f32 (x, c.b2), y, c.a2);
+
+        store_lanes<N> (data, y);
+    }
+
+    vst1q_f32 (z, z1);
+    vst1q_f32 (z + LANES, z2);
+}
+
+#else
+
+template<int N>
+static void run_biquad (const Biquad & c, audio_sample * z, audio_sample * data,
+ int stride, int frames)
+{
+    audio_sample z1[N], z2[N];
+
+    for (int l = 0; l < N; l ++)
+    {
+        z1[l] = z[l];
+        z2[l] = z[LANES + l];
+    }
+
+    for (int f = 0; f < frames; f ++, data += stride)
+    {
+        for (int l = 0; l < N; l ++)
+        {
+            audio_sample x = data[l];
+            audio_sample y = c.b0 * x + z1[l];
+
+            z1[l] = c.b1 * x - c.a1 * y + z2[l];
+            z2[l] = c.b2 * x - c.a2 * y;
+
+            data[l] = y;
+        }
+    }
+
+    for (int l = 0; l < N; l ++)
+    {
+        z[l] = z1[l];
+        z[LANES + l] = z2[l];
+    }
+}
+
+#endif
+
+typedef void (* BiquadFunc) (const Biquad & c, audio_sample * z,
+ audio_sample * data, int stride, int frames);
+
+/* indexed by the number of channels in a group, less one */
+static const BiquadFunc biquad_funcs[LANES] = {
+    run_biquad<1>,
+    run_biquad<2>,
+    run_biquad<3>,
+    run_biquad<4>
+};
+
+void Cascade::setup (int channels)
+{
+    m_channels = channels;
+    m_groups = (channels + LANES - 1) / LANES;
+    m_state.resize (EQ_MAX_BANDS * m_groups * 2 * LANES);
+    reset ();
+}
+
+void Cascade::reset ()
+{
+    reset_from (0);
+}
+
+void Cascade::reset_from (int from)
+{
+    m_state.erase (from * m_groups * 2 * LANES, -1);
+}
+
+void Cascade::process (const Biquad * biquads, int count, audio_sample * data, int frames)
+{
+    while (frames)
+    {
+        int stretch = aud::min (frames, STRETCH);
+
+        for (int g = 0; g < m_groups; g ++)
+        {
+            int lanes = aud::min (m_channels - g * LANES, LANES);
+            BiquadFunc func = biquad_funcs[lanes - 1];
+
+            for (int b = 0; b < count; b ++)
+            {
+                audio_sample * z = & m_state[(b * m_groups + g) * 2 * LANES];
+                func (biquads[b], z, data + g * LANES, m_channels, stretch);
+            }
+        }
+
+        data += stretch * m_channels;
+        frames -= stretch;
+    }
+}
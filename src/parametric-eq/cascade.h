@@ -0,0 +1,47 @@
+/*
+ * Parametric Equalizer Plugin for Audacious
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef PARAMETRIC_EQ_CASCADE_H
+#define PARAMETRIC_EQ_CASCADE_H
+
+#include <libaudcore/index.h>
+
+#include "filters.h"
+
+/* A cascade of biquads in transposed direct form II, run in place over
+ * interleaved audio.  Channels are taken four at a time, as the lanes of a
+ * SIMD register, and each biquad makes its own pass over a short stretch of
+ * frames, so its state stays in registers. */
+class Cascade
+{
+public:
+    void setup (int channels);
+    void reset ();
+
+    /* clears the state of biquads <from> and up, for when they are new */
+    void reset_from (int from);
+
+    void process (const Biquad * biquads, int count, audio_sample * data, int frames);
+
+private:
+    int m_channels = 0, m_groups = 0;
+    Index<audio_sample> m_state; /* [biquad][group][z1, z2][lane] */
+};
+
+#endif
@@ -0,0 +1,282 @@
+/*
+ * Parametric Equalizer Plugin for Audacious
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <libaudcore/audstrings.h>
+#include <libaudcore/runtime.h>
+
+#include "filters.h"
+
+static const struct {
+    const char * name;
+    FilterType type;
+} type_names[] = {
+    {"PK", FilterType::Peak},
+    {"PEQ", FilterType::Peak},
+    {"Modal", FilterType::Peak},
+    {"LS", FilterType::LowShelf},
+    {"LSC", FilterType::LowShelf},
+    {"LSQ", FilterType::LowShelf},
+    {"HS", FilterType::HighShelf},
+    {"HSC", FilterType::HighShelf},
+    {"HSQ", FilterType::HighShelf},
+    {"LP", FilterType::LowPass},
+    {"LPQ", FilterType::LowPass},
+    {"HP", FilterType::HighPass},
+    {"HPQ", FilterType::HighPass},
+    {"BP", FilterType::BandPass},
+    {"NO", FilterType::Notch}
+};
+
+static bool is_word (const char * token, const char * word)
+{
+    return ! strcmp_nocase (token, word);
+}
+
+static bool ends_with_colon (const char * token)
+{
+    int len = strlen (token);
+    return len && token[len - 1] == ':';
+}
+
+/* Returns true if <line> was a filter that is on; the preamp, if any, is added
+ * to <preamp>.  Lines that are neither (comments, headers, other commands of
+ * Equalizer APO) are passed over. */
+static bool parse_line (const char * line, EQBand & band, float & preamp)
+{
+    auto tokens = str_list_to_index (line, " \t");
+    int n = tokens.len (), i = 0;
+
+    if (! n || tokens[0][0] == '#')
+        return false;
+
+    if (is_word (tokens[0], "Preamp:"))
+    {
+        if (n > 1)
+            preamp += str_to_double (tokens[1]);
+        return false;
+    }
+
+    if (str_has_prefix_nocase (tokens[0], "Filter"))
+    {
+        /* "Filter:", or "Filter 1:"; other lines starting so are headers */
+        if (ends_with_colon (tokens[0]))
+            i = 1;
+        else if (n > 1 && ends_with_colon (tokens[1]))
+            i = 2;
+        else
+            return false;
+    }
+
+    if (i < n && is_word (tokens[i], "OFF"))
+        return false;
+    if (i < n && is_word (tokens[i], "ON"))
+        i ++;
+
+    if (i == n)
+        return false;
+
+    /* with neither "Filter n:" nor "ON", an unknown word is not worth a
+     * warning: the line is probably not a filter at all */
+    bool filter_line = (i > 0);
+
+    const char * type = tokens[i ++];
+    bool found = false;
+
+    for (auto & t : type_names)
+    {
+        if (is_word (type, t.name))
+        {
+            band.type = t.type;
+            found = true;
+            break;
+        }
+    }
+
+    if (! found)
+    {
+        /* REW lists filters not in use as "None" */
+        if (filter_line && ! is_word (type, "None"))
+            AUDWARN ("Unknown filter type %s.\n", type);
+        return false;
+    }
+
+    band.freq = 0;
+    band.gain = 0;
+
+    /* when no Q is given: Butterworth for shelves and passes, narrow for
+     * notches */
+    switch (band.type)
+    {
+    case FilterType::LowShelf:
+    case FilterType::HighShelf:
+    case FilterType::LowPass:
+    case FilterType::HighPass:
+        band.q = M_SQRT1_2;
+        break;
+    case FilterType::Notch:
+        band.q = 30;
+        break;
+    default:
+        band.q = 1;
+        break;
+    }
+
+    /* key-value pairs, with the units ("Hz", "dB") passed over */
+    for (; i + 1 < n; i ++)
+    {
+        if (is_word (tokens[i], "Fc"))
+            band.freq = str_to_double (tokens[++ i]);
+        else if (is_word (tokens[i], "Gain"))
+            band.gain = str_to_double (tokens[++ i]);
+        else if (is_word (tokens[i], "Q"))
+            band.q = str_to_double (tokens[++ i]);
+        else if (is_word (tokens[i], "BW") && i + 2 < n && is_word (tokens[i + 1], "Oct"))
+        {
+            double octaves = str_to_double (tokens[i + 2]);
+            double power = exp2 (octaves);
+
+            if (octaves > 0)
+                band.q = sqrt (power) / (power - 1);
+
+            i += 2;
+        }
+    }
+
+    if (band.freq <= 0 || band.q <= 0)
+    {
+        AUDWARN ("Invalid filter: %s\n", line);
+        return false;
+    }
+
+    return true;
+}
+
+int eq_parse (const char * text, EQBand * bands, int max, float & preamp)
+{
+    int count = 0;
+
+    for (const String & line : str_list_to_index (text, "\r\n;"))
+    {
+        EQBand band;
+        if (! parse_line (line, band, preamp))
+            continue;
+
+        if (count == max)
+        {
+            AUDWARN ("Only %d filters can be used.\n", EQ_MAX_BANDS);
+            break;
+        }
+
+        bands[count ++] = band;
+    }
+
+    return count;
+}
+
+Biquad eq_design (const EQBand & band, int rate)
+{
+    /* keep clear of the Nyquist frequency, where the formulas break down */
+    double freq = aud::clamp ((double) band.freq, 1.0, 0.49 * rate);
+
+    double A = pow (10, band.gain / 40);
+    double w0 = 2 * M_PI * freq / rate;
+    double cs = cos (w0);
+    double alpha = sin (w0) / (2 * band.q);
+    double sq = 2 * sqrt (A) * alpha;
+
+    double b0, b1, b2, a0, a1, a2;
+
+    switch (band.type)
+    {
+    case FilterType::Peak:
+        b0 = 1 + alpha * A;
+        b1 = -2 * cs;
+        b2 = 1 - alpha * A;
+        a0 = 1 + alpha / A;
+        a1 = -2 * cs;
+        a2 = 1 - alpha / A;
+        break;
+
+    case FilterType::LowShelf:
+        b0 = A * ((A + 1) - (A - 1) * cs + sq);
+        b1 = 2 * A * ((A - 1) - (A + 1) * cs);
+        b2 = A * ((A + 1) - (A - 1) * cs - sq);
+        a0 = (A + 1) + (A - 1) * cs + sq;
+        a1 = -2 * ((A - 1) + (A + 1) * cs);
+        a2 = (A + 1) + (A - 1) * cs - sq;
+        break;
+
+    case FilterType::HighShelf:
+        b0 = A * ((A + 1) + (A - 1) * cs + sq);
+        b1 = -2 * A * ((A - 1) + (A + 1) * cs);
+        b2 = A * ((A + 1) + (A - 1) * cs - sq);
+        a0 = (A + 1) - (A - 1) * cs + sq;
+        a1 = 2 * ((A - 1) - (A + 1) * cs);
+        a2 = (A + 1) - (A - 1) * cs - sq;
+        break;
+
+    case FilterType::LowPass:
+        b0 = (1 - cs) / 2;
+        b1 = 1 - cs;
+        b2 = (1 - cs) / 2;
+        a0 = 1 + alpha;
+        a1 = -2 * cs;
+        a2 = 1 - alpha;
+        break;
+
+    case FilterType::HighPass:
+        b0 = (1 + cs) / 2;
+        b1 = -(1 + cs);
+        b2 = (1 + cs) / 2;
+        a0 = 1 + alpha;
+        a1 = -2 * cs;
+        a2 = 1 - alpha;
+        break;
+
+    case FilterType::BandPass: /* 0 dB at the centre */
+        b0 = alpha;
+        b1 = 0;
+        b2 = -alpha;
+        a0 = 1 + alpha;
+        a1 = -2 * cs;
+        a2 = 1 - alpha;
+        break;
+
+    case FilterType::Notch:
+    default:
+        b0 = 1;
+        b1 = -2 * cs;
+        b2 = 1;
+        a0 = 1 + alpha;
+        a1 = -2 * cs;
+        a2 = 1 - alpha;
+        break;
+    }
+
+    return {
+        (audio_sample) (b0 / a0),
+        (audio_sample) (b1 / a0),
+        (audio_sample) (b2 / a0),
+        (audio_sample) (a1 / a0),
+        (audio_sample) (a2 / a0)
+    };
+}
@@ -0,0 +1,63 @@
+/*
+ * Parametric Equalizer Plugin for Audacious
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef PARAMETRIC_EQ_FILTERS_H
+#define PARAMETRIC_EQ_FILTERS_H
+
+#include <libaudcore/plugin.h>
+
+#define EQ_MAX_BANDS 32
+
+enum class FilterType {
+    Peak,
+    LowShelf,
+    HighShelf,
+    LowPass,
+    HighPass,
+    BandPass,
+    Notch
+};
+
+struct EQBand {
+    FilterType type;
+    float freq;  /* Hz */
+    float gain;  /* dB; peaks and shelves only */
+    float q;
+};
+
+/* normalized so that a0 is 1 */
+struct Biquad {
+    audio_sample b0, b1, b2, a1, a2;
+};
+
+/* Parses filters in the text format of AutoEQ, REW and Equalizer APO, e.g.
+ *
+ *     Preamp: -6.2 dB
+ *     Filter 1: ON LSC Fc 105 Hz Gain 5.2 dB Q 0.70
+ *     Filter 2: ON PK Fc 150 Hz Gain -2.0 dB Q 0.63
+ *
+ * one per line or separated by semicolons.  The "Filter n:" and "ON" are
+ * optional, so "PK Fc 1000 Gain -3 Q 1.4" will do.  Adds at most <max> bands
+ * to <bands> and any preamp to <preamp>; returns the number of bands added. */
+int eq_parse (const char * text, EQBand * bands, int max, float & preamp);
+
+/* the filter as designed in the Audio EQ Cookbook by Robert Bristow-Johnson */
+Biquad eq_design (const EQBand & band, int rate);
+
+#endif
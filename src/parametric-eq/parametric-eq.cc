@@ -0,0 +1,228 @@
+/*
+ * Parametric Equalizer Plugin for Audacious
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <atomic>
+#include <math.h>
+
+#include <libaudcore/hook.h>
+#include <libaudcore/i18n.h>
+#include <libaudcore/plugin.h>
+#include <libaudcore/preferences.h>
+#include <libaudcore/runtime.h>
+#include <libaudcore/vfs.h>
+
+#include "../effect-common/params.h"
+#include "cascade.h"
+#include "filters.h"
+
+static const char * const eq_defaults[] = {
+    "file", "",
+    "filters", "",
+    "preamp", "0",
+    nullptr
+};
+
+static void settings_changed ()
+{
+    effect_settings_changed ("parametric_eq");
+}
+
+static const PreferencesWidget eq_widgets[] = {
+    WidgetLabel (N_("<b>Filters</b>")),
+    WidgetFileEntry (N_("File:"),
+        WidgetString ("parametric_eq", "file", settings_changed),
+        {FileSelectMode::File}),
+    WidgetEntry (N_("Filters:"),
+        WidgetString ("parametric_eq", "filters", settings_changed)),
+    WidgetLabel (N_("<small>Filters are added to those from the file; "
+     "separate them with semicolons, e.g.\n"
+     "PK Fc 1000 Gain -3 Q 1.4; HS Fc 8000 Gain 2</small>")),
+    WidgetSpin (N_("Preamp:"),
+        WidgetFloat ("parametric_eq", "preamp", settings_changed),
+        {-30, 30, 0.5, N_("dB")})
+};
+
+static const PluginPreferences eq_prefs = {{eq_widgets}};
+
+static const char eq_about[] =
+ N_("Parametric Equalizer Plugin for Audacious\n\n"
+    "Applies up to 32 peak, shelf, pass and notch filters.  The filters can "
+    "be read from the parametric EQ files of AutoEQ, REW or Equalizer APO "
+    "(\"Filter 1: ON PK Fc 105 Hz Gain 5.2 dB Q 0.70\").");
+
+class ParametricEQ : public EffectPlugin
+{
+public:
+    static constexpr PluginInfo info = {
+        N_("Parametric Equalizer"),
+        PACKAGE,
+        eq_about,
+        & eq_prefs
+    };
+
+    constexpr ParametricEQ () : EffectPlugin (info, 0, true) {}
+
+    bool init ();
+    void cleanup ();
+
+    void start (int & channels, int & rate);
+    Index<audio_sample> & process (Index<audio_sample> & data);
+    bool flush (bool force);
+};
+
+EXPORT ParametricEQ aud_plugin_instance;
+
+/* The filters are read and designed on the main thread, for the rate last
+ * started with, and passed to the audio thread through EffectParams. */
+struct EQSetup {
+    int rate; /* the biquads were designed for this rate */
+    int count;
+    float preamp; /* dB */
+    EQBand bands[EQ_MAX_BANDS];
+    Biquad biquads[EQ_MAX_BANDS]; /* with the preamp in the first */
+};
+
+static std::atomic<int> eq_rate;
+
+static void design (EQSetup & setup, int rate)
+{
+    setup.rate = rate;
+    if (! rate)
+        return;
+
+    for (int b = 0; b < setup.count; b ++)
+        setup.biquads[b] = eq_design (setup.bands[b], rate);
+
+    if (setup.count)
+    {
+        audio_sample gain = powf (10, setup.preamp / 20);
+        Biquad & first = setup.biquads[0];
+
+        first.b0 *= gain;
+        first.b1 *= gain;
+        first.b2 *= gain;
+    }
+}
+
+static void read_setup (EQSetup & setup)
+{
+    setup.count = 0;
+    setup.preamp = aud_get_double ("parametric_eq", "preamp");
+
+    String uri = aud_get_str ("parametric_eq", "file");
+
+    if (uri[0])
+    {
+        VFSFile file (uri, "r");
+        Index<char> text;
+
+        if (file)
+            text = file.read_all ();
+        else
+            AUDERR ("Cannot open %s: %s.\n", (const char *) uri, file.error ());
+
+        text.append (0);
+        setup.count = eq_parse (text.begin (), setup.bands, EQ_MAX_BANDS, setup.preamp);
+    }
+
+    String filters = aud_get_str ("parametric_eq", "filters");
+    setup.count += eq_parse (filters, setup.bands + setup.count,
+     EQ_MAX_BANDS - setup.count, setup.preamp);
+
+    design (setup, eq_rate.load (std::memory_order_relaxed));
+}
+
+static EffectParams<EQSetup> eq_params (read_setup);
+
+static int eq_channels;
+static Cascade cascade;
+static int cascade_count; /* biquads with state */
+
+/* Until the main thread has designed the filters for a new rate, the audio
+ * thread uses its own copy, designed when starting. */
+static EQSetup start_setup;
+static bool use_start_setup;
+
+bool ParametricEQ::init ()
+{
+    aud_config_set_defaults ("parametric_eq", eq_defaults);
+    eq_params.update ();
+    eq_params.watch ("parametric_eq");
+    return true;
+}
+
+void ParametricEQ::cleanup ()
+{
+    eq_params.unwatch ("parametric_eq");
+}
+
+void ParametricEQ::start (int & channels, int & rate)
+{
+    eq_channels = channels;
+    eq_rate.store (rate, std::memory_order_relaxed);
+
+    cascade.setup (channels);
+    cascade_count = 0;
+
+    const EQSetup & setup = eq_params.get ();
+    use_start_setup = (setup.rate != rate);
+
+    if (use_start_setup)
+    {
+        start_setup = setup;
+        design (start_setup, rate);
+        event_queue ("parametric_eq changed", nullptr);
+    }
+}
+
+Index<audio_sample> & ParametricEQ::process (Index<audio_sample> & data)
+{
+    const EQSetup * setup = & eq_params.get ();
+
+    if (setup->rate == eq_rate.load (std::memory_order_relaxed))
+        use_start_setup = false;
+    else if (use_start_setup)
+        setup = & start_setup;
+    else
+        return data; /* cannot happen */
+
+    /* biquads that were not running start from silence */
+    if (setup->count > cascade_count)
+        cascade.reset_from (cascade_count);
+
+    cascade_count = setup->count;
+
+    if (setup->count)
+        cascade.process (setup->biquads, setup->count, data.begin (),
+         data.len () / eq_channels);
+    else if (setup->preamp)
+    {
+        audio_sample gain = powf (10, setup->preamp / 20);
+        for (audio_sample & x : data)
+            x *= gain;
+    }
+
+    return data;
+}
+
+bool ParametricEQ::flush (bool force)
+{
+    cascade.reset ();
+    return true;
+}
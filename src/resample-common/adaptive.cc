@@ -0,0 +1,365 @@
+/*
+ * Adaptive quality switching for the resampler plugins
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <math.h>
+#include <chrono>
+
+#include <libaudcore/runtime.h>
+
+#include "adaptive.h"
+
+#define HISTORY_TIME 0.1  /* seconds of input used to prime a new converter */
+#define FADE_TIME 0.02    /* seconds */
+#define LOAD_TIME 2.0     /* seconds over which the load is averaged */
+#define HOLD_TIME 3.0     /* minimum seconds between switches */
+#define MAX_HOLD_TIME 60.0
+#define STEP_COST 3       /* assumed cost of the next tier relative to this one */
+
+/* grows <buf> up front, so that it does not have to grow while playing */
+static void reserve (Index<audio_sample> & buf, int len)
+{
+    int old_len = buf.len ();
+
+    if (old_len < len)
+    {
+        buf.resize (len);
+        buf.resize (old_len);
+    }
+}
+
+bool AdaptiveResampler::start (int channels, int rate, double ratio, int max_tier,
+ float max_load, const char * const * names, CreateFunc create, void * data)
+{
+    max_tier = aud::min (max_tier, max_tiers - 1);
+
+    /* keep the tier from the previous song if it is still allowed, so that the
+     * right tier does not have to be found again every time */
+    int tier = (m_cur.conv && m_max_tier == max_tier) ? m_tier : max_tier;
+
+    clear ();
+
+    m_channels = channels;
+    m_rate = rate;
+    m_ratio = ratio;
+    m_max_tier = max_tier;
+    m_max_load = max_load;
+    m_names = names;
+    m_create = create;
+    m_data = data;
+
+    m_up_hold = HOLD_TIME;
+
+    prepare ();
+
+    for (; tier >= 0; tier --)
+    {
+        m_cur.conv = std::move (m_spare[tier]);
+        if (m_cur.conv)
+            break;
+    }
+
+    m_tier = aud::max (tier, 0);
+
+    /* replace the converter just taken */
+    prepare ();
+
+    /* room for blocks of up to a second, plus the history */
+    int in_frames = rate * (1 + HISTORY_TIME);
+    int out_frames = rate * ratio * (1 + HISTORY_TIME) + 256;
+
+    reserve (m_history, in_frames * channels);
+    reserve (m_old_out, out_frames * channels);
+    reserve (m_new_out, out_frames * channels);
+
+    return (bool) m_cur.conv;
+}
+
+/* deletes the converters set aside and makes one ready for each tier that has
+ * none */
+void AdaptiveResampler::prepare ()
+{
+    for (int i = 0; i < m_n_retired; i ++)
+        m_retired[i].clear ();
+
+    m_n_retired = 0;
+
+    for (int tier = 0; tier <= m_max_tier; tier ++)
+    {
+        if (! m_spare[tier])
+            m_spare[tier].capture (m_create (tier, m_data));
+    }
+}
+
+/* sets the converter of <stream> aside, to be deleted in the next flush() */
+void AdaptiveResampler::retire (Stream & stream)
+{
+    if (stream.conv && m_n_retired < aud::n_elements (m_retired))
+        m_retired[m_n_retired ++] = std::move (stream.conv);
+
+    stream = Stream ();
+}
+
+void AdaptiveResampler::flush ()
+{
+    if (m_next.conv)
+    {
+        m_cur.conv = std::move (m_next.conv);
+        m_tier = m_next_tier;
+    }
+
+    /* the converter itself is reset by replacing it with a fresh one */
+    prepare ();
+
+    if (m_cur.conv)
+        m_cur.conv = std::move (m_spare[m_tier]);
+
+    prepare ();
+
+    m_cur.origin = m_cur.produced = 0;
+    m_next = Stream ();
+    m_next_tier = -1;
+
+    m_old_out.resize (0);
+    m_new_out.resize (0);
+    m_new_head = 0;
+    m_history.resize (0);
+    m_in_pos = 0;
+}
+
+void AdaptiveResampler::clear ()
+{
+    m_cur = Stream ();
+    m_next = Stream ();
+    m_next_tier = -1;
+
+    for (SmartPtr<TierConverter> & conv : m_spare)
+        conv.clear ();
+    for (int i = 0; i < m_n_retired; i ++)
+        m_retired[i].clear ();
+
+    m_n_retired = 0;
+
+    m_old_out.clear ();
+    m_new_out.clear ();
+    m_new_head = 0;
+    m_history.clear ();
+    m_in_pos = 0;
+
+    m_load = -1;
+    m_hold = 0;
+    m_last_was_up = false;
+}
+
+void AdaptiveResampler::remember_input (const audio_sample * in, int frames)
+{
+    int keep = (int) (m_rate * HISTORY_TIME) * m_channels;
+
+    m_history.insert (in, -1, frames * m_channels);
+
+    if (m_history.len () > keep)
+        m_history.remove (0, m_history.len () - keep);
+
+    m_in_pos += frames;
+}
+
+bool AdaptiveResampler::begin_switch (int tier)
+{
+    /* if the converter for the tier has already been used, the switch has to
+     * wait for the next flush */
+    SmartPtr<TierConverter> conv = std::move (m_spare[tier]);
+    if (! conv)
+        return false;
+
+    AUDINFO ("Switching to %s quality (load %.1f%%).\n", m_names[tier], m_load * 100);
+
+    /* start the new converter a little in the past, so that its filter is
+     * filled by the time its output is needed */
+    int history = m_history.len () / m_channels;
+
+    m_next.conv = std::move (conv);
+    m_next.origin = llround ((m_in_pos - history) * m_ratio);
+    m_next.produced = 0;
+    m_next_tier = tier;
+
+    m_new_out.resize (0);
+    m_new_head = 0;
+
+    if (! m_next.conv->convert (m_history.begin (), history, m_new_out, false))
+    {
+        retire (m_next);
+        m_next_tier = -1;
+        return false;
+    }
+
+    m_next.produced = m_new_out.len () / m_channels;
+
+    m_fade_pos = 0;
+    m_fade_len = aud::max (1, (int) (m_rate * m_ratio * FADE_TIME));
+
+    m_last_was_up = (tier > m_tier);
+    m_hold = 0;
+    return true;
+}
+
+/* Runs both converters and crossfades from the old to the new, pairing up the
+ * frames that fall at the same point of the output timeline.  Frames of the old
+ * converter without a partner are passed through unchanged; the new converter's
+ * frames for that point are then dropped. */
+bool AdaptiveResampler::process_fade (const audio_sample * in, int frames,
+ Index<audio_sample> & out, bool last)
+{
+    m_old_out.resize (0);
+
+    if (! m_cur.conv->convert (in, frames, m_old_out, last))
+        return false;
+
+    int before = m_new_out.len ();
+    if (! m_next.conv->convert (in, frames, m_new_out, last))
+    {
+        /* give up on the new converter */
+        retire (m_next);
+        m_next_tier = -1;
+        out.insert (m_old_out.begin (), -1, m_old_out.len ());
+        m_cur.produced += m_old_out.len () / m_channels;
+        return true;
+    }
+
+    m_next.produced += (m_new_out.len () - before) / m_channels;
+
+    int old_frames = m_old_out.len () / m_channels;
+    int new_frames = m_new_out.len () / m_channels;
+    int64_t new_first = m_next.origin + m_next.produced - new_frames;
+
+    int64_t pos = m_cur.origin + m_cur.produced;
+    bool done = false;
+    int f = 0;
+
+    for (; f < old_frames && ! done; f ++, pos ++)
+    {
+        const audio_sample * a = & m_old_out[f * m_channels];
+
+        /* skip new frames that are behind */
+        int64_t skip = pos - (new_first + m_new_head);
+        if (skip > 0)
+            m_new_head = aud::min ((int64_t) new_frames, m_new_head + skip);
+
+        if (m_new_head < new_frames && new_first + m_new_head == pos)
+        {
+            const audio_sample * b = & m_new_out[m_new_head * m_channels];
+            float gain = (m_fade_pos + 0.5f) / m_fade_len;
+
+            for (int c = 0; c < m_channels; c ++)
+                out.append (a[c] + (b[c] - a[c]) * gain);
+
+            m_new_head ++;
+            done = (++ m_fade_pos == m_fade_len);
+        }
+        else
+            out.insert (a, -1, m_channels);
+    }
+
+    m_cur.produced += f;
+
+    if (done || last)
+    {
+        /* the new converter takes over from the next point of the timeline */
+        int64_t skip = pos - (new_first + m_new_head);
+        if (skip > 0)
+            m_new_head = aud::min ((int64_t) new_frames, m_new_head + skip);
+
+        out.insert (& m_new_out[m_new_head * m_channels], -1, (new_frames - m_new_head) * m_channels);
+
+        retire (m_cur);
+        m_cur = std::move (m_next);
+        m_tier = m_next_tier;
+        m_next = Stream ();
+        m_next_tier = -1;
+
+        m_new_out.resize (0);
+        m_new_head = 0;
+        m_load = -1;
+    }
+    else
+    {
+        m_new_out.remove (0, m_new_head * m_channels);
+        m_new_head = 0;
+    }
+
+    return true;
+}
+
+void AdaptiveResampler::measure (double seconds, int frames)
+{
+    double duration = (double) frames / m_rate;
+    if (duration <= 0)
+        return;
+
+    float load = seconds / duration;
+
+    if (m_load < 0)
+        m_load = load;
+    else
+        m_load += (load - m_load) * aud::min (1.0, duration / LOAD_TIME);
+
+    m_hold += duration;
+}
+
+bool AdaptiveResampler::process (const audio_sample * in, int frames,
+ Index<audio_sample> & out, bool last)
+{
+    if (! m_cur.conv)
+        return false;
+
+    auto begin = std::chrono::steady_clock::now ();
+    bool success;
+
+    if (m_next.conv)
+        success = process_fade (in, frames, out, last);
+    else
+    {
+        int before = out.len ();
+        success = m_cur.conv->convert (in, frames, out, last);
+        m_cur.produced += (out.len () - before) / m_channels;
+    }
+
+    remember_input (in, frames);
+
+    auto end = std::chrono::steady_clock::now ();
+    bool fading = (bool) m_next.conv;
+
+    /* running two converters at once says little about either one */
+    if (! fading)
+        measure (std::chrono::duration<double> (end - begin).count (), frames);
+
+    if (! success || last || fading || m_load < 0)
+        return success;
+
+    if (m_load > m_max_load && m_tier > 0 && m_hold >= HOLD_TIME)
+    {
+        /* if the last step up was a mistake, wait longer before the next one */
+        if (m_last_was_up)
+            m_up_hold = aud::min (m_up_hold * 2, MAX_HOLD_TIME);
+
+        begin_switch (m_tier - 1);
+    }
+    else if (m_load * STEP_COST < m_max_load && m_tier < m_max_tier && m_hold >= m_up_hold)
+        begin_switch (m_tier + 1);
+
+    return success;
+}
@@ -0,0 +1,119 @@
+/*
+ * Adaptive quality switching for the resampler plugins
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef AUDACIOUS_RESAMPLE_ADAPTIVE_H
+#define AUDACIOUS_RESAMPLE_ADAPTIVE_H
+
+#include <stdint.h>
+
+#include <libaudcore/index.h>
+#include <libaudcore/objects.h>
+#include <libaudcore/plugin.h>
+
+/* One converter at a fixed quality.  Output frame k of a newly created
+ * converter must correspond to input time k / ratio, i.e. the converter must
+ * compensate for its own filter delay (both libsamplerate and soxr do). */
+class TierConverter
+{
+public:
+    virtual ~TierConverter () {}
+
+    /* Appends the converted audio to <out>.  Returns false on error. */
+    virtual bool convert (const audio_sample * in, int frames,
+     Index<audio_sample> & out, bool last) = 0;
+};
+
+/* Runs a converter of one of several quality tiers (0 being the cheapest) and
+ * keeps track of how much of the real-time budget it uses.  When the load goes
+ * over the limit, it drops to the next lower tier; when there is plenty of
+ * headroom, it tries the next higher one.  A new converter is primed with the
+ * most recent input, and its output is lined up with that of the old one and
+ * crossfaded in, so that switching is inaudible.
+ *
+ * Converters are only created and deleted in start() and flush().  A fresh one
+ * for each tier is kept ready there, so that a switch in process() only takes
+ * one over; the ones switched away from are set aside until then.  Each tier
+ * can thus be switched to once between flushes. */
+class AdaptiveResampler
+{
+public:
+    static constexpr int max_tiers = 8;
+
+    /* called from start() and flush() only */
+    typedef TierConverter * (* CreateFunc) (int tier, void * data);
+
+    /* Returns false if no converter could be created. */
+    bool start (int channels, int rate, double ratio, int max_tier,
+     float max_load, const char * const * names, CreateFunc create, void * data);
+
+    /* Appends the converted audio to <out>.  Returns false on error. */
+    bool process (const audio_sample * in, int frames, Index<audio_sample> & out, bool last);
+
+    void flush ();
+    void clear ();
+
+    int tier () const
+        { return m_tier; }
+
+    /* processing time as a fraction of the playing time, averaged */
+    float load () const
+        { return m_load; }
+
+private:
+    struct Stream {
+        SmartPtr<TierConverter> conv;
+        int64_t origin = 0;   /* output timeline position of the first frame */
+        int64_t produced = 0; /* frames produced so far */
+    };
+
+    void prepare ();
+    void retire (Stream & stream);
+
+    bool begin_switch (int tier);
+    bool process_fade (const audio_sample * in, int frames, Index<audio_sample> & out, bool last);
+    void remember_input (const audio_sample * in, int frames);
+    void measure (double seconds, int frames);
+
+    int m_channels = 0, m_rate = 0;
+    double m_ratio = 1;
+    int m_max_tier = 0, m_tier = 0;
+    float m_max_load = 1;
+    const char * const * m_names = nullptr;
+    CreateFunc m_create = nullptr;
+    void * m_data = nullptr;
+
+    SmartPtr<TierConverter> m_spare[max_tiers];
+    SmartPtr<TierConverter> m_retired[max_tiers + 1];
+    int m_n_retired = 0;
+
+    Stream m_cur, m_next;
+    int m_next_tier = -1;
+    int m_fade_pos = 0, m_fade_len = 0;
+    Index<audio_sample> m_old_out, m_new_out;
+    int m_new_head = 0; /* frames of m_new_out already used */
+
+    Index<audio_sample> m_history; /* the most recent input */
+    int64_t m_in_pos = 0;          /* input frames since the last flush */
+
+    float m_load = -1;
+    double m_hold = 0, m_up_hold = 0;
+    bool m_last_was_up = false;
+};
+
+#endif
@@ -25,12 +25,41 @@
 #include <libaudcore/preferences.h>
 #include <libaudcore/audstrings.h>
 
+#include "../resample-common/adaptive.h"
+
 #define MIN_RATE 8000
 #define MAX_RATE 192000
 #define RATE_STEP 50
 
 #define RESAMPLE_ERROR(e) AUDERR ("%s\n", src_strerror (e))
 
+/* One libsamplerate converter */
+class SRCConverter : public TierConverter
+{
+public:
+    static SRCConverter * create (int method, int channels, double ratio);
+    ~SRCConverter ()
+        { src_delete (m_state); }
+
+    bool convert (const audio_sample * in, int frames,
+     Index<audio_sample> & out, bool last);
+    void reset ();
+
+private:
+    SRCConverter (SRC_STATE * state, int channels, double ratio) :
+        m_state (state), m_channels (channels), m_ratio (ratio) {}
+
+    SRC_STATE * m_state;
+    int m_channels;
+    double m_ratio;
+
+#ifdef DEF_AUDIO_FLOAT64
+    /* libsamplerate works in float only; in the float build, it reads from the
+     * caller's buffer and writes straight into the output */
+    Index<float> m_floatbuf_in, m_floatbuf_out;
+#endif
+};
+
 class Resampler : public EffectPlugin
 {
 public:
@@ -62,6 +91,16 @@ public:
 
 private:
     Index<audio_sample> & resample (Index<audio_sample> & data, bool finish);
+    static TierConverter * create_tier (int tier, void * data);
+
+    /* raw pointers, so that the constructor can stay constexpr */
+    SRCConverter * m_conv = nullptr;
+    AdaptiveResampler * m_adaptive = nullptr;
+    bool m_active = false;
+
+    int m_channels = 0;
+    double m_ratio = 0;
+    Index<audio_sample> m_outbuffer;
 };
 
 EXPORT Resampler aud_plugin_instance;
@@ -69,6 +108,8 @@ EXPORT Resampler aud_plugin_instance;
 const char * const Resampler::defaults[] = {
  "method", aud::numeric_string<SRC_SINC_FASTEST>::str,
  "default-rate", "44100",
+ "adaptive", "FALSE",
+ "max-load", "25",
  "use-mappings", "FALSE",
  "8000", "48000",
  "16000", "48000",
@@ -82,40 +123,145 @@ const char * const Resampler::defaults[] = {
  "192000", "48000",
  nullptr};
 
-static SRC_STATE * state;
-static int stored_channels;
-static double ratio;
-static Index<audio_sample> outbuffer;
+/* The methods in order of cost, for adaptive mode.  The configured method is
+ * the highest that will be used. */
+static const int tier_methods[] = {SRC_ZERO_ORDER_HOLD, SRC_LINEAR,
+ SRC_SINC_FASTEST, SRC_SINC_MEDIUM_QUALITY, SRC_SINC_BEST_QUALITY};
+
+static const char * const tier_names[] = {"skip/repeat", "linear",
+ "fast sinc", "medium sinc", "best sinc"};
+
+/* The rates that can be mapped, and their current mappings.  The mappings are
+ * reloaded whenever one of them is changed. */
+static const int mapped_rates[] =
+ {8000, 16000, 22050, 32000, 44100, 48000, 88200, 96000, 176400, 192000};
+
+static int mappings[aud::n_elements (mapped_rates)];
+
+static void load_mappings ()
+{
+    for (int i = 0; i < aud::n_elements (mapped_rates); i ++)
+        mappings[i] = aud_get_int ("resample", int_to_str (mapped_rates[i]));
+}
+
+static int lookup_mapping (int rate)
+{
+    for (int i = 0; i < aud::n_elements (mapped_rates); i ++)
+    {
+        if (mapped_rates[i] == rate)
+            return mappings[i];
+    }
+
+    return 0;
+}
+
+SRCConverter * SRCConverter::create (int method, int channels, double ratio)
+{
+    int error;
+    SRC_STATE * state = src_new (method, channels, & error);
+
+    if (! state)
+    {
+        RESAMPLE_ERROR (error);
+        return nullptr;
+    }
+
+    return new SRCConverter (state, channels, ratio);
+}
+
+bool SRCConverter::convert (const audio_sample * in, int frames,
+ Index<audio_sample> & out, bool last)
+{
+    /* The buffers are only ever grown, so after the first few calls there is
+     * no more allocation here. */
+    int samples = frames * m_channels;
+    int max_out = (int) (samples * m_ratio) + 256;
+    int old_len = out.len ();
+
+    SRC_DATA srcd = SRC_DATA ();
+
+#ifdef DEF_AUDIO_FLOAT64
+    m_floatbuf_in.resize (samples);
+    m_floatbuf_out.resize (max_out);
+
+    for (int i = 0; i < samples; i ++)
+        m_floatbuf_in[i] = in[i];
+
+    srcd.data_in = m_floatbuf_in.begin ();
+    srcd.data_out = m_floatbuf_out.begin ();
+#else
+    out.resize (old_len + max_out);
+
+    srcd.data_in = in;
+    srcd.data_out = out.begin () + old_len;
+#endif
+
+    srcd.input_frames = frames;
+    srcd.output_frames = max_out / m_channels;
+    srcd.src_ratio = m_ratio;
+    srcd.end_of_input = last;
+
+    int error;
+    if ((error = src_process (m_state, & srcd)))
+    {
+        RESAMPLE_ERROR (error);
+        out.resize (old_len);
+        return false;
+    }
+
+    int generated = m_channels * srcd.output_frames_gen;
+
+    out.resize (old_len + generated);
+
+#ifdef DEF_AUDIO_FLOAT64
+    for (int i = 0; i < generated; i ++)
+        out[old_len + i] = m_floatbuf_out[i];
+#endif
+
+    return true;
+}
+
+void SRCConverter::reset ()
+{
+    int error;
+    if ((error = src_reset (m_state)))
+        RESAMPLE_ERROR (error);
+}
 
 bool Resampler::init ()
 {
     aud_config_set_defaults ("resample", defaults);
+    load_mappings ();
     return true;
 }
 
 void Resampler::cleanup ()
 {
-    if (state)
-    {
-        src_delete (state);
-        state = nullptr;
-    }
+    delete m_conv;
+    m_conv = nullptr;
+    delete m_adaptive;
+    m_adaptive = nullptr;
+    m_active = false;
+
+    m_outbuffer.clear ();
+}
 
-    outbuffer.clear ();
+TierConverter * Resampler::create_tier (int tier, void * data)
+{
+    auto me = (Resampler *) data;
+    return SRCConverter::create (tier_methods[tier], me->m_channels, me->m_ratio);
 }
 
 void Resampler::start (int & channels, int & rate)
 {
-    if (state)
-    {
-        src_delete (state);
-        state = nullptr;
-    }
+    delete m_conv;
+    m_conv = nullptr;
+    m_active = false;
 
     int new_rate = 0;
 
     if (aud_get_bool ("resample", "use-mappings"))
-        new_rate = aud_get_int ("resample", int_to_str (rate));
+        new_rate = lookup_mapping (rate);
 
     if (! new_rate)
         new_rate = aud_get_int ("resample", "default-rate");
@@ -126,88 +272,73 @@ void Resampler::start (int & channels, int & rate)
         return;
 
     int method = aud_get_int ("resample", "method");
-    int error;
 
-    if ((state = src_new (method, channels, & error)) == nullptr)
+    m_channels = channels;
+    m_ratio = (double) new_rate / rate;
+
+    if (aud_get_bool ("resample", "adaptive"))
     {
-        RESAMPLE_ERROR (error);
-        return;
+        int max_tier = 0;
+        while (max_tier < aud::n_elements (tier_methods) - 1 &&
+         tier_methods[max_tier] != method)
+            max_tier ++;
+
+        float max_load = aud_get_int ("resample", "max-load") / 100.0f;
+
+        /* kept from song to song, see AdaptiveResampler::start() */
+        if (! m_adaptive)
+            m_adaptive = new AdaptiveResampler;
+
+        if (! m_adaptive->start (channels, rate, m_ratio, max_tier, max_load,
+         tier_names, create_tier, this))
+            return;
+    }
+    else
+    {
+        delete m_adaptive;
+        m_adaptive = nullptr;
+
+        if (! (m_conv = SRCConverter::create (method, channels, m_ratio)))
+            return;
     }
 
-    stored_channels = channels;
-    ratio = (double) new_rate / rate;
+    m_active = true;
     rate = new_rate;
 }
 
 Index<audio_sample> & Resampler::resample (Index<audio_sample> & data, bool finish)
 {
-    if (! state || ! data.len ())
+    if (! m_active || ! data.len ())
         return data;
 
-#ifdef DEF_AUDIO_FLOAT64
-    static Index<float> floatbuf_in;
-    floatbuf_in.resize (data.len ());
-    float * fout = floatbuf_in.begin ();
-    audio_sample * fin = data.begin ();
-    const audio_sample * fend = data.end ();
-    while (fin < fend)
-    {
-        *(fout++) = *(fin++);
-    }
-    static Index<float> floatbuf_out;
-    floatbuf_out.resize ((int) (data.len () * ratio) + 256);
+    int frames = data.len () / m_channels;
+    bool success;
 
-    SRC_DATA srcd = SRC_DATA ();
-    srcd.data_in = floatbuf_in.begin ();
-    srcd.data_out = floatbuf_out.begin ();
-    srcd.output_frames = floatbuf_out.len () / stored_channels;
-#else
-    outbuffer.resize ((int) (data.len () * ratio) + 256);
-
-    SRC_DATA srcd = SRC_DATA ();
+    m_outbuffer.resize (0);
 
-    srcd.data_in = data.begin ();
-    srcd.data_out = outbuffer.begin ();
-    srcd.output_frames = outbuffer.len () / stored_channels;
-#endif
-
-    srcd.input_frames = data.len () / stored_channels;
-    srcd.src_ratio = ratio;
-    srcd.end_of_input = finish;
+    if (m_adaptive)
+        success = m_adaptive->process (data.begin (), frames, m_outbuffer, finish);
+    else
+        success = m_conv->convert (data.begin (), frames, m_outbuffer, finish);
 
-    int error;
-    if ((error = src_process (state, & srcd)))
-    {
-        RESAMPLE_ERROR (error);
+    if (! success)
         return data;
-    }
-
-#ifdef DEF_AUDIO_FLOAT64
-    floatbuf_in.resize (0);
-    outbuffer.resize (stored_channels * srcd.output_frames_gen);
-    float * ain = floatbuf_out.begin ();
-    audio_sample * aout = outbuffer.begin ();
-    const audio_sample * aend = aout + (stored_channels * srcd.output_frames_gen);
-    while (aout < aend)
-    {
-        *(aout++) = *(ain++);
-    }
-    floatbuf_out.resize (0);
-#else
-    outbuffer.resize (stored_channels * srcd.output_frames_gen);
-#endif
 
     if (finish)
         flush (true);
 
-    return outbuffer;
+    return m_outbuffer;
 }
 
 bool Resampler::flush (bool force)
 {
-    int error;
-    if (state && (error = src_reset (state)))
-        RESAMPLE_ERROR (error);
+    if (! m_active)
+        return true;
+
+    if (m_conv)
+        m_conv->reset ();
+    if (m_adaptive)
+        m_adaptive->flush ();
 
     return true;
 }
@@ -233,47 +364,53 @@ const PreferencesWidget Resampler::widgets[] = {
     WidgetSpin (N_("Rate:"),
         WidgetInt ("resample", "default-rate"),
         {MIN_RATE, MAX_RATE, RATE_STEP, N_("Hz")}),
+    WidgetCheck (N_("Lower quality when CPU load is high"),
+        WidgetBool ("resample", "adaptive")),
+    WidgetSpin (N_("Maximum load:"),
+        WidgetInt ("resample", "max-load"),
+        {1, 100, 1, "%"},
+        WIDGET_CHILD),
     WidgetLabel (N_("<b>Rate Mappings</b>")),
     WidgetCheck (N_("Use rate mappings"),
         WidgetBool ("resample", "use-mappings")),
     WidgetSpin (N_("8 kHz:"),
-        WidgetInt ("resample", "8000"),
+        WidgetInt ("resample", "8000", load_mappings),
         {MIN_RATE, MAX_RATE, RATE_STEP, N_("Hz")},
         WIDGET_CHILD),
     WidgetSpin (N_("16 kHz:"),
-        WidgetInt ("resample", "16000"),
+        WidgetInt ("resample", "16000", load_mappings),
         {MIN_RATE, MAX_RATE, RATE_STEP, N_("Hz")},
         WIDGET_CHILD),
     WidgetSpin (N_("22.05 kHz:"),
-        WidgetInt ("resample", "22050"),
+        WidgetInt ("resample", "22050", load_mappings),
         {MIN_RATE, MAX_RATE, RATE_STEP, N_("Hz")},
         WIDGET_CHILD),
     WidgetSpin (N_("32.0 kHz:"),
-        WidgetInt ("resample", "32000"),
+        WidgetInt ("resample", "32000", load_mappings),
         {MIN_RATE, MAX_RATE, RATE_STEP, N_("Hz")},
         WIDGET_CHILD),
     WidgetSpin (N_("44.1 kHz:"),
-        WidgetInt ("resample", "44100"),
+        WidgetInt ("resample", "44100", load_mappings),
         {MIN_RATE, MAX_RATE, RATE_STEP, N_("Hz")},
         WIDGET_CHILD),
     WidgetSpin (N_("48 kHz:"),
-        WidgetInt ("resample", "48000"),
+        WidgetInt ("resample", "48000", load_mappings),
         {MIN_RATE, MAX_RATE, RATE_STEP, N_("Hz")},
         WIDGET_CHILD),
     WidgetSpin (N_("88.2 kHz:"),
-        WidgetInt ("resample", "88200"),
+        WidgetInt ("resample", "88200", load_mappings),
         {MIN_RATE, MAX_RATE, RATE_STEP, N_("Hz")},
         WIDGET_CHILD),
     WidgetSpin (N_("96 kHz:"),
-        WidgetInt ("resample", "96000"),
+        WidgetInt ("resample", "96000", load_mappings),
         {MIN_RATE, MAX_RATE, RATE_STEP, N_("Hz")},
         WIDGET_CHILD),
     WidgetSpin (N_("176.4 kHz:"),
-        WidgetInt ("resample", "176400"),
+        WidgetInt ("resample", "176400", load_mappings),
         {MIN_RATE, MAX_RATE, RATE_STEP, N_("Hz")},
         WIDGET_CHILD),
     WidgetSpin (N_("192 kHz:"),
-        WidgetInt ("resample", "192000"),
+        WidgetInt ("resample", "192000", load_mappings),
         {MIN_RATE, MAX_RATE, RATE_STEP, N_("Hz")},
         WIDGET_CHILD)
 };
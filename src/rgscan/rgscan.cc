@@ -0,0 +1,427 @@
+/*
+ * ReplayGain Scanner Plugin for Audacious
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#include <sndfile.h>
+
+#include <libaudcore/audstrings.h>
+#include <libaudcore/hook.h>
+#include <libaudcore/i18n.h>
+#include <libaudcore/interface.h>
+#include <libaudcore/multihash.h>
+#include <libaudcore/playlist.h>
+#include <libaudcore/plugin.h>
+#include <libaudcore/preferences.h>
+#include <libaudcore/probe.h>
+#include <libaudcore/runtime.h>
+
+#include "../loudness-common/loudness.h"
+#include "../sndfile-common/vfs-io.h"
+
+#define MAX_THREADS 16
+#define READ_FRAMES 4096
+#define MAX_GAIN 51.0 /* dB, either way */
+
+class ReplayGainScanner : public GeneralPlugin
+{
+public:
+    static const char about[];
+    static const char * const defaults[];
+    static const PreferencesWidget widgets[];
+    static const PluginPreferences prefs;
+
+    static constexpr PluginInfo info = {
+        N_("ReplayGain Scanner"),
+        PACKAGE,
+        about,
+        & prefs
+    };
+
+    constexpr ReplayGainScanner () : GeneralPlugin (info, false) {}
+
+    bool init ();
+    void cleanup ();
+};
+
+EXPORT ReplayGainScanner aud_plugin_instance;
+
+const char ReplayGainScanner::about[] =
+ N_("ReplayGain Scanner Plugin for Audacious\n"
+    "Copyright 2026 Audacious developers\n\n"
+    "Measures the loudness of the selected songs as in ITU-R BS.1770 and "
+    "EBU R128 and writes ReplayGain 2.0 track and album values to their tags. "
+    "Songs are grouped into albums by album and album artist (or folder).\n\n"
+    "Songs are decoded with libsndfile; those in formats it cannot read (such "
+    "as MP3, AAC, or Opus) are counted as failures.");
+
+const char * const ReplayGainScanner::defaults[] = {
+    "reference", "-18",
+    "true_peak", "FALSE",
+    nullptr
+};
+
+const PreferencesWidget ReplayGainScanner::widgets[] = {
+    WidgetLabel (N_("<b>ReplayGain Scanner</b>")),
+    WidgetSpin (N_("Reference level:"),
+        WidgetInt ("rgscan", "reference"),
+        {-23, -14, 1, N_("LUFS")}),
+    WidgetCheck (N_("Store the true peak (oversampled) as peak value"),
+        WidgetBool ("rgscan", "true_peak"))
+};
+
+const PluginPreferences ReplayGainScanner::prefs = {{widgets}};
+
+static constexpr AudMenuID menus[] = {
+    AudMenuID::Main,
+    AudMenuID::Playlist
+};
+
+struct Track
+{
+    String filename;
+    PluginHandle * decoder;
+    Tuple tuple;
+};
+
+/* a whole album, or a single song without one */
+struct Job
+{
+    Index<int> tracks;
+    bool album;
+};
+
+static Index<Track> tracks;
+static Index<Job> jobs;
+
+static pthread_t threads[MAX_THREADS];
+static int n_threads;
+
+static std::atomic<int> next_job, done_files, failed_files, unreadable_files;
+static std::atomic<bool> aborted;
+
+static int reference;
+static bool use_true_peak;
+
+static bool scan_file (const char * filename, LoudnessMeter & meter)
+{
+    VFSFile file (filename, "r");
+    if (! file)
+        return false;
+
+    SF_INFO info {}; // must be zeroed before sf_open()
+    SNDFILE * sndfile = sf_open_virtual (& vfs_sndfile_io, SFM_READ, & info, & file);
+
+    if (! sndfile)
+    {
+        AUDWARN ("Cannot decode %s: %s.\n", filename, sf_strerror (nullptr));
+        unreadable_files ++;
+        return false;
+    }
+
+    meter.start (info.channels, info.samplerate);
+
+    Index<audio_sample> buffer;
+    buffer.resize (info.channels * READ_FRAMES);
+
+    sf_count_t frames;
+#ifdef DEF_AUDIO_FLOAT64
+    while (! aborted && (frames = sf_readf_double (sndfile, buffer.begin (), READ_FRAMES)) > 0)
+#else
+    while (! aborted && (frames = sf_readf_float (sndfile, buffer.begin (), READ_FRAMES)) > 0)
+#endif
+        meter.process (buffer.begin (), frames);
+
+    sf_close (sndfile);
+    return ! aborted;
+}
+
+/* keeps a value already in the tuple right when its divisor changes */
+static void rescale_field (Tuple & tuple, Tuple::Field field, int from, int to)
+{
+    if (tuple.get_value_type (field) == Tuple::Int && from > 0)
+        tuple.set_int (field, lround ((double) tuple.get_int (field) * to / from));
+}
+
+static void set_values (Tuple & tuple, Tuple::Field gain_field,
+ Tuple::Field peak_field, double loudness, double peak)
+{
+    double gain = aud::clamp (reference - loudness, -MAX_GAIN, MAX_GAIN);
+
+    tuple.set_int (gain_field, lround (gain * 100));
+    tuple.set_int (peak_field, lround (peak * 1000000));
+}
+
+static void scan_job (Job & job)
+{
+    int count = job.tracks.len ();
+
+    Index<double> loudness, peaks;
+    loudness.resize (count);
+    peaks.resize (count);
+
+    LoudnessMeter album;
+    bool album_ok = job.album;
+
+    for (int i = 0; i < count; i ++)
+    {
+        LoudnessMeter meter;
+
+        if (scan_file (tracks[job.tracks[i]].filename, meter))
+        {
+            loudness[i] = meter.integrated ();
+            peaks[i] = use_true_peak ? meter.true_peak () : meter.sample_peak ();
+            album.add (meter);
+        }
+        else
+        {
+            loudness[i] = -HUGE_VAL;
+            album_ok = false;
+        }
+    }
+
+    if (aborted)
+        return;
+
+    double album_loudness = album.integrated ();
+    double album_peak = use_true_peak ? album.true_peak () : album.sample_peak ();
+
+    if (album_loudness == -HUGE_VAL)
+        album_ok = false;
+
+    for (int i = 0; i < count; i ++)
+    {
+        Track & track = tracks[job.tracks[i]];
+
+        /* silence has no loudness to adjust */
+        if (loudness[i] == -HUGE_VAL)
+        {
+            failed_files ++;
+            done_files ++;
+            continue;
+        }
+
+        Tuple tuple = track.tuple.ref ();
+
+        int gain_divisor = tuple.get_int (Tuple::GainDivisor);
+        int peak_divisor = tuple.get_int (Tuple::PeakDivisor);
+
+        rescale_field (tuple, Tuple::AlbumGain, gain_divisor, 100);
+        rescale_field (tuple, Tuple::AlbumPeak, peak_divisor, 1000000);
+
+        tuple.set_int (Tuple::GainDivisor, 100);
+        tuple.set_int (Tuple::PeakDivisor, 1000000);
+
+        set_values (tuple, Tuple::TrackGain, Tuple::TrackPeak, loudness[i], peaks[i]);
+
+        if (album_ok)
+            set_values (tuple, Tuple::AlbumGain, Tuple::AlbumPeak, album_loudness, album_peak);
+
+        if (! aud_file_write_tuple (track.filename, track.decoder, tuple))
+        {
+            AUDWARN ("Cannot write ReplayGain to %s.\n", (const char *) track.filename);
+            failed_files ++;
+        }
+
+        done_files ++;
+    }
+}
+
+static void * worker (void *)
+{
+    int job;
+    while (! aborted && (job = next_job ++) < jobs.len ())
+        scan_job (jobs[job]);
+
+    return nullptr;
+}
+
+static void finish ()
+{
+    for (int i = 0; i < n_threads; i ++)
+        pthread_join (threads[i], nullptr);
+
+    n_threads = 0;
+    aud_ui_hide_progress ();
+
+    if (! aborted && unreadable_files)
+        aud_ui_show_error (str_printf (_("ReplayGain could not be calculated "
+         "or saved for %d of %d files, %d of them in a format that cannot be "
+         "decoded."), (int) failed_files, tracks.len (), (int) unreadable_files));
+    else if (! aborted && failed_files)
+        aud_ui_show_error (str_printf (_("ReplayGain could not be calculated "
+         "or saved for %d of %d files."), (int) failed_files, tracks.len ()));
+
+    tracks.clear ();
+    jobs.clear ();
+}
+
+static void show_progress (void *)
+{
+    if (done_files == tracks.len ())
+    {
+        timer_remove (TimerRate::Hz4, show_progress);
+        finish ();
+        return;
+    }
+
+    aud_ui_show_progress (_("Calculating ReplayGain ..."));
+
+    if (unreadable_files)
+        aud_ui_show_progress_2 (str_printf (_("%d of %d files (%d could not "
+         "be decoded)"), (int) done_files, tracks.len (), (int) unreadable_files));
+    else
+        aud_ui_show_progress_2 (str_printf (_("%d of %d files"), (int) done_files, tracks.len ()));
+}
+
+/* songs belong together if they have the same album and album artist; when
+ * there is no album artist (as with many compilations), the same folder */
+static String album_key (const Track & track)
+{
+    String album = track.tuple.get_str (Tuple::Album);
+    if (! album)
+        return String ();
+
+    String artist = track.tuple.get_str (Tuple::AlbumArtist);
+    if (artist)
+        return String (str_concat ({album, "\n", artist}));
+
+    const char * slash = strrchr (track.filename, '/');
+    int len = slash ? slash - track.filename : 0;
+
+    return String (str_concat ({album, "\n\n", str_copy (track.filename, len)}));
+}
+
+static void start_scan ()
+{
+    if (n_threads)
+        return;
+
+    auto playlist = Playlist::active_playlist ();
+    int entries = playlist.n_entries ();
+
+    for (int i = 0; i < entries; i ++)
+    {
+        if (! playlist.entry_selected (i))
+            continue;
+
+        String filename = playlist.entry_filename (i);
+        PluginHandle * decoder = playlist.entry_decoder (i, Playlist::NoWait);
+        Tuple tuple = playlist.entry_tuple (i, Playlist::NoWait);
+
+        /* songs within a cuesheet or a multi-song file share their tags */
+        if (! decoder || tuple.state () != Tuple::Valid ||
+         tuple.is_set (Tuple::StartTime) || tuple.is_set (Tuple::Subtune) ||
+         ! aud_file_can_write_tuple (filename, decoder))
+        {
+            AUDINFO ("Skipping %s.\n", (const char *) filename);
+            continue;
+        }
+
+        Track & track = tracks.append ();
+        track.filename = std::move (filename);
+        track.decoder = decoder;
+        track.tuple = std::move (tuple);
+    }
+
+    if (! tracks.len ())
+        return;
+
+    SimpleHash<String, int> albums;
+
+    for (int i = 0; i < tracks.len (); i ++)
+    {
+        String key = album_key (tracks[i]);
+        int * job = key ? albums.lookup (key) : nullptr;
+
+        if (job)
+        {
+            jobs[* job].tracks.append (i);
+            continue;
+        }
+
+        Job & added = jobs.append ();
+        added.tracks.append (i);
+        added.album = (bool) key;
+
+        if (key)
+            albums.add (key, jobs.len () - 1);
+    }
+
+    reference = aud_get_int ("rgscan", "reference");
+    use_true_peak = aud_get_bool ("rgscan", "true_peak");
+
+    next_job = 0;
+    done_files = 0;
+    failed_files = 0;
+    unreadable_files = 0;
+    aborted = false;
+
+    int count = aud::clamp ((int) sysconf (_SC_NPROCESSORS_ONLN), 1, MAX_THREADS);
+    count = aud::min (count, jobs.len ());
+
+    for (int i = 0; i < count; i ++)
+    {
+        if (pthread_create (& threads[n_threads], nullptr, worker, nullptr))
+        {
+            AUDERR ("Failed to create worker thread.\n");
+            break;
+        }
+
+        n_threads ++;
+    }
+
+    if (! n_threads)
+    {
+        tracks.clear ();
+        jobs.clear ();
+        return;
+    }
+
+    timer_add (TimerRate::Hz4, show_progress);
+    show_progress (nullptr);
+}
+
+bool ReplayGainScanner::init ()
+{
+    aud_config_set_defaults ("rgscan", defaults);
+
+    for (AudMenuID menu : menus)
+        aud_plugin_menu_add (menu, start_scan, _("Calculate ReplayGain"), "audio-volume-high");
+
+    return true;
+}
+
+void ReplayGainScanner::cleanup ()
+{
+    for (AudMenuID menu : menus)
+        aud_plugin_menu_remove (menu, start_scan);
+
+    if (n_threads)
+    {
+        aborted = true;
+        timer_remove (TimerRate::Hz4, show_progress);
+        finish ();
+    }
+}
@@ -0,0 +1,131 @@
+/*
+ * Silence Removal Plugin for Audacious
+ * Copyright 2014 John Lindgren
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#include <math.h>
+
+#include <libaudcore/runtime.h>
+
+#include "scanner.h"
+
+/* The samples are checked a block at a time with a branch-free peak loop that
+ * the compiler can vectorize; only a block that holds a loud sample is then
+ * searched one sample at a time. */
+#define SCAN_BLOCK 64
+
+static audio_sample block_peak (const audio_sample * data, int len)
+{
+    audio_sample peak = 0;
+
+    for (int i = 0; i < len; i ++)
+    {
+        audio_sample a = data[i] < 0 ? -data[i] : data[i];
+        peak = (a > peak) ? a : peak;
+    }
+
+    return peak;
+}
+
+static bool is_loud (audio_sample sample, audio_sample level)
+    { return sample > level || sample < -level; }
+
+int silence_first_frame (const audio_sample * data, int frames, int channels, audio_sample level)
+{
+    int len = frames * channels;
+
+    for (int pos = 0; pos < len; pos += SCAN_BLOCK)
+    {
+        int block = aud::min (len - pos, SCAN_BLOCK);
+
+        if (block_peak (data + pos, block) <= level)
+            continue;
+
+        for (int i = pos; i < pos + block; i ++)
+        {
+            if (is_loud (data[i], level))
+                return i / channels;
+        }
+    }
+
+    return -1;
+}
+
+int silence_last_frame (const audio_sample * data, int frames, int channels, audio_sample level)
+{
+    int len = frames * channels;
+
+    for (int end = len; end > 0; end -= SCAN_BLOCK)
+    {
+        int block = aud::min (end, SCAN_BLOCK);
+
+        if (block_peak (data + end - block, block) <= level)
+            continue;
+
+        for (int i = end - 1; i >= end - block; i --)
+        {
+            if (is_loud (data[i], level))
+                return i / channels;
+        }
+    }
+
+    return -1;
+}
+
+void SilenceParams::read (SilenceParams & params)
+{
+    int threshold = aud_get_int ("silence-removal", "threshold");
+    int hysteresis = aud_get_int ("silence-removal", "hysteresis");
+
+    params.close_level = powf (10, threshold / 20.0f);
+    params.open_level = powf (10, (threshold + hysteresis) / 20.0f);
+    params.hold = aud_get_int ("silence-removal", "hold");
+}
+
+void SilenceAnalyzer::start (int channels, int rate, const SilenceParams & params)
+{
+    m_channels = channels;
+    m_params = params;
+    m_hold_frames = aud::rescale (params.hold, 1000, rate);
+    m_frames = 0;
+    m_start = m_last = -1;
+}
+
+void SilenceAnalyzer::analyze (const audio_sample * data, int samples)
+{
+    int frames = samples / m_channels;
+    int from = 0;
+
+    if (m_start < 0)
+    {
+        if ((from = silence_first_frame (data, frames, m_channels, m_params.open_level)) < 0)
+        {
+            m_frames += frames;
+            return;
+        }
+
+        m_start = m_frames + from;
+    }
+
+    int last = silence_last_frame (data + from * m_channels, frames - from,
+     m_channels, m_params.close_level);
+
+    if (last >= 0)
+        m_last = m_frames + from + last;
+
+    m_frames += frames;
+}
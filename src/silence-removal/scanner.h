@@ -0,0 +1,66 @@
+/*
+ * Silence Removal Plugin for Audacious
+ * Copyright 2014 John Lindgren
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef SILENCE_SCANNER_H
+#define SILENCE_SCANNER_H
+
+#include <stdint.h>
+
+#include <libaudcore/plugin.h>
+
+/* Returns the first or last frame of <data> containing a sample louder than
+ * <level> (as a linear amplitude), or -1 if there is none.  The search starts
+ * from the end in question and stops at the first hit. */
+int silence_first_frame (const audio_sample * data, int frames, int channels, audio_sample level);
+int silence_last_frame (const audio_sample * data, int frames, int channels, audio_sample level);
+
+struct SilenceParams
+{
+    audio_sample close_level; /* below this is silence */
+    audio_sample open_level;  /* leading silence ends above this */
+    int hold;                 /* in milliseconds, kept after the last sound */
+
+    static void read (SilenceParams & params);
+};
+
+/* Finds the trim points of a whole song without touching the audio, using the
+ * same rules as the effect: the song starts at the first frame above the open
+ * level and ends <hold> after the last frame above the close level.  This lets
+ * the trim points be worked out ahead of playback. */
+class SilenceAnalyzer
+{
+public:
+    void start (int channels, int rate, const SilenceParams & params);
+    void analyze (const audio_sample * data, int samples);
+
+    /* in frames; both are -1 if the song is all silence */
+    int64_t trim_start () const
+        { return m_start; }
+    int64_t trim_end () const
+        { return (m_start < 0) ? -1 : aud::min (m_last + 1 + m_hold_frames, m_frames); }
+
+private:
+    int m_channels = 0;
+    SilenceParams m_params = SilenceParams ();
+    int m_hold_frames = 0;
+    int64_t m_frames = 0;
+    int64_t m_start = -1, m_last = -1;
+};
+
+#endif
@@ -23,7 +23,8 @@
 #include <libaudcore/ringbuf.h>
 #include <libaudcore/runtime.h>
 
-#include <math.h>
+#include "../effect-common/params.h"
+#include "scanner.h"
 
 #define MAX_BUFFER_SECS  10
 
@@ -60,31 +61,50 @@ const char SilenceRemoval::about[] =
 
 const char * const SilenceRemoval::defaults[] = {
     "threshold", "-40",
+    "hysteresis", "0",
+    "hold", "0",
     nullptr
 };
 
+static void settings_changed ()
+{
+    effect_settings_changed ("silence-removal");
+}
+
 const PreferencesWidget SilenceRemoval::widgets[] = {
     WidgetLabel (N_("<b>Silence Removal</b>")),
     WidgetSpin (N_("Threshold:"),
-        WidgetInt ("silence-removal", "threshold"),
-        {-60, -20, 1, N_("dB")})
+        WidgetInt ("silence-removal", "threshold", settings_changed),
+        {-60, -20, 1, N_("dB")}),
+    WidgetSpin (N_("Hysteresis:"),
+        WidgetInt ("silence-removal", "hysteresis", settings_changed),
+        {0, 20, 1, N_("dB")}),
+    WidgetSpin (N_("Hold:"),
+        WidgetInt ("silence-removal", "hold", settings_changed),
+        {0, 2000, 10, N_("ms")})
 };
 
 const PluginPreferences SilenceRemoval::prefs = {{widgets}};
 
 static RingBuf<audio_sample> buffer;
 static Index<audio_sample> output;
-static int current_channels;
+static int current_channels, current_rate;
 static bool initial_silence;
+static int hold_left; /* frames of the hold still to come */
+
+static EffectParams<SilenceParams> silence_params (SilenceParams::read);
 
 bool SilenceRemoval::init ()
 {
     aud_config_set_defaults ("silence-removal", defaults);
+    silence_params.update ();
+    silence_params.watch ("silence-removal");
     return true;
 }
 
 void SilenceRemoval::cleanup ()
 {
+    silence_params.unwatch ("silence-removal");
     buffer.destroy ();
     output.clear ();
 }
@@ -96,19 +116,9 @@ void SilenceRemoval::start (int & channels, int & rate)
     output.resize (0);
 
     current_channels = channels;
+    current_rate = rate;
     initial_silence = true;
-}
-
-static audio_sample * align_to_frame (audio_sample * begin, audio_sample * sample, bool align_to_end)
-{
-    if (! sample)
-        return nullptr;
-
-    int offset = sample - begin;
-    if (align_to_end)
-        offset += current_channels;
-
-    return begin + (offset - offset % current_channels);
+    hold_left = 0;
 }
 
 static void buffer_with_overflow (const audio_sample * data, int len)
@@ -133,52 +143,61 @@ static void buffer_with_overflow (const audio_sample * data, int len)
 
 Index<audio_sample> & SilenceRemoval::process (Index<audio_sample> & data)
 {
-    const int threshold_db = aud_get_int ("silence-removal", "threshold");
-    const audio_sample threshold = pow (10.0, threshold_db / 20.0);
-
-    audio_sample * first_sample = nullptr;
-    audio_sample * last_sample = nullptr;
-
-    for (audio_sample & sample : data)
-    {
-        if (sample > threshold || sample < -threshold)
-        {
-            if (! first_sample)
-                first_sample = & sample;
-
-            last_sample = & sample;
-        }
-    }
+    const SilenceParams & params = silence_params.get ();
+    int hold_frames = aud::rescale (params.hold, 1000, current_rate);
 
-    first_sample = align_to_frame (data.begin (), first_sample, false);
-    last_sample = align_to_frame (data.begin (), last_sample, true);
+    int channels = current_channels;
+    int frames = data.len () / channels;
+    int first = 0;
 
     output.resize (0);
 
-    if (first_sample)
+    if (initial_silence)
     {
-        /* do not skip leading silence if non-silence has been seen */
-        if (! initial_silence)
-            first_sample = data.begin ();
+        /* skip leading silence until something is clearly not silence */
+        if ((first = silence_first_frame (data.begin (), frames, channels, params.open_level)) < 0)
+            return output;
 
         initial_silence = false;
+        hold_left = 0;
+    }
 
-        /* copy any saved silence from previous call */
-        buffer.move_out (output, -1, -1);
+    /* after non-silence has been seen, all of the audio up to <end> is
+     * passed on; anything after it is held back in case it is trailing
+     * silence */
+    int last = silence_last_frame (data.begin () + first * channels,
+     frames - first, channels, params.close_level);
 
-        /* copy non-silent portion */
-        output.insert (first_sample, -1, last_sample - first_sample);
+    int end = aud::min (hold_left, frames);
 
-        /* save trailing silence */
-        buffer_with_overflow (last_sample, data.end () - last_sample);
+    if (last >= 0)
+    {
+        int sound_end = first + last + 1;
+        end = aud::min (sound_end + hold_frames, frames);
+        hold_left = sound_end + hold_frames - end;
     }
     else
+        hold_left -= end;
+
+    if (! end)
     {
-        /* if non-silence has been seen, save entire silent chunk */
-        if (! initial_silence)
-            buffer_with_overflow (data.begin (), data.len ());
+        buffer_with_overflow (data.begin (), data.len ());
+        return output;
     }
 
+    /* the usual case while playing: nothing to trim and nothing saved */
+    if (! first && end == frames && ! buffer.len ())
+        return data;
+
+    /* copy any saved silence from previous call */
+    buffer.move_out (output, -1, -1);
+
+    /* copy non-silent portion */
+    output.insert (data.begin () + first * channels, -1, (end - first) * channels);
+
+    /* save trailing silence */
+    buffer_with_overflow (data.begin () + end * channels, (frames - end) * channels);
+
     return output;
 }
 
@@ -188,5 +207,6 @@ bool SilenceRemoval::flush (bool force)
     output.resize (0);
 
     initial_silence = true;
+    hold_left = 0;
     return true;
 }
@@ -0,0 +1,414 @@
+/*
+ * Simple DSP Chain Plugin for Audacious
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Runs the Bitcrusher, Crystalizer, Extra Stereo and Voice Removal effects
+ * in a single pass over the audio, in the order in which the separate
+ * plugins would run.  The arithmetic is that of the separate plugins, so
+ * the output is the same sample for sample.  The stages share their
+ * settings with the separate plugins. */
+
+#include <utility>
+
+#include <libaudcore/i18n.h>
+#include <libaudcore/runtime.h>
+#include <libaudcore/plugin.h>
+#include <libaudcore/preferences.h>
+
+#include "../effect-common/bitcrush.h"
+#include "../effect-common/params.h"
+#include "../effect-common/smoothing.h"
+
+#define SMOOTH_TIME 0.05f /* seconds, as in the separate plugins */
+#define CHUNK 256         /* frames */
+
+enum {
+    STAGE_BITCRUSHER = (1 << 0),
+    STAGE_CRYSTALIZER = (1 << 1),
+    STAGE_EXTRA_STEREO = (1 << 2),
+    STAGE_VOICE_REMOVAL = (1 << 3),
+    STAGE_ALL = (1 << 4) - 1
+};
+
+/* the stages that only work on stereo */
+static constexpr int STEREO_STAGES = STAGE_EXTRA_STEREO | STAGE_VOICE_REMOVAL;
+
+struct Params {
+    int stages;
+    float crush_depth, crush_downsample;
+    float cryst_intensity;
+    float stereo_intensity;
+};
+
+class SimpleDSP : public EffectPlugin
+{
+public:
+    static const char about[];
+    static const char * const defaults[];
+    static const PreferencesWidget widgets[];
+    static const PluginPreferences prefs;
+
+    static constexpr PluginInfo info = {
+        N_("Simple DSP Chain"),
+        PACKAGE,
+        about,
+        & prefs
+    };
+
+    constexpr SimpleDSP () : EffectPlugin (info, 0, true) {}
+
+    bool init ();
+    void cleanup ();
+
+    void start (int & channels, int & rate);
+    Index<audio_sample> & process (Index<audio_sample> & data);
+    bool flush (bool force);
+};
+
+EXPORT SimpleDSP aud_plugin_instance;
+
+const char SimpleDSP::about[] =
+ N_("Runs Bitcrusher, Crystalizer, Extra Stereo and Voice Removal in a "
+    "single pass, which is lighter than running them as separate effects.  "
+    "The settings are shared with the separate effects, which should not be "
+    "enabled at the same time.");
+
+const char * const SimpleDSP::defaults[] = {
+ "bitcrusher", "FALSE",
+ "crystalizer", "FALSE",
+ "extra_stereo", "FALSE",
+ "voice_removal", "FALSE",
+ nullptr};
+
+/* Defaults of the separate plugins, which may not have been loaded. */
+static const char * const bitcrusher_defaults[] = {
+ "depth", "32",
+ "downsample", "1.0",
+ nullptr};
+
+static const char * const cryst_defaults[] = {
+ "intensity", "1",
+ nullptr};
+
+static const char * const stereo_defaults[] = {
+ "intensity", "2.5",
+ nullptr};
+
+static void read_params (Params & p)
+{
+    p.stages = 0;
+    if (aud_get_bool ("simple_dsp", "bitcrusher"))
+        p.stages |= STAGE_BITCRUSHER;
+    if (aud_get_bool ("simple_dsp", "crystalizer"))
+        p.stages |= STAGE_CRYSTALIZER;
+    if (aud_get_bool ("simple_dsp", "extra_stereo"))
+        p.stages |= STAGE_EXTRA_STEREO;
+    if (aud_get_bool ("simple_dsp", "voice_removal"))
+        p.stages |= STAGE_VOICE_REMOVAL;
+
+    p.crush_depth = aud_get_double ("bitcrusher", "depth");
+    p.crush_downsample = aud_get_double ("bitcrusher", "downsample");
+    p.cryst_intensity = aud_get_double ("crystalizer", "intensity");
+    p.stereo_intensity = aud_get_double ("extra_stereo", "intensity");
+}
+
+static EffectParams<Params> params (read_params);
+
+/* the sections whose changes are picked up; those of the separate plugins are
+ * also changed in their own preferences */
+static const char * const sections[] = {
+    "simple_dsp",
+    "bitcrusher",
+    "crystalizer",
+    "extra_stereo"
+};
+
+static void stages_changed ()
+    { effect_settings_changed ("simple_dsp"); }
+static void bitcrusher_changed ()
+    { effect_settings_changed ("bitcrusher"); }
+static void crystalizer_changed ()
+    { effect_settings_changed ("crystalizer"); }
+static void extra_stereo_changed ()
+    { effect_settings_changed ("extra_stereo"); }
+
+const PreferencesWidget SimpleDSP::widgets[] = {
+    WidgetLabel (N_("<b>Stages</b>")),
+    WidgetCheck (N_("Bitcrusher"),
+        WidgetBool ("simple_dsp", "bitcrusher", stages_changed)),
+    WidgetSpin (N_("Bit Depth:"),
+        WidgetFloat ("bitcrusher", "depth", bitcrusher_changed),
+        {2, 32, 0.1}, WIDGET_CHILD),
+    WidgetSpin (N_("Downsample ratio:"),
+        WidgetFloat ("bitcrusher", "downsample", bitcrusher_changed),
+        {0.02, 1.0, 0.02}, WIDGET_CHILD),
+    WidgetCheck (N_("Crystalizer"),
+        WidgetBool ("simple_dsp", "crystalizer", stages_changed)),
+    WidgetSpin (N_("Intensity:"),
+        WidgetFloat ("crystalizer", "intensity", crystalizer_changed),
+        {0, 10, 0.1}, WIDGET_CHILD),
+    WidgetCheck (N_("Extra Stereo"),
+        WidgetBool ("simple_dsp", "extra_stereo", stages_changed)),
+    WidgetSpin (N_("Intensity:"),
+        WidgetFloat ("extra_stereo", "intensity", extra_stereo_changed),
+        {0, 10, 0.1}, WIDGET_CHILD),
+    WidgetCheck (N_("Voice Removal"),
+        WidgetBool ("simple_dsp", "voice_removal", stages_changed))
+};
+
+const PluginPreferences SimpleDSP::prefs = {{widgets}};
+
+static int dsp_channels, dsp_rate;
+static int dsp_stages; /* the stages running, for resetting new ones */
+
+static float crush_accumulator;
+static Index<audio_sample> crush_hold;
+static Index<audio_sample> cryst_prev;
+
+static LinearSmoother crush_depth, crush_downsample;
+static LinearSmoother cryst_intensity, stereo_intensity;
+static CrushFactors crush_set_factors; /* for the set depth */
+static float crush_factors_depth;
+
+/* the smoothed parameters of a chunk, one value per frame */
+struct Chunk {
+    bool depth_gliding;
+    float crush_depth[CHUNK], crush_downsample[CHUNK];
+    float cryst_intensity[CHUNK];
+    float stereo_intensity[CHUNK];
+};
+
+typedef void (* ChainFunc) (const Chunk & c, audio_sample * data, int frames);
+
+/* One pass over a chunk through the stages in <STAGES>.  <CHANNELS> is 2 for
+ * stereo, so that the inner loop is unrolled, and 0 for any other count (the
+ * stereo-only stages are then never in <STAGES>). */
+template<int STAGES, int CHANNELS>
+static void run_chain (const Chunk & c, audio_sample * f, int frames)
+{
+    constexpr bool crush = (STAGES & STAGE_BITCRUSHER);
+    constexpr bool cryst = (STAGES & STAGE_CRYSTALIZER);
+    constexpr bool stereo = (STAGES & STAGE_EXTRA_STEREO);
+    constexpr bool voice = (STAGES & STAGE_VOICE_REMOVAL);
+
+    static_assert (CHANNELS == 2 || ! (STAGES & STEREO_STAGES),
+     "stereo-only stages need two channels");
+
+    const int channels = CHANNELS ? CHANNELS : dsp_channels;
+
+    float accumulator = crush_accumulator;
+    audio_sample * hold = crush_hold.begin ();
+    audio_sample * prev = cryst_prev.begin ();
+
+    for (int i = 0; i < frames; i ++, f += channels)
+    {
+        bool sample = false;
+        CrushFactors factors = crush_set_factors;
+
+        if (crush)
+        {
+            accumulator += c.crush_downsample[i];
+
+            if (accumulator >= 1.0)
+            {
+                if (c.depth_gliding)
+                    factors = crush_factors (c.crush_depth[i]);
+
+                sample = true;
+                accumulator -= 1.0;
+            }
+        }
+
+        for (int channel = 0; channel < channels; channel ++)
+        {
+            audio_sample current = f[channel];
+
+            if (crush)
+            {
+                if (sample)
+                    hold[channel] = crush_sample (current, factors);
+
+                current = hold[channel];
+            }
+
+            if (cryst)
+            {
+                audio_sample last = prev[channel];
+                prev[channel] = current;
+                current = current + (current - last) * c.cryst_intensity[i];
+            }
+
+            f[channel] = current;
+        }
+
+        if (stereo)
+        {
+            audio_sample center = (f[0] + f[1]) / 2;
+            f[0] = center + (f[0] - center) * c.stereo_intensity[i];
+            f[1] = center + (f[1] - center) * c.stereo_intensity[i];
+        }
+
+        if (voice)
+        {
+            f[0] -= f[1];
+            f[1] = f[0];
+        }
+    }
+
+    crush_accumulator = accumulator;
+}
+
+/* The table of passes for every combination of stages.  For other than
+ * stereo, the stereo-only stages are masked out beforehand, so they are
+ * left out of the table too. */
+template<int CHANNELS, int ... STAGES>
+static ChainFunc get_chain (int stages, std::integer_sequence<int, STAGES ...>)
+{
+    static constexpr ChainFunc funcs[] = {run_chain<(CHANNELS == 2) ?
+     STAGES : (STAGES & ~ STEREO_STAGES), CHANNELS> ...};
+
+    return funcs[stages];
+}
+
+bool SimpleDSP::init ()
+{
+    aud_config_set_defaults ("simple_dsp", defaults);
+    aud_config_set_defaults ("bitcrusher", bitcrusher_defaults);
+    aud_config_set_defaults ("crystalizer", cryst_defaults);
+    aud_config_set_defaults ("extra_stereo", stereo_defaults);
+
+    params.update ();
+    for (const char * section : sections)
+        params.watch (section);
+
+    return true;
+}
+
+void SimpleDSP::cleanup ()
+{
+    for (const char * section : sections)
+        params.unwatch (section);
+
+    crush_hold.clear ();
+    cryst_prev.clear ();
+}
+
+void SimpleDSP::start (int & channels, int & rate)
+{
+    dsp_channels = channels;
+    dsp_rate = rate;
+    dsp_stages = 0;
+
+    crush_hold.resize (channels);
+    cryst_prev.resize (channels);
+}
+
+/* a stage switched on starts out as the separate plugin would on starting */
+static void start_stages (const Params & p, int stages)
+{
+    if (stages & STAGE_BITCRUSHER)
+    {
+        crush_accumulator = 0.0f;
+        crush_hold.erase (0, dsp_channels);
+
+        crush_depth.setup (SMOOTH_TIME, dsp_rate);
+        crush_depth.reset (p.crush_depth);
+        crush_downsample.setup (SMOOTH_TIME, dsp_rate);
+        crush_downsample.reset (p.crush_downsample);
+    }
+
+    if (stages & STAGE_CRYSTALIZER)
+    {
+        cryst_prev.erase (0, dsp_channels);
+
+        cryst_intensity.setup (SMOOTH_TIME, dsp_rate);
+        cryst_intensity.reset (p.cryst_intensity);
+    }
+
+    if (stages & STAGE_EXTRA_STEREO)
+    {
+        stereo_intensity.setup (SMOOTH_TIME, dsp_rate);
+        stereo_intensity.reset (p.stereo_intensity);
+    }
+}
+
+Index<audio_sample> & SimpleDSP::process (Index<audio_sample> & data)
+{
+    const Params & p = params.get ();
+
+    int stages = p.stages;
+    if (dsp_channels != 2)
+        stages &= ~ STEREO_STAGES;
+
+    start_stages (p, stages & ~ dsp_stages);
+    dsp_stages = stages;
+
+    if (! stages)
+        return data;
+
+    crush_depth.set_target (p.crush_depth);
+    crush_downsample.set_target (p.crush_downsample);
+    cryst_intensity.set_target (p.cryst_intensity);
+    stereo_intensity.set_target (p.stereo_intensity);
+
+    if ((stages & STAGE_BITCRUSHER) && p.crush_depth != crush_factors_depth)
+    {
+        crush_set_factors = crush_factors (p.crush_depth);
+        crush_factors_depth = p.crush_depth;
+    }
+
+    auto all = std::make_integer_sequence<int, STAGE_ALL + 1> ();
+    ChainFunc func = (dsp_channels == 2) ? get_chain<2> (stages, all) :
+     get_chain<0> (stages, all);
+
+    audio_sample * f = data.begin ();
+    int frames = data.len () / dsp_channels;
+    Chunk c;
+
+    while (frames)
+    {
+        int chunk = aud::min (frames, CHUNK);
+
+        /* only the smoothers of running stages move on */
+        if (stages & STAGE_BITCRUSHER)
+        {
+            c.depth_gliding = ! crush_depth.settled ();
+            crush_depth.fill (c.crush_depth, chunk);
+            crush_downsample.fill (c.crush_downsample, chunk);
+        }
+
+        if (stages & STAGE_CRYSTALIZER)
+            cryst_intensity.fill (c.cryst_intensity, chunk);
+        if (stages & STAGE_EXTRA_STEREO)
+            stereo_intensity.fill (c.stereo_intensity, chunk);
+
+        func (c, f, chunk);
+
+        f += chunk * dsp_channels;
+        frames -= chunk;
+    }
+
+    return data;
+}
+
+bool SimpleDSP::flush (bool force)
+{
+    crush_hold.erase (0, dsp_channels);
+    cryst_prev.erase (0, dsp_channels);
+    return true;
+}
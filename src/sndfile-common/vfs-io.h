@@ -0,0 +1,31 @@
+/*
+ * VFS access for libsndfile, for Audacious plugins
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+#ifndef AUDACIOUS_SNDFILE_VFS_IO_H
+#define AUDACIOUS_SNDFILE_VFS_IO_H
+
+#include <sndfile.h>
+
+/* Callbacks for sf_open_virtual(), reading from the VFSFile passed as user
+ * data.  Writing is not supported.  The stream variant refuses to seek, so
+ * that libsndfile does not try to on a file that cannot. */
+extern SF_VIRTUAL_IO vfs_sndfile_io;
+extern SF_VIRTUAL_IO vfs_sndfile_io_stream;
+
+#endif
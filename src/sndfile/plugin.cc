@@ -22,11 +22,12 @@
 #include <stdlib.h>
 #include <sndfile.h>
 
-#define WANT_VFS_STDIO_COMPAT
 #include <libaudcore/plugin.h>
 #include <libaudcore/i18n.h>
 #include <libaudcore/audstrings.h>
 
+#include "../sndfile-common/vfs-io.h"
+
 class SndfilePlugin : public InputPlugin
 {
 public:
@@ -52,66 +53,6 @@ public:
 
 EXPORT SndfilePlugin aud_plugin_instance;
 
-/* Virtual file access wrappers for libsndfile
- */
-static sf_count_t
-sf_get_filelen (void *user_data)
-{
-    int64_t size = ((VFSFile *) user_data)->fsize ();
-    return (size < 0) ? SF_COUNT_MAX : size;
-}
-
-static sf_count_t
-sf_vseek (sf_count_t offset, int whence, void *user_data)
-{
-    if (((VFSFile *) user_data)->fseek (offset, to_vfs_seek_type (whence)) != 0)
-        return -1;
-
-    return ((VFSFile *) user_data)->ftell ();
-}
-
-static sf_count_t
-sf_vseek_dummy (sf_count_t offset, int whence, void *user_data)
-{
-    return -1;
-}
-
-static sf_count_t
-sf_vread (void *ptr, sf_count_t count, void *user_data)
-{
-    return ((VFSFile *) user_data)->fread (ptr, 1, count);
-}
-
-static sf_count_t
-sf_vwrite_dummy (const void *ptr, sf_count_t count, void *user_data)
-{
-    return 0;
-}
-
-static sf_count_t
-sf_tell (void *user_data)
-{
-    return ((VFSFile *) user_data)->ftell ();
-}
-
-static SF_VIRTUAL_IO sf_virtual_io =
-{
-    sf_get_filelen,
-    sf_vseek,
-    sf_vread,
-    sf_vwrite_dummy,
-    sf_tell
-};
-
-static SF_VIRTUAL_IO sf_virtual_io_stream =
-{
-    sf_get_filelen,
-    sf_vseek_dummy,
-    sf_vread,
-    sf_vwrite_dummy,
-    sf_tell
-};
-
 static void copy_string (SNDFILE * sf, int sf_id, Tuple & tup, Tuple::Field field)
 {
     const char * str = sf_get_string (sf, sf_id);
@@ -133,8 +74,8 @@ bool SndfilePlugin::read_tag (const char * filename, VFSFile & file, Tuple & tup
     const char *format, *subformat;
 
     bool stream = (file.fsize () < 0);
-    SNDFILE * sndfile = sf_open_virtual (stream ? & sf_virtual_io_stream :
-     & sf_virtual_io, SFM_READ, & sfinfo, & file);
+    SNDFILE * sndfile = sf_open_virtual (stream ? & vfs_sndfile_io_stream :
+     & vfs_sndfile_io, SFM_READ, & sfinfo, & file);
 
     if (! sndfile)
         return false;
@@ -317,8 +258,8 @@ bool SndfilePlugin::play (const char * filename, VFSFile & file)
     SF_INFO sfinfo {}; // must be zeroed before sf_open()
 
     bool stream = (file.fsize () < 0);
-    SNDFILE * sndfile = sf_open_virtual (stream ? & sf_virtual_io_stream :
-     & sf_virtual_io, SFM_READ, & sfinfo, & file);
+    SNDFILE * sndfile = sf_open_virtual (stream ? & vfs_sndfile_io_stream :
+     & vfs_sndfile_io, SFM_READ, & sfinfo, & file);
 
     if (sndfile == nullptr)
         return false;
@@ -355,8 +296,8 @@ bool SndfilePlugin::is_our_file (const char * filename, VFSFile & file)
 
     /* Have to open the file to see if libsndfile can handle it. */
     bool stream = (file.fsize () < 0);
-    SNDFILE * tmp_sndfile = sf_open_virtual (stream ? & sf_virtual_io_stream :
-     & sf_virtual_io, SFM_READ, & tmp_sfinfo, & file);
+    SNDFILE * tmp_sndfile = sf_open_virtual (stream ? & vfs_sndfile_io_stream :
+     & vfs_sndfile_io, SFM_READ, & tmp_sfinfo, & file);
 
     if (!tmp_sndfile)
         return false;
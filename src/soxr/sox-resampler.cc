@@ -28,6 +28,8 @@
 #include <libaudcore/plugin.h>
 #include <libaudcore/preferences.h>
 
+#include "../resample-common/adaptive.h"
+
 #define MIN_RATE 8000
 #define MAX_RATE 192000
 #define RATE_STEP 50
@@ -68,6 +70,8 @@ const char * const SoXResampler::defaults[] = {
     "allow_aliasing", "FALSE",
 #endif
     "use_steep_filter", "FALSE",
+    "adaptive", "FALSE",
+    "max_load", "25",
     nullptr
 };
 
@@ -80,12 +84,87 @@ static int stored_channels;
 static double ratio;
 static Index<audio_sample> buffer;
 
+/* The qualities in order of cost, for adaptive mode.  The configured quality is
+ * the highest that will be used. */
+static const int tier_qualities[] = {SOXR_QQ, SOXR_LQ, SOXR_MQ, SOXR_HQ,
+ SOXR_VHQ, SOXR_32_BITQ};
+
+static const char * const tier_names[] = {"quick", "low", "medium", "high",
+ "very high", "ultra high"};
+
+static AdaptiveResampler * adaptive;
+static bool use_adaptive;
+
+/* worked out in start(), so that flush() does not have to look up the settings */
+static soxr_quality_spec_t tier_qspecs[aud::n_elements (tier_qualities)];
+
 #ifdef DEF_AUDIO_FLOAT64
     static const soxr_io_spec_t iospec = { SOXR_FLOAT64_I, SOXR_FLOAT64_I, 1.0, 0, 0 };
 #else
     static const soxr_io_spec_t iospec = { SOXR_FLOAT32_I, SOXR_FLOAT32_I, 1.0, 0, 0 };
 #endif
 
+static soxr_quality_spec_t make_qspec (int quality)
+{
+    int recipe = quality;
+    recipe |= aud_get_int ("soxr", "phase_response");
+    recipe |= (aud_get_bool ("soxr", "use_steep_filter")) ? SOXR_STEEP_FILTER : 0;
+#ifdef SOXR_ALLOW_ALIASING
+    recipe |= (aud_get_bool ("soxr", "allow_aliasing")) ? SOXR_ALLOW_ALIASING : 0;
+#endif
+
+    return soxr_quality_spec (recipe, 0);
+}
+
+/* One soxr converter, for adaptive mode */
+class SoXConverter : public TierConverter
+{
+public:
+    SoXConverter (soxr_t soxr) : m_soxr (soxr) {}
+    ~SoXConverter ()
+        { soxr_delete (m_soxr); }
+
+    bool convert (const audio_sample * in, int frames,
+     Index<audio_sample> & out, bool last)
+    {
+        int old_len = out.len ();
+        out.resize (old_len + (int) (frames * stored_channels * ratio) + 256);
+
+        size_t samples_done;
+        soxr_error_t error = soxr_process (m_soxr, in, frames, nullptr,
+         out.begin () + old_len, (out.len () - old_len) / stored_channels, & samples_done);
+
+        if (error)
+        {
+            AUDERR ("%s\n", error);
+            out.resize (old_len);
+            return false;
+        }
+
+        out.resize (old_len + samples_done * stored_channels);
+        return true;
+    }
+
+private:
+    soxr_t m_soxr;
+};
+
+static TierConverter * create_tier (int tier, void *)
+{
+    soxr_error_t error;
+    soxr_t soxr = soxr_create (stored_rate, target_rate, stored_channels,
+     & error, & iospec, & tier_qspecs[tier], nullptr);
+
+    if (error)
+    {
+        AUDERR ("%s\n", error);
+        soxr_delete (soxr);
+        return nullptr;
+    }
+
+    return new SoXConverter (soxr);
+}
+
 bool SoXResampler::init ()
 {
     aud_config_set_defaults ("soxr", defaults);
@@ -96,6 +175,9 @@ void SoXResampler::cleanup ()
 {
     soxr_delete (soxr);
     soxr = 0;
+    use_adaptive = false;
+    delete adaptive;
+    adaptive = nullptr;
     buffer.clear ();
 }
 
@@ -103,6 +185,7 @@ void SoXResampler::start (int & channels, int & rate)
 {
     soxr_delete (soxr);
     soxr = 0;
+    use_adaptive = false;
 
     target_rate = aud_get_int ("soxr", "rate");
     target_rate = aud::clamp (target_rate, MIN_RATE, MAX_RATE);
@@ -111,15 +194,41 @@ void SoXResampler::start (int & channels, int & rate)
         return;
 
     stored_rate = rate;
+    stored_channels = channels;
+    ratio = (double) target_rate / rate;
 
-    int recipe = aud_get_int ("soxr", "quality");
-    recipe |= aud_get_int ("soxr", "phase_response");
-    recipe |= (aud_get_bool ("soxr", "use_steep_filter")) ? SOXR_STEEP_FILTER : 0;
-#ifdef SOXR_ALLOW_ALIASING
-    recipe |= (aud_get_bool ("soxr", "allow_aliasing")) ? SOXR_ALLOW_ALIASING : 0;
-#endif
+    int quality = aud_get_int ("soxr", "quality");
+
+    if (aud_get_bool ("soxr", "adaptive"))
+    {
+        int max_tier = 0;
+        while (max_tier < aud::n_elements (tier_qualities) - 1 &&
+         tier_qualities[max_tier] != quality)
+            max_tier ++;
 
-    qspec = soxr_quality_spec (recipe, 0);
+        float max_load = aud_get_int ("soxr", "max_load") / 100.0f;
+
+        for (int tier = 0; tier <= max_tier; tier ++)
+            tier_qspecs[tier] = make_qspec (tier_qualities[tier]);
+
+        /* kept from song to song, see AdaptiveResampler::start() */
+        if (! adaptive)
+            adaptive = new AdaptiveResampler;
+
+        if (adaptive->start (channels, rate, ratio, max_tier, max_load,
+         tier_names, create_tier, nullptr))
+        {
+            use_adaptive = true;
+            rate = target_rate;
+        }
+
+        return;
+    }
+
+    delete adaptive;
+    adaptive = nullptr;
+
+    qspec = make_qspec (quality);
 
     soxr = soxr_create (rate, target_rate, channels, & error, & iospec, & qspec, nullptr);
 
@@ -129,13 +238,21 @@ void SoXResampler::start (int & channels, int & rate)
         return;
     }
 
-    stored_channels = channels;
-    ratio = (double) target_rate / rate;
     rate = target_rate;
 }
 
 Index<audio_sample> & SoXResampler::process (Index<audio_sample> & data)
 {
+    if (use_adaptive)
+    {
+        buffer.resize (0);
+
+        if (! adaptive->process (data.begin (), data.len () / stored_channels, buffer, false))
+            return data;
+
+        return buffer;
+    }
+
     if (! soxr)
          return data;
 
@@ -158,6 +275,12 @@ Index<audio_sample> & SoXResampler::process (Index<audio_sample> & data)
 
 bool SoXResampler::flush (bool force)
 {
+    if (use_adaptive)
+    {
+        adaptive->flush ();
+        return true;
+    }
+
     if (! soxr)
         return true;
 
@@ -208,7 +331,13 @@ const PreferencesWidget SoXResampler::widgets[] = {
     WidgetCheck (N_("Use steep filter"), WidgetBool ("soxr", "use_steep_filter")),
     WidgetSpin (N_("Rate:"),
         WidgetInt ("soxr", "rate"),
-        {MIN_RATE, MAX_RATE, RATE_STEP, N_("Hz")})
+        {MIN_RATE, MAX_RATE, RATE_STEP, N_("Hz")}),
+    WidgetCheck (N_("Lower quality when CPU load is high"),
+        WidgetBool ("soxr", "adaptive")),
+    WidgetSpin (N_("Maximum load:"),
+        WidgetInt ("soxr", "max_load"),
+        {1, 100, 1, "%"},
+        WIDGET_CHILD)
 };
 
 const PluginPreferences SoXResampler::prefs = {{widgets}};
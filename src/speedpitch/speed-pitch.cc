@@ -35,6 +35,22 @@
 #define FREQ    10
 #define OVERLAP  3
 
+/* The high quality method (WSOLA, waveform-similarity overlap-add) uses shorter
+ * windows with less overlap, and moves each piece up to SEEK_TIME forward or
+ * back so that it lines up with the audio that would have followed the previous
+ * piece.  This avoids the phasiness of plain overlap-add, especially with
+ * speech.  The search is first done on a decimated mono mix, then refined. */
+
+#define WSOLA_FREQ     40
+#define WSOLA_OVERLAP   2
+#define SEEK_TIME   0.012 /* seconds */
+#define DECIMATE        4
+
+enum {
+    METHOD_FAST,
+    METHOD_WSOLA
+};
+
 #define CFGSECT "speed-pitch"
 #define MINSPEED 0.25
 #define MAXSPEED 2.0
@@ -85,8 +101,20 @@ static Index<float> cosine;
 static Index<audio_sample> in, out;
 static int src, dst;
 
+static bool wsola;
+static int seek;       /* search range, in samples */
+static int prev = -1;  /* center of the last window copied, or -1 */
+static Index<float> ref, region, ref_dec, region_dec;
+
 static void add_data (Index<audio_sample> & b_out, Index<audio_sample> & data, float ratio)
 {
+    /* nothing to resample (the usual case when only the speed is changed) */
+    if (ratio == 1)
+    {
+        b_out.insert (data.begin (), -1, data.len ());
+        return;
+    }
+
     int oldlen = b_out.len ();
     int inframes = data.len () / curchans;
     int maxframes = (int) (inframes * ratio) + 256;
@@ -123,7 +151,6 @@ static void add_data (Index<audio_sample> & b_out, Index<audio_sample> & data, f
     src_process (srcstate, & srcd);
 
 #ifdef DEF_AUDIO_FLOAT64
-    floatbuf_in.resize (0);
     b_out.resize (oldlen + srcd.output_frames_gen * curchans);
     float * ain = floatbuf_out.begin ();
     audio_sample * aout = & b_out[oldlen];
@@ -132,7 +159,6 @@ static void add_data (Index<audio_sample> & b_out, Index<audio_sample> & data, f
     {
         *(aout++) = *(ain++);
     }
-    floatbuf_out.resize (0);
 #else
     b_out.resize (oldlen + srcd.output_frames_gen * curchans);
 #endif
@@ -148,6 +174,7 @@ bool SpeedPitch::flush (bool force)
     /* The source and destination pointers give the center of the next cosine
      * window to be copied, relative to the current input and output buffers. */
     src = dst = 0;
+    prev = -1;
 
     /* The output buffer always extends right of the destination pointer by half
      * the width of a cosine window. */
@@ -169,18 +196,109 @@ void SpeedPitch::start (int & chans, int & rate)
     /* Calculate the width of the cosine window and the spacing interval for
      * output.  Make them both even numbers for convenience.  Note that the
      * cosine window is applied without deinterleaving the audio samples. */
-    outstep = ((currate / FREQ) & ~1) * curchans;
-    width = outstep * OVERLAP;
+    wsola = (aud_get_int (CFGSECT, "method") == METHOD_WSOLA);
+
+    int freq = wsola ? WSOLA_FREQ : FREQ;
+    int overlap = wsola ? WSOLA_OVERLAP : OVERLAP;
+
+    outstep = ((currate / freq) & ~1) * curchans;
+    width = outstep * overlap;
+    seek = (int) (currate * SEEK_TIME) * curchans;
 
     /* Generate the cosine window, scaled vertically to compensate for the
      * overlap of the reassembled pieces of audio. */
     cosine.resize (width);
     for (int i = 0; i < width; i ++)
-        cosine[i] = (1.0 - cos (2.0 * M_PI * i / width)) / OVERLAP;
+        cosine[i] = (1.0 - cos (2.0 * M_PI * i / width)) / overlap;
 
     flush (true);
 }
 
+/* Mixes <frames> frames starting at <from> down to mono, and also keeps every
+ * DECIMATE-th value for the coarse search. */
+static void mixdown (const audio_sample * from, int frames, Index<float> & mono, Index<float> & dec)
+{
+    mono.resize (frames);
+    dec.resize (frames / DECIMATE);
+
+    for (int f = 0; f < frames; f ++)
+    {
+        float sum = 0;
+        for (int c = 0; c < curchans; c ++)
+            sum += from[c];
+
+        mono[f] = sum;
+        from += curchans;
+    }
+
+    for (int f = 0; f < dec.len (); f ++)
+        dec[f] = mono[f * DECIMATE];
+}
+
+/* Plain loops, which the compiler vectorizes. */
+static float similarity (const float * a, const float * b, int len)
+{
+    float dot = 0, energy = 0;
+
+    for (int i = 0; i < len; i ++)
+    {
+        dot += a[i] * b[i];
+        energy += b[i] * b[i];
+    }
+
+    return dot / sqrtf (energy + 1e-9f);
+}
+
+/* Returns the center of the window near <target> whose first part best matches
+ * the audio at <natural>, the continuation of the previous window. */
+static int find_best (int target, int natural)
+{
+    int half = width / 2;
+    int len = width - outstep;  /* the part that overlaps the previous window */
+
+    int lo = aud::max (-seek, half - target);
+    int hi = aud::min (seek, in.len () - len - (target - half));
+
+    if (lo > hi)
+        return target;
+
+    int ref_frames = len / curchans;
+    int candidates = (hi - lo) / curchans + 1;
+
+    mixdown (& in[natural - half], ref_frames, ref, ref_dec);
+    mixdown (& in[target + lo - half], ref_frames + candidates - 1, region, region_dec);
+
+    int best = 0;
+    float best_score = -INFINITY;
+
+    for (int d = 0; d < candidates; d += DECIMATE)
+    {
+        float score = similarity (ref_dec.begin (), & region_dec[d / DECIMATE], ref_dec.len ());
+        if (score > best_score)
+        {
+            best = d;
+            best_score = score;
+        }
+    }
+
+    int first = aud::max (0, best - DECIMATE + 1);
+    int last = aud::min (candidates - 1, best + DECIMATE - 1);
+
+    best_score = -INFINITY;
+
+    for (int d = first; d <= last; d ++)
+    {
+        float score = similarity (ref.begin (), & region[d], ref_frames);
+        if (score > best_score)
+        {
+            best = d;
+            best_score = score;
+        }
+    }
+
+    return target + lo + best * curchans;
+}
+
 Index<audio_sample> & SpeedPitch::process (Index<audio_sample> & data, bool ending)
 {
     const float * cosine_center = & cosine[width / 2];
@@ -200,18 +318,24 @@ Index<audio_sample> & SpeedPitch::process (Index<audio_sample> & data, bool endi
     int instep = (int) round ((outstep / curchans) * speed / pitch) * curchans;
 
     /* Stop copying half a window's width before the end of the input buffer (or
-     * right up to the end of the buffer if the song is ending). */
-    int stop = in.len () - (ending ? 0 : width / 2);
+     * right up to the end of the buffer if the song is ending).  Leave room for
+     * the search, too. */
+    int stop = in.len () - (ending ? 0 : width / 2 + (wsola ? seek : 0));
 
     while (src <= stop)
     {
+        int pos = src;
+        if (wsola && prev >= 0 && ! ending)
+            pos = find_best (src, prev + outstep);
+
         /* Truncate the window to avoid overflows if necessary. */
-        int begin = aud::max (-(width / 2), aud::max (-src, -dst));
-        int end = aud::min (width / 2, aud::min (in.len () - src, out.len () - dst));
+        int begin = aud::max (-(width / 2), aud::max (-pos, -dst));
+        int end = aud::min (width / 2, aud::min (in.len () - pos, out.len () - dst));
 
         for (int i = begin; i < end; i ++)
-            out[dst + i] += in[src + i] * cosine_center[i];
+            out[dst + i] += in[pos + i] * cosine_center[i];
 
+        prev = pos;
         src += instep;
         dst += outstep;
 
@@ -220,9 +344,23 @@ Index<audio_sample> & SpeedPitch::process (Index<audio_sample> & data, bool endi
 
     /* Discard input up to half a window's width before the source pointer (or
      * right up to the previous source pointer if the song is ending. */
-    int seek = aud::clamp (0, src - (ending ? instep : width / 2), in.len ());
-    in.remove (0, seek);
-    src -= seek;
+    int keep = src - (ending ? instep : width / 2);
+
+    /* WSOLA also looks back up to the search range, and at the continuation of
+     * the last window */
+    if (wsola && ! ending)
+    {
+        keep -= seek;
+        if (prev >= 0)
+            keep = aud::min (keep, prev + outstep - width / 2);
+    }
+
+    int cut = aud::clamp (0, keep, in.len ());
+    in.remove (0, cut);
+    src -= cut;
+
+    if (prev >= 0)
+        prev -= cut;
 
     data.resize (0);
 
@@ -275,8 +413,14 @@ const char * const SpeedPitch::defaults[] = {
  "decouple", "TRUE",
  "speed", "1",
  "pitch", "1",
+ "method", "0",
  nullptr};
 
+static const ComboItem method_items[] = {
+    ComboItem (N_("Fast"), METHOD_FAST),
+    ComboItem (N_("High quality (WSOLA)"), METHOD_WSOLA)
+};
+
 const PreferencesWidget SpeedPitch::widgets[] = {
     WidgetLabel (N_("<b>Speed</b>")),
     WidgetCheck (N_("Decouple from pitch"),
@@ -292,7 +436,11 @@ const PreferencesWidget SpeedPitch::widgets[] = {
     WidgetSpin (N_("Multiplier:"),
         WidgetFloat (CFGSECT, "pitch", pitch_changed, "speed-pitch set pitch"),
         {MINPITCH, MAXPITCH, 0.005},
-        WIDGET_CHILD)
+        WIDGET_CHILD),
+    WidgetLabel (N_("<b>Quality</b>")),
+    WidgetCombo (N_("Time stretching:"),
+        WidgetInt (CFGSECT, "method"),
+        {{method_items}})
 };
 
 const PluginPreferences SpeedPitch::prefs = {{widgets}};
@@ -314,4 +462,8 @@ void SpeedPitch::cleanup ()
     cosine.clear ();
     in.clear ();
     out.clear ();
+    ref.clear ();
+    region.clear ();
+    ref_dec.clear ();
+    region_dec.clear ();
 }
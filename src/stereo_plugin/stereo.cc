@@ -7,6 +7,12 @@
 #include <libaudcore/plugin.h>
 #include <libaudcore/preferences.h>
 
+#include "../effect-common/params.h"
+#include "../effect-common/smoothing.h"
+
+#define SMOOTH_TIME 0.05f /* seconds */
+#define CHUNK 256         /* frames */
+
 class ExtraStereo : public EffectPlugin
 {
 public:
@@ -25,6 +31,7 @@ public:
     constexpr ExtraStereo () : EffectPlugin (info, 0, true) {}
 
     bool init ();
+    void cleanup ();
 
     void start (int & channels, int & rate);
     Index<audio_sample> & process (Index<audio_sample> & data);
@@ -40,44 +47,78 @@ const char * const ExtraStereo::defaults[] = {
  "intensity", "2.5",
  nullptr};
 
+static void settings_changed ()
+{
+    effect_settings_changed ("extra_stereo");
+}
+
 const PreferencesWidget ExtraStereo::widgets[] = {
     WidgetLabel (N_("<b>Extra Stereo</b>")),
     WidgetSpin (N_("Intensity:"),
-        WidgetFloat ("extra_stereo", "intensity"),
+        WidgetFloat ("extra_stereo", "intensity", settings_changed),
         {0, 10, 0.1})
 };
 
 const PluginPreferences ExtraStereo::prefs = {{widgets}};
 
+static void read_intensity (float & intensity)
+{
+    intensity = aud_get_double ("extra_stereo", "intensity");
+}
+
+static EffectParams<float> stereo_params (read_intensity);
+static LinearSmoother stereo_intensity;
+
 bool ExtraStereo::init ()
 {
     aud_config_set_defaults ("extra_stereo", defaults);
+    stereo_params.update ();
+    stereo_params.watch ("extra_stereo");
     return true;
 }
 
+void ExtraStereo::cleanup ()
+{
+    stereo_params.unwatch ("extra_stereo");
+}
+
 static int stereo_channels;
 
 void ExtraStereo::start (int & channels, int & rate)
 {
     stereo_channels = channels;
+
+    stereo_intensity.setup (SMOOTH_TIME, rate);
+    stereo_intensity.reset (stereo_params.get ());
 }
 
 Index<audio_sample> & ExtraStereo::process(Index<audio_sample> & data)
 {
-    audio_sample value = aud_get_double ("extra_stereo", "intensity");
-    audio_sample * f, * end;
+    audio_sample * f;
     audio_sample center;
+    float value[CHUNK];
 
     if (stereo_channels != 2)
         return data;
 
-    end = data.end ();
+    stereo_intensity.set_target (stereo_params.get ());
+
+    f = data.begin ();
+    int frames = data.len () / 2;
 
-    for (f = data.begin (); f < end; f += 2)
+    while (frames)
     {
-        center = (f[0] + f[1]) / 2;
-        f[0] = center + (f[0] - center) * value;
-        f[1] = center + (f[1] - center) * value;
+        int chunk = aud::min (frames, CHUNK);
+        stereo_intensity.fill (value, chunk);
+
+        for (int i = 0; i < chunk; i ++, f += 2)
+        {
+            center = (f[0] + f[1]) / 2;
+            f[0] = center + (f[0] - center) * value[i];
+            f[1] = center + (f[1] - center) * value[i];
+        }
+
+        frames -= chunk;
     }
 
     return data;
@@ -85,6 +85,19 @@ static void insert_int_tuple_field_to_dictionary (const Tuple & tuple,
         dict.remove (String (key));
 }
 
+/* The dictionary starts out with the comments already in the file; a key the
+ * tuple has no value for keeps whatever was stored there. */
+static void insert_gain_tuple_field_to_dictionary (const Tuple & tuple,
+ Tuple::Field field, Tuple::Field divisor_field, Dictionary & dict,
+ const char * format, const char * key)
+{
+    int divisor = tuple.get_int (divisor_field);
+
+    if (tuple.get_value_type (field) == Tuple::Int && divisor > 0)
+        dict.add (String (key), String (str_printf (format,
+         (double) tuple.get_int (field) / divisor)));
+}
+
 bool VorbisPlugin::write_tuple (const char * filename, VFSFile & file, const Tuple & tuple)
 {
     VCEdit edit;
@@ -109,6 +122,15 @@ bool VorbisPlugin::write_tuple (const char * filename, VFSFile & file, const Tup
     insert_str_tuple_field_to_dictionary (tuple, Tuple::Publisher, dict, "publisher");
     insert_str_tuple_field_to_dictionary (tuple, Tuple::CatalogNum, dict, "CATALOGNUMBER");
 
+    insert_gain_tuple_field_to_dictionary (tuple, Tuple::TrackGain, Tuple::GainDivisor,
+     dict, "%+.2f dB", "REPLAYGAIN_TRACK_GAIN");
+    insert_gain_tuple_field_to_dictionary (tuple, Tuple::TrackPeak, Tuple::PeakDivisor,
+     dict, "%.6f", "REPLAYGAIN_TRACK_PEAK");
+    insert_gain_tuple_field_to_dictionary (tuple, Tuple::AlbumGain, Tuple::GainDivisor,
+     dict, "%+.2f dB", "REPLAYGAIN_ALBUM_GAIN");
+    insert_gain_tuple_field_to_dictionary (tuple, Tuple::AlbumPeak, Tuple::PeakDivisor,
+     dict, "%.6f", "REPLAYGAIN_ALBUM_PEAK");
+
     dictionary_to_vorbis_comment (& edit.vc, dict);
 
     auto temp_vfs = VFSFile::tmpfile ();
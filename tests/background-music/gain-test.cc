@@ -0,0 +1,174 @@
+/*
+ * Test of the Background Music plugin's reduced look-ahead
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Runs a minute of stereo audio with level steps and transients, in blocks of
+ * random size, through the plugin and through the implementation it replaced
+ * (kept in reference/), and compares the gain curves.  With the default
+ * look-ahead the output must be the same sample for sample; with a shorter one
+ * the gain may differ from the reference by no more than a set amount on
+ * average, and the added latency must stay under 50 ms.  The integrators are
+ * not reset on a flush, so every run gets a new plugin.  The bounds were
+ * measured with the rand () of the GNU C library. */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <libaudcore/runtime.h>
+
+#include "../../src/background_music/FrameBasedEffectPlugin.h"
+#include "../../src/loudness-common/loudness.cc"
+
+namespace reference {
+#include "reference/FrameBasedEffectPlugin.h"
+}
+
+#define CHANNELS 2
+#define RATE 44100
+#define SECONDS 60
+
+static const PluginInfo info = {"Background Music", "", nullptr, nullptr};
+
+static Index<audio_sample> make_input ()
+{
+    srand (1);
+
+    Index<audio_sample> in;
+    in.insert (0, RATE * SECONDS * CHANNELS);
+
+    double level = 0.1, phase = 0;
+
+    for (int i = 0; i < RATE * SECONDS; i ++)
+    {
+        /* a new level every half second, with a short burst at the start of
+         * every quarter second */
+        if (i % (RATE / 2) == 0)
+            level = pow (10, -(rand () % 40) / 20.0);
+
+        double env = (i % (RATE / 4) < 300) ? 3.0 : 1.0;
+        phase += 2 * M_PI * (220 + 200 * sin (i * 1e-4)) / RATE;
+
+        for (int c = 0; c < CHANNELS; c ++)
+            in[i * CHANNELS + c] = level * env * (0.5 * sin (phase + c) + 0.2 * (rand () / (double) RAND_MAX - 0.5));
+    }
+
+    return in;
+}
+
+/* the output is delayed within the stream, so frame i of it belongs to frame
+ * i of the input */
+template<class Plugin>
+static Index<audio_sample> run (Plugin & plugin, const Index<audio_sample> & in,
+ int & latency_ms)
+{
+    srand (2);
+    Index<audio_sample> out;
+
+    int channels = CHANNELS, rate = RATE;
+    plugin.init ();
+    plugin.start (channels, rate);
+
+    for (int pos = 0; pos < in.len (); )
+    {
+        int len = aud::min ((64 + rand () % 2048) * CHANNELS, in.len () - pos);
+
+        Index<audio_sample> block;
+        block.insert (& in[pos], 0, len);
+
+        Index<audio_sample> & result = plugin.process (block);
+        out.insert (result.begin (), -1, result.len ());
+        pos += len;
+    }
+
+    latency_ms = plugin.adjust_delay (0);
+    plugin.cleanup ();
+
+    return out;
+}
+
+/* mean difference between the gains of two outputs, in dB, over the first
+ * channel where the input is not too quiet to tell */
+static double gain_difference (const Index<audio_sample> & in,
+ const Index<audio_sample> & a, const Index<audio_sample> & b)
+{
+    double sum = 0;
+    int count = 0;
+
+    for (int i = 0; i < aud::min (a.len (), b.len ()); i += CHANNELS)
+    {
+        if (fabsf (in[i]) < 1e-3f || ! a[i] || ! b[i])
+            continue;
+
+        sum += fabs (20 * log10 (fabs (a[i] / b[i])));
+        count ++;
+    }
+
+    return count ? sum / count : 0;
+}
+
+int main ()
+{
+    static const struct {
+        int look_ahead; /* ms */
+        double max_difference; /* dB, to two decimal places */
+    } cases[] = {
+        {20, 0.04},
+        {10, 0.10},
+        {5, 0.22}
+    };
+
+    Index<audio_sample> in = make_input ();
+    bool failed = false;
+    int latency;
+
+    reference::FrameBasedEffectPlugin old_plugin (info, 10);
+    Index<audio_sample> old_out = run (old_plugin, in, latency);
+
+    aud_set_double (CONFIG_SECTION_BACKGROUND_MUSIC, CONF_LOOK_AHEAD_VARIABLE, 30);
+    FrameBasedEffectPlugin plugin (info, 10);
+    Index<audio_sample> out = run (plugin, in, latency);
+
+    bool same = (out.len () == old_out.len ());
+    for (int i = 0; same && i < out.len (); i ++)
+        same = (out[i] == old_out[i]);
+
+    printf ("30 ms look-ahead: %s the reference, %d ms latency\n",
+     same ? "same as" : "DIFFERENT from", latency);
+
+    failed |= ! same;
+
+    for (auto & test : cases)
+    {
+        aud_set_double (CONFIG_SECTION_BACKGROUND_MUSIC, CONF_LOOK_AHEAD_VARIABLE, test.look_ahead);
+        FrameBasedEffectPlugin plugin (info, 10);
+        out = run (plugin, in, latency);
+
+        double difference = gain_difference (in, out, old_out);
+        bool ok = (round (difference * 100) <= round (test.max_difference * 100) &&
+         latency < 50);
+
+        printf ("%d ms look-ahead: gain differs by %.3f dB on average (at most "
+         "%.2f), %d ms latency%s\n", test.look_ahead, difference,
+         test.max_difference, latency, ok ? "" : " - FAILED");
+
+        failed |= ! ok;
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,124 @@
+/*
+ * Benchmark for the Crossfade plugin
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Plays ten minutes of stereo noise, as ten songs that alternate between 44.1
+ * and 48 kHz, through the plugin in blocks of 512 frames, so that every song
+ * change goes through the fade, the ramps and the format conversion.  Reports
+ * the time taken per frame and whether the crossfade buffer had to grow after
+ * the first song change.  The plugin is built in as in the Simple DSP Chain
+ * test. */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+
+#include <libaudcore/runtime.h>
+
+#include "../../src/crossfade/convert.cc"
+#include "../../src/crossfade/crossfade.cc"
+#include "../../src/crossfade/ramp.cc"
+
+#define CHANNELS 2
+#define SONGS 10
+#define SONG_SECONDS 60
+#define BLOCK 512 /* frames */
+
+static Index<audio_sample> noise;
+
+/* returns the number of frames played */
+static int64_t play_song (int rate, double & seconds)
+{
+    const int frames = rate * SONG_SECONDS;
+    int64_t out_frames = 0;
+
+    Index<audio_sample> block;
+    block.insert (0, BLOCK * CHANNELS);
+
+    auto begin = std::chrono::steady_clock::now ();
+
+    int channels = CHANNELS;
+    aud_plugin_instance.start (channels, rate);
+
+    for (int done = 0; done < frames; done += BLOCK)
+    {
+        int len = aud::min (BLOCK, frames - done) * CHANNELS;
+
+        block.resize (len);
+        memcpy (block.begin (), & noise[(done % 48000) * CHANNELS], len * sizeof (audio_sample));
+
+        Index<audio_sample> & out = (done + BLOCK < frames) ?
+         aud_plugin_instance.process (block) :
+         aud_plugin_instance.finish (block, false);
+
+        out_frames += out.len () / CHANNELS;
+    }
+
+    std::chrono::duration<double> time = std::chrono::steady_clock::now () - begin;
+    seconds += time.count ();
+
+    return out_frames;
+}
+
+int main ()
+{
+    /* one second at the higher rate, plus a block to run past the end of it */
+    std::mt19937 rng (1);
+    std::uniform_real_distribution<float> dist (-0.5, 0.5);
+
+    noise.insert (0, (48000 + BLOCK) * CHANNELS);
+    for (audio_sample & x : noise)
+        x = dist (rng);
+
+    aud_plugin_instance.init ();
+
+    printf ("%d songs of %d s, 44.1 and 48 kHz by turns, blocks of %d frames\n",
+     SONGS, SONG_SECONDS, BLOCK);
+
+    double seconds = 0;
+    int64_t in_frames = 0, out_frames = 0;
+    int settled_size = 0;
+
+    for (int song = 0; song < SONGS; song ++)
+    {
+        int rate = (song & 1) ? 48000 : 44100;
+
+        out_frames += play_song (rate, seconds);
+        in_frames += (int64_t) rate * SONG_SECONDS;
+
+        /* by the end of the second song, the buffer has held a fade into
+         * each of the two formats */
+        if (song == 1)
+            settled_size = buffer.size ();
+    }
+
+    Index<audio_sample> empty;
+    out_frames += aud_plugin_instance.finish (empty, true).len () / CHANNELS;
+
+    printf ("%.2f ns/frame, %.0fx realtime, %lld frames in, %lld out\n",
+     seconds * 1e9 / in_frames, SONGS * SONG_SECONDS / seconds,
+     (long long) in_frames, (long long) out_frames);
+    printf ("buffer: %d samples after two songs, %d at the end\n", settled_size,
+     buffer.size ());
+
+    aud_plugin_instance.cleanup ();
+
+    return 0;
+}
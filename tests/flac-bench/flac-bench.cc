@@ -0,0 +1,198 @@
+/*
+ * Decoding benchmark for the FLAC plugin
+ * Copyright 2026 Audacious developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* Encodes a minute of 16-bit stereo, 24-bit stereo and 24-bit 8-channel
+ * audio to temporary files, then decodes each file the way the plugin plays
+ * it (in batches, through its callbacks and conversion to floats) and
+ * reports how many times faster than real time that was.
+ *
+ * The plugin's sources are built into this program, as the effects are in
+ * the other tests. */
+
+#include <math.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <random>
+
+#include <libaudcore/runtime.h>
+#include <libaudcore/vfs.h>
+
+#include "../../src/flac/convert.cc"
+#include "../../src/flac/seekable_stream_callbacks.cc"
+#include "../../src/flac/seekindex.cc"
+#include "../../src/flac/tools.cc"
+
+#define RATE 48000
+#define SECONDS 60
+#define ENCODE_BLOCK 4096 /* frames */
+
+struct Format {
+    unsigned channels, bits;
+};
+
+static FLAC__StreamEncoderWriteStatus write_cb(const FLAC__StreamEncoder *,
+ const FLAC__byte buffer[], size_t bytes, unsigned, unsigned, void *data)
+{
+    VFSFile *file = (VFSFile *)data;
+
+    return (file->fwrite(buffer, 1, bytes) == (int64_t)bytes)
+     ? FLAC__STREAM_ENCODER_WRITE_STATUS_OK
+     : FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR;
+}
+
+/* A few tones per channel and some noise, so that the encoder has something
+ * like music to work with rather than pure noise or silence. */
+static bool encode(VFSFile &file, const Format &format)
+{
+    auto encoder = SmartPtr<FLAC__StreamEncoder, FLAC__stream_encoder_delete>
+     (FLAC__stream_encoder_new());
+
+    if (!encoder)
+        return false;
+
+    const uint64_t total = (uint64_t)RATE * SECONDS;
+
+    FLAC__stream_encoder_set_channels(encoder.get(), format.channels);
+    FLAC__stream_encoder_set_bits_per_sample(encoder.get(), format.bits);
+    FLAC__stream_encoder_set_sample_rate(encoder.get(), RATE);
+    FLAC__stream_encoder_set_compression_level(encoder.get(), 5);
+    FLAC__stream_encoder_set_total_samples_estimate(encoder.get(), total);
+
+    if (FLAC__stream_encoder_init_stream(encoder.get(), write_cb, nullptr,
+     nullptr, nullptr, &file) != FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+        return false;
+
+    std::mt19937 rng(1);
+    std::normal_distribution<double> noise(0, 0.01);
+
+    const double peak = (1 << (format.bits - 1)) - 1;
+    Index<FLAC__int32> block;
+    block.resize(ENCODE_BLOCK * format.channels);
+
+    for (uint64_t done = 0; done < total; done += ENCODE_BLOCK)
+    {
+        unsigned frames = aud::min<uint64_t>(ENCODE_BLOCK, total - done);
+
+        for (unsigned f = 0; f < frames; f++)
+        {
+            double t = (double)(done + f) / RATE;
+
+            for (unsigned c = 0; c < format.channels; c++)
+            {
+                double x = 0.3 * sin(2 * M_PI * (110 + 55 * c) * t) +
+                 0.2 * sin(2 * M_PI * (440 + 110 * c) * t) +
+                 0.1 * sin(2 * M_PI * 3520 * t) + noise(rng);
+
+                block[f * format.channels + c] = lrint(aud::clamp(x, -1.0, 1.0) * peak);
+            }
+        }
+
+        if (!FLAC__stream_encoder_process_interleaved(encoder.get(), block.begin(), frames))
+            return false;
+    }
+
+    return FLAC__stream_encoder_finish(encoder.get());
+}
+
+/* as FLACng::play() does it, with the batches thrown away */
+static bool decode(VFSFile &file, double &seconds)
+{
+    auto decoder = StreamDecoderPtr(FLAC__stream_decoder_new());
+    callback_info info;
+    info.fd = &file;
+
+    if (!decoder || FLAC__stream_decoder_init_stream(decoder.get(), read_callback,
+     seek_callback, tell_callback, length_callback, eof_callback, write_callback,
+     metadata_callback, error_callback, &info) != FLAC__STREAM_DECODER_INIT_STATUS_OK)
+        return false;
+
+    if (file.fseek(0, VFS_SEEK_SET) != 0)
+        return false;
+
+    auto begin = std::chrono::steady_clock::now();
+
+    if (!read_metadata(decoder.get(), &info))
+        return false;
+
+    info.alloc();
+    uint64_t decoded = 0;
+
+    while (FLAC__stream_decoder_get_state(decoder.get()) != FLAC__STREAM_DECODER_END_OF_STREAM)
+    {
+        while (info.buffer_used < BATCH_SIZE_SAMP * info.channels &&
+         FLAC__stream_decoder_get_state(decoder.get()) != FLAC__STREAM_DECODER_END_OF_STREAM)
+        {
+            if (!FLAC__stream_decoder_process_single(decoder.get()))
+                return false;
+        }
+
+        decoded += info.buffer_used / info.channels;
+        info.reset();
+    }
+
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - begin;
+    seconds = time.count();
+
+    return decoded == info.total_samples;
+}
+
+int main()
+{
+    static const Format formats[] = {
+        {2, 16},
+        {2, 24},
+        {8, 24}
+    };
+
+    printf("%d s at %d Hz, batches of %d frames\n", SECONDS, RATE, BATCH_SIZE_SAMP);
+
+    for (const Format &format : formats)
+    {
+        VFSFile file = VFSFile::tmpfile();
+
+        if (!file || !encode(file, format))
+        {
+            printf("Could not encode a test file.\n");
+            return 1;
+        }
+
+        /* the best of three runs, to leave out the odd interruption */
+        double best = 0;
+
+        for (int pass = 0; pass < 3; pass++)
+        {
+            double seconds;
+
+            if (!decode(file, seconds))
+            {
+                printf("Could not decode the test file.\n");
+                return 1;
+            }
+
+            if (!pass || seconds < best)
+                best = seconds;
+        }
+
+        printf("%u-bit, %u channels: %6.0fx realtime (%.1f MB)\n", format.bits,
+         format.channels, SECONDS / best, file.fsize() / 1e6);
+    }
+
+    return 0;
+}
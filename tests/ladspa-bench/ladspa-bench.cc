@@ -0,0 +1,245 @@
+/*
+ * Benchmark for the LADSPA Host
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Runs 60 seconds of noise through a chain of ten mono pass-through plugins,
+ * so that what is measured is the host's own overhead: the planar chain,
+ * with and without the worker threads, and for comparison the earlier way of
+ * running each plugin, which de-interleaved the block and interleaved it back
+ * once per plugin.  The effect and the workers are built into this program;
+ * the list of loaded plugins is set up here instead of by plugin.cc. */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+
+#include <libaudcore/preferences.h>
+#include <libaudcore/runtime.h>
+
+#include "../../src/ladspa/effect.cc"
+#include "../../src/ladspa/workers.cc"
+
+#define PLUGINS 10
+#define RATE 44100
+#define SECONDS 60
+#define BLOCK 2048 /* frames */
+
+/* what the effect needs from plugin.cc, without the plugin loading and the
+ * settings window */
+pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+Index<SmartPtr<LoadedPlugin>> loadeds;
+
+const char LADSPAHost::about[] = "";
+const PluginPreferences LADSPAHost::prefs = {};
+
+bool LADSPAHost::init ()
+    { return true; }
+void LADSPAHost::cleanup () {}
+
+static LADSPAHost host;
+
+/* the pass-through plugin, one input and one output port */
+struct PassThrough {
+    LADSPA_Data * ports[2];
+};
+
+static LADSPA_Handle pass_instantiate (const LADSPA_Descriptor *, unsigned long)
+    { return new PassThrough (); }
+static void pass_connect (LADSPA_Handle handle, unsigned long port, LADSPA_Data * data)
+    { ((PassThrough *) handle)->ports[port] = data; }
+static void pass_cleanup (LADSPA_Handle handle)
+    { delete (PassThrough *) handle; }
+
+static void pass_run (LADSPA_Handle handle, unsigned long frames)
+{
+    auto pass = (PassThrough *) handle;
+    if (pass->ports[1] != pass->ports[0])
+        memcpy (pass->ports[1], pass->ports[0], sizeof (LADSPA_Data) * frames);
+}
+
+static const LADSPA_PortDescriptor pass_ports[] = {
+    LADSPA_PORT_INPUT | LADSPA_PORT_AUDIO,
+    LADSPA_PORT_OUTPUT | LADSPA_PORT_AUDIO
+};
+
+static LADSPA_Descriptor pass_desc;
+static Index<audio_sample> noise;
+
+/* The chain as it was run before: each plugin copied the block into buffers of
+ * its own, one channel at a time, and copied its output back. */
+struct OldChain
+{
+    LADSPA_Handle handles[PLUGINS][8];
+    LADSPA_Data in[LADSPA_BUFLEN], out[LADSPA_BUFLEN];
+    int channels;
+
+    void start (int chans)
+    {
+        channels = chans;
+        for (auto & plugin : handles)
+        {
+            for (int c = 0; c < channels; c ++)
+            {
+                plugin[c] = pass_desc.instantiate (& pass_desc, RATE);
+                pass_desc.connect_port (plugin[c], 0, in);
+                pass_desc.connect_port (plugin[c], 1, out);
+            }
+        }
+    }
+
+    void stop ()
+    {
+        for (auto & plugin : handles)
+        {
+            for (int c = 0; c < channels; c ++)
+                pass_desc.cleanup (plugin[c]);
+        }
+    }
+
+    void process (Index<audio_sample> & data)
+    {
+        for (auto & plugin : handles)
+        {
+            audio_sample * block = data.begin ();
+            int samples = data.len ();
+
+            while (samples / channels > 0)
+            {
+                int frames = aud::min (samples / channels, LADSPA_BUFLEN);
+
+                for (int c = 0; c < channels; c ++)
+                {
+                    for (int f = 0; f < frames; f ++)
+                        in[f] = block[channels * f + c];
+
+                    pass_desc.run (plugin[c], frames);
+
+                    for (int f = 0; f < frames; f ++)
+                        block[channels * f + c] = out[f];
+                }
+
+                block += channels * frames;
+                samples -= channels * frames;
+            }
+        }
+    }
+};
+
+/* Runs <func> over the noise; returns the best of three runs in ns/frame. */
+template<class F>
+static double run (int channels, F func)
+{
+    const int frames = RATE * SECONDS;
+    double best = 0;
+
+    for (int pass = 0; pass < 3; pass ++)
+    {
+        Index<audio_sample> block;
+        block.insert (0, BLOCK * channels);
+
+        auto begin = std::chrono::steady_clock::now ();
+
+        for (int done = 0; done < frames; done += BLOCK)
+        {
+            int len = aud::min (BLOCK, frames - done) * channels;
+
+            block.resize (len);
+            memcpy (block.begin (), & noise[(done % RATE) * channels], len * sizeof (audio_sample));
+            func (block);
+        }
+
+        std::chrono::duration<double, std::nano> time =
+         std::chrono::steady_clock::now () - begin;
+
+        if (! pass || time.count () < best)
+            best = time.count ();
+    }
+
+    return best / frames;
+}
+
+int main ()
+{
+    static const int channel_counts[] = {2, 6};
+
+    pass_desc.Label = "pass";
+    pass_desc.Name = "Pass-through";
+    pass_desc.PortCount = aud::n_elements (pass_ports);
+    pass_desc.PortDescriptors = pass_ports;
+    pass_desc.instantiate = pass_instantiate;
+    pass_desc.connect_port = pass_connect;
+    pass_desc.run = pass_run;
+    pass_desc.cleanup = pass_cleanup;
+
+    PluginData plugin ("pass.so", pass_desc);
+    plugin.in_ports.append (0);
+    plugin.out_ports.append (1);
+
+    for (int i = 0; i < PLUGINS; i ++)
+        loadeds.append (SmartPtr<LoadedPlugin> (new LoadedPlugin (plugin)));
+
+    /* one second, plus a block to run past the end of it */
+    std::mt19937 rng (1);
+    std::uniform_real_distribution<float> dist (-1, 1);
+
+    noise.insert (0, (RATE + BLOCK) * 6);
+    for (audio_sample & x : noise)
+        x = dist (rng);
+
+    printf ("%d pass-through plugins, %d s at %d Hz, blocks of %d frames\n",
+     PLUGINS, SECONDS, RATE, BLOCK);
+
+    for (int channels : channel_counts)
+    {
+        OldChain old;
+        old.start (channels);
+
+        double old_ns = run (channels, [&] (Index<audio_sample> & data) { old.process (data); });
+
+        old.stop ();
+
+        double new_ns[2];
+
+        for (int threads = 0; threads < 2; threads ++)
+        {
+            aud_set_bool ("ladspa", "threads", threads);
+
+            int c = channels, r = RATE;
+            host.start (c, r);
+
+            new_ns[threads] = run (channels, [] (Index<audio_sample> & data)
+                { host.process (data); });
+
+            /* as in LADSPAHost::finish() at the end of a playlist */
+            pthread_mutex_lock (& mutex);
+            for (auto & loaded : loadeds)
+                shutdown_plugin_locked (* loaded);
+            pthread_mutex_unlock (& mutex);
+        }
+
+        printf ("%d channels: per plugin %6.2f, planar %6.2f, planar with "
+         "threads %6.2f ns/frame\n", channels, old_ns, new_ns[0], new_ns[1]);
+    }
+
+    workers_stop ();
+    loadeds.clear ();
+
+    return 0;
+}
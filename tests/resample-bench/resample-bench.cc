@@ -0,0 +1,195 @@
+/*
+ * Benchmark for the Sample Rate Converter plugin
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Converts 60 seconds of stereo noise from 44.1 to 48 kHz, in blocks of the
+ * size the core usually hands out, once through the plugin and once through
+ * the code it replaced (kept below), and reports the time taken and the bytes
+ * copied outside libsamplerate per frame.  The plugin is built in as in the
+ * Simple DSP Chain test. */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+
+#include <libaudcore/audstrings.h>
+#include <libaudcore/runtime.h>
+
+#include "../../src/resample-common/adaptive.cc"
+#include "../../src/resample/resample.cc"
+
+#define CHANNELS 2
+#define IN_RATE 44100
+#define OUT_RATE 48000
+#define SECONDS 60
+#define BLOCK 2048 /* frames */
+
+static Index<audio_sample> noise;
+
+/* The earlier Resampler::resample(), less the error handling.  In the double
+ * build, it copied the audio to and from float buffers on every call. */
+struct OldResampler
+{
+    SRC_STATE * state;
+    double ratio = (double) OUT_RATE / IN_RATE;
+    Index<audio_sample> outbuffer;
+    int64_t copied = 0;
+
+    Index<audio_sample> & resample (Index<audio_sample> & data)
+    {
+#ifdef DEF_AUDIO_FLOAT64
+        static Index<float> floatbuf_in;
+        floatbuf_in.resize (data.len ());
+        for (int i = 0; i < data.len (); i ++)
+            floatbuf_in[i] = data[i];
+
+        copied += data.len () * (sizeof (audio_sample) + sizeof (float));
+
+        static Index<float> floatbuf_out;
+        floatbuf_out.resize ((int) (data.len () * ratio) + 256);
+
+        SRC_DATA srcd = SRC_DATA ();
+        srcd.data_in = floatbuf_in.begin ();
+        srcd.data_out = floatbuf_out.begin ();
+        srcd.output_frames = floatbuf_out.len () / CHANNELS;
+#else
+        outbuffer.resize ((int) (data.len () * ratio) + 256);
+
+        SRC_DATA srcd = SRC_DATA ();
+        srcd.data_in = data.begin ();
+        srcd.data_out = outbuffer.begin ();
+        srcd.output_frames = outbuffer.len () / CHANNELS;
+#endif
+
+        srcd.input_frames = data.len () / CHANNELS;
+        srcd.src_ratio = ratio;
+
+        src_process (state, & srcd);
+
+#ifdef DEF_AUDIO_FLOAT64
+        floatbuf_in.resize (0);
+        outbuffer.resize (CHANNELS * srcd.output_frames_gen);
+        for (int i = 0; i < outbuffer.len (); i ++)
+            outbuffer[i] = floatbuf_out[i];
+
+        copied += outbuffer.len () * (sizeof (audio_sample) + sizeof (float));
+        floatbuf_out.resize (0);
+#else
+        outbuffer.resize (CHANNELS * srcd.output_frames_gen);
+#endif
+
+        return outbuffer;
+    }
+};
+
+/* Runs <func> over the noise; returns the best of three runs in ns/frame. */
+template<class F>
+static double run (F func)
+{
+    const int frames = IN_RATE * SECONDS;
+    double best = 0;
+
+    for (int pass = 0; pass < 3; pass ++)
+    {
+        Index<audio_sample> block;
+        block.insert (0, BLOCK * CHANNELS);
+
+        auto begin = std::chrono::steady_clock::now ();
+
+        for (int done = 0; done < frames; done += BLOCK)
+        {
+            int len = aud::min (BLOCK, frames - done) * CHANNELS;
+
+            block.resize (len);
+            memcpy (block.begin (), & noise[(done % IN_RATE) * CHANNELS], len * sizeof (audio_sample));
+            func (block);
+        }
+
+        std::chrono::duration<double, std::nano> time =
+         std::chrono::steady_clock::now () - begin;
+
+        if (! pass || time.count () < best)
+            best = time.count ();
+    }
+
+    return best / frames;
+}
+
+int main ()
+{
+    /* one second, plus a block to run past the end of it */
+    std::mt19937 rng (1);
+    std::uniform_real_distribution<float> dist (-1, 1);
+
+    noise.insert (0, (IN_RATE + BLOCK) * CHANNELS);
+    for (audio_sample & x : noise)
+        x = dist (rng);
+
+    aud_plugin_instance.init ();
+    aud_set_int ("resample", "default-rate", OUT_RATE);
+    aud_set_bool ("resample", "use-mappings", false);
+    aud_set_bool ("resample", "adaptive", false);
+
+    printf ("%d channels, %d s from %d to %d Hz, blocks of %d frames\n",
+     CHANNELS, SECONDS, IN_RATE, OUT_RATE, BLOCK);
+
+    static const struct {
+        int method;
+        const char * name;
+    } methods[] = {
+        {SRC_LINEAR, "linear"},
+        {SRC_SINC_FASTEST, "fast sinc"}
+    };
+
+    for (auto & method : methods)
+    {
+        int error;
+        OldResampler old;
+        old.state = src_new (method.method, CHANNELS, & error);
+
+        double old_ns = run ([&] (Index<audio_sample> & data) { old.resample (data); });
+        double old_bytes = (double) old.copied / (3 * IN_RATE * SECONDS);
+
+        src_delete (old.state);
+
+        aud_set_int ("resample", "method", method.method);
+
+        int channels = CHANNELS, rate = IN_RATE;
+        aud_plugin_instance.start (channels, rate);
+
+        double new_ns = run ([] (Index<audio_sample> & data)
+            { aud_plugin_instance.process (data); });
+
+        /* SRCConverter::convert() converts to and from float only in the
+         * double build; in the float build it hands libsamplerate the
+         * caller's buffers */
+        double new_bytes = (sizeof (audio_sample) == sizeof (float)) ? 0 :
+         (sizeof (audio_sample) + sizeof (float)) * CHANNELS * (1 + (double) OUT_RATE / IN_RATE);
+
+        printf ("%-10s before: %6.2f ns/frame, %5.1f bytes copied/frame\n",
+         method.name, old_ns, old_bytes);
+        printf ("%-10s after:  %6.2f ns/frame, %5.1f bytes copied/frame\n",
+         method.name, new_ns, new_bytes);
+    }
+
+    aud_plugin_instance.cleanup ();
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * Test of the Silence Removal trim point analyzer
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Makes up songs of bursts of noise between quiet stretches, with random
+ * settings, and checks that the trim points found by SilenceAnalyzer are
+ * exactly those at which the effect cuts the song when playing it in blocks
+ * of random size.  The plugin is built in as in the Simple DSP Chain test. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <random>
+
+#include <libaudcore/runtime.h>
+
+#include "../../src/silence-removal/scanner.cc"
+#include "../../src/silence-removal/silence-removal.cc"
+
+#define TRIALS 300
+#define MAX_BLOCK 3000 /* frames */
+
+static std::mt19937 rng (1);
+
+/* stretches of up to a second, so that the effect never has to let held back
+ * silence through because its buffer is full */
+static Index<audio_sample> make_song (int channels, int rate, float close_level)
+{
+    std::uniform_real_distribution<float> unit (-1, 1);
+    Index<audio_sample> song;
+
+    int stretches = rng () % 8;
+    for (int s = 0; s < stretches; s ++)
+    {
+        bool loud = (s & 1) == (int) (rng () & 1);
+        int frames = rng () % rate;
+        float amplitude = loud ? 0.5f : close_level * 0.9f;
+
+        for (int i = 0; i < frames * channels; i ++)
+        {
+            /* a quiet stretch sometimes has a click just over the threshold */
+            if (! loud && ! (rng () % 20000))
+                song.append (close_level * 1.1f);
+            else
+                song.append (unit (rng) * amplitude);
+        }
+    }
+
+    return song;
+}
+
+int main ()
+{
+    static const int channel_counts[] = {1, 2, 6};
+    int failures = 0;
+
+    aud_plugin_instance.init ();
+
+    for (int trial = 0; trial < TRIALS; trial ++)
+    {
+        int channels = channel_counts[trial % aud::n_elements (channel_counts)];
+        int rate = 44100;
+
+        aud_set_int ("silence-removal", "threshold", -60 + rng () % 41);
+        aud_set_int ("silence-removal", "hysteresis", rng () % 21);
+        aud_set_int ("silence-removal", "hold", (rng () % 101) * 10);
+        effect_settings_changed ("silence-removal");
+
+        SilenceParams params;
+        SilenceParams::read (params);
+
+        Index<audio_sample> song = make_song (channels, rate, params.close_level);
+
+        SilenceAnalyzer analyzer;
+        analyzer.start (channels, rate, params);
+
+        for (int pos = 0; pos < song.len (); )
+        {
+            int len = aud::min ((int) (1 + rng () % MAX_BLOCK) * channels, song.len () - pos);
+            analyzer.analyze (& song[pos], len);
+            pos += len;
+        }
+
+        /* play the song; what is held back at the end is the trailing silence */
+        int c = channels, r = rate;
+        aud_plugin_instance.start (c, r);
+
+        Index<audio_sample> played;
+
+        for (int pos = 0; pos < song.len (); )
+        {
+            int len = aud::min ((int) (1 + rng () % MAX_BLOCK) * channels, song.len () - pos);
+
+            Index<audio_sample> block;
+            block.insert (& song[pos], 0, len);
+
+            Index<audio_sample> & out = aud_plugin_instance.process (block);
+            played.insert (out.begin (), -1, out.len ());
+            pos += len;
+        }
+
+        int64_t start = analyzer.trim_start (), end = analyzer.trim_end ();
+        bool same;
+
+        if (start < 0)
+            same = ! played.len ();
+        else
+            same = (played.len () == (end - start) * channels && ! memcmp (played.begin (),
+             & song[start * channels], sizeof (audio_sample) * played.len ()));
+
+        if (! same)
+        {
+            printf ("Trial %d: trim points %" PRId64 " to %" PRId64 " of %d frames, "
+             "but the effect played %d frames.\n", trial, start, end,
+             song.len () / channels, played.len () / channels);
+            failures ++;
+        }
+    }
+
+    aud_plugin_instance.cleanup ();
+
+    printf ("%d songs checked, %d failed.\n", TRIALS, failures);
+    return failures ? 1 : 0;
+}
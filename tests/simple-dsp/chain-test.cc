@@ -0,0 +1,223 @@
+/*
+ * Regression test for the Simple DSP Chain plugin
+ * Copyright 2026 Audacious developers
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions, and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the following disclaimer in the documentation
+ *    provided with the distribution.
+ *
+ * This software is provided "as is" and without any warranty, express or
+ * implied. In no event shall the authors be liable for any damages arising from
+ * the use of this software.
+ */
+
+/* Runs random audio through the fused chain and through the separate
+ * Bitcrusher, Crystalizer, Extra Stereo and Voice Removal plugins, with
+ * random settings, stages switched on and off, flushes and block sizes, and
+ * checks that the output is the same sample for sample.
+ *
+ * The plugins are built into this program, each in a namespace of its own so
+ * that their file-scope names do not clash.  The headers they include are
+ * included here first, outside of the namespaces. */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <random>
+#include <utility>
+
+#include <libaudcore/audstrings.h>
+#include <libaudcore/hook.h>
+#include <libaudcore/i18n.h>
+#include <libaudcore/plugin.h>
+#include <libaudcore/preferences.h>
+#include <libaudcore/runtime.h>
+#include <libaudcore/templates.h>
+
+#ifndef DEF_AUDIO_FLOAT64
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+#endif
+
+#include "../../src/effect-common/bitcrush.h"
+#include "../../src/effect-common/params.h"
+#include "../../src/effect-common/smoothing.h"
+
+namespace fused {
+#include "../../src/simple-dsp/simple-dsp.cc"
+}
+
+namespace bitcrusher {
+#include "../../src/bitcrusher/bitcrusher.cc"
+}
+
+namespace crystalizer {
+#include "../../src/crystalizer/crystalizer.cc"
+}
+
+namespace extra_stereo {
+#include "../../src/stereo_plugin/stereo.cc"
+}
+
+namespace voice_removal {
+#include "../../src/voice_removal/voice_removal.cc"
+}
+
+#define TRIALS 400
+#define BLOCKS 20
+#define MAX_BLOCK 700 /* frames */
+
+/* in the order the fused chain runs them */
+static EffectPlugin * const separate[] = {
+    & bitcrusher::aud_plugin_instance,
+    & crystalizer::aud_plugin_instance,
+    & extra_stereo::aud_plugin_instance,
+    & voice_removal::aud_plugin_instance
+};
+
+static const char * const stage_names[] = {
+    "bitcrusher",
+    "crystalizer",
+    "extra_stereo",
+    "voice_removal"
+};
+
+static std::mt19937 rng (1);
+
+static void random_settings ()
+{
+    aud_set_double ("bitcrusher", "depth", 2 + (rng () % 301) / 10.0);
+    aud_set_double ("bitcrusher", "downsample", 0.02 * (1 + rng () % 50));
+    aud_set_double ("crystalizer", "intensity", (rng () % 101) / 10.0);
+    aud_set_double ("extra_stereo", "intensity", (rng () % 101) / 10.0);
+
+    effect_settings_changed ("bitcrusher");
+    effect_settings_changed ("crystalizer");
+    effect_settings_changed ("extra_stereo");
+}
+
+static void set_stage (int stage, bool on)
+{
+    aud_set_bool ("simple_dsp", stage_names[stage], on);
+    effect_settings_changed ("simple_dsp");
+}
+
+int main ()
+{
+    static const int channel_counts[] = {1, 2, 2, 2, 6};
+    std::uniform_real_distribution<float> noise (-1, 1);
+
+    int64_t samples = 0, differ = 0;
+
+    for (int trial = 0; trial < TRIALS; trial ++)
+    {
+        int channels = channel_counts[trial % aud::n_elems (channel_counts)];
+        int rate = 44100;
+
+        fused::aud_plugin_instance.init ();
+        for (EffectPlugin * plugin : separate)
+            plugin->init ();
+
+        random_settings ();
+
+        bool on[aud::n_elems (separate)];
+        for (int stage = 0; stage < aud::n_elems (separate); stage ++)
+            set_stage (stage, (on[stage] = rng () & 1));
+
+        int c = channels, r = rate;
+        fused::aud_plugin_instance.start (c, r);
+
+        for (EffectPlugin * plugin : separate)
+        {
+            c = channels, r = rate;
+            plugin->start (c, r);
+        }
+
+        for (int block = 0; block < BLOCKS; block ++)
+        {
+            int frames = 1 + rng () % MAX_BLOCK;
+
+            Index<audio_sample> a, b;
+            a.insert (0, frames * channels);
+
+            for (audio_sample & x : a)
+                x = noise (rng);
+
+            b.insert (a.begin (), 0, a.len ());
+
+            Index<audio_sample> * out_a = & a;
+            for (int stage = 0; stage < aud::n_elems (separate); stage ++)
+            {
+                if (on[stage])
+                    out_a = & separate[stage]->process (* out_a);
+            }
+
+            Index<audio_sample> & out_b = fused::aud_plugin_instance.process (b);
+
+            if (out_a->len () != out_b.len ())
+            {
+                printf ("Trial %d, block %d: %d samples out of the chain, %d "
+                 "out of the separate plugins.\n", trial, block, out_b.len (),
+                 out_a->len ());
+                return 1;
+            }
+
+            for (int i = 0; i < out_b.len (); i ++)
+            {
+                if (memcmp (& (* out_a)[i], & out_b[i], sizeof (audio_sample)))
+                    differ ++;
+            }
+
+            samples += out_b.len ();
+
+            switch (rng () % 6)
+            {
+            case 0:
+                random_settings ();
+                break;
+
+            case 1:
+            {
+                /* a plugin switched on starts afresh, as the core would do */
+                int stage = rng () % aud::n_elems (separate);
+                on[stage] = ! on[stage];
+
+                if (on[stage])
+                {
+                    c = channels, r = rate;
+                    separate[stage]->start (c, r);
+                }
+
+                set_stage (stage, on[stage]);
+                break;
+            }
+
+            case 2:
+                fused::aud_plugin_instance.flush (true);
+                for (EffectPlugin * plugin : separate)
+                    plugin->flush (true);
+                break;
+            }
+        }
+
+        fused::aud_plugin_instance.cleanup ();
+        for (EffectPlugin * plugin : separate)
+            plugin->cleanup ();
+    }
+
+    printf ("%" PRId64 " samples compared, %" PRId64 " differ.\n", samples, differ);
+    return differ ? 1 : 0;
+}